@@ -0,0 +1,60 @@
+#include "benchmark/benchmark.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO.h"
+
+using namespace llvm;
+
+// Build a module with state.range(0) internal functions. Every function has
+// the same opcode sequence, but they are spread over state.range(1) distinct
+// integer widths, so they only merge within groups of the same width.
+static std::string makeModule(unsigned NumFuncs, unsigned NumWidths) {
+  std::string IR;
+  raw_string_ostream OS(IR);
+  for (unsigned I = 0; I != NumFuncs; ++I) {
+    unsigned Width = 8 + I % NumWidths;
+    OS << "define internal i" << Width << " @f" << I << "(i" << Width
+       << " %a, i" << Width << " %b) {\n"
+       << "entry:\n"
+       << "  %c = icmp ult i" << Width << " %a, %b\n"
+       << "  br i1 %c, label %t, label %f\n"
+       << "t:\n"
+       << "  %x = add i" << Width << " %a, %b\n"
+       << "  ret i" << Width << " %x\n"
+       << "f:\n"
+       << "  %y = mul i" << Width << " %a, %b\n"
+       << "  ret i" << Width << " %y\n"
+       << "}\n"
+       << "define i" << Width << " @use" << I << "(i" << Width << " %a) {\n"
+       << "  %r = call i" << Width << " @f" << I << "(i" << Width
+       << " %a, i" << Width << " %a)\n"
+       << "  ret i" << Width << " %r\n"
+       << "}\n";
+  }
+  return OS.str();
+}
+
+static void BM_MergeFunctions(benchmark::State &State) {
+  std::string IR = makeModule(State.range(0), State.range(1));
+  for (auto _ : State) {
+    State.PauseTiming();
+    LLVMContext Ctx;
+    SMDiagnostic Err;
+    std::unique_ptr<Module> M = parseAssemblyString(IR, Err, Ctx);
+    legacy::PassManager PM;
+    PM.add(createMergeFunctionsPass());
+    State.ResumeTiming();
+    PM.run(*M);
+  }
+}
+BENCHMARK(BM_MergeFunctions)
+    ->Args({1000, 1})
+    ->Args({1000, 16})
+    ->Args({10000, 16})
+    ->Args({10000, 64});
+
+BENCHMARK_MAIN();
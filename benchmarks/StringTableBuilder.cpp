@@ -0,0 +1,43 @@
+#include "benchmark/benchmark.h"
+#include "llvm/MC/StringTableBuilder.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Make state.range(0) strings that look like mangled names: long, sharing
+// prefixes and a few common suffixes, with some strings suffixes of others.
+static std::vector<std::string> makeStrings(unsigned NumStrings) {
+  static const char *const Suffixes[] = {"Ev", "EPKcm", "ERKNS_9StringRefE",
+                                         "Ej", "v"};
+  std::vector<std::string> Strings;
+  for (unsigned I = 0; Strings.size() < NumStrings; ++I) {
+    std::string S = "_ZN4llvm" + std::to_string(I * 2654435761u) + "Builder" +
+                    std::to_string(I % 97) + Suffixes[I % 5];
+    Strings.push_back(S);
+    if (I % 4 == 0)
+      Strings.push_back(S.substr(S.size() / 2));
+  }
+  Strings.resize(NumStrings);
+  return Strings;
+}
+
+static void BM_StringTableFinalize(benchmark::State &State) {
+  std::vector<std::string> Strings = makeStrings(State.range(0));
+  for (auto _ : State) {
+    State.PauseTiming();
+    StringTableBuilder B(StringTableBuilder::ELF);
+    for (const std::string &S : Strings)
+      B.add(S);
+    State.ResumeTiming();
+    B.finalize();
+    benchmark::DoNotOptimize(B.getSize());
+  }
+}
+BENCHMARK(BM_StringTableFinalize)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
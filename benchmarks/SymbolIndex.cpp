@@ -0,0 +1,151 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/DebugInfo/Symbolize/SymbolIndex.h"
+#include "llvm/DebugInfo/Symbolize/Symbolize.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace symbolize;
+
+// Compares symbolizing addresses of the binary named by
+// $SYMBOL_INDEX_BENCHMARK_BINARY from its DWARF with doing so from its index.
+// "Cold" runs load the module again for every batch of lookups.
+
+namespace {
+
+struct Inputs {
+  std::string Path;
+  std::string Index;
+  std::vector<uint64_t> Addresses;
+};
+
+const Inputs *getInputs() {
+  static Inputs *I = [] {
+    const char *Path = std::getenv("SYMBOL_INDEX_BENCHMARK_BINARY");
+    if (!Path)
+      return static_cast<Inputs *>(nullptr);
+    auto I = llvm::make_unique<Inputs>();
+    I->Path = Path;
+    raw_string_ostream OS(I->Index);
+    LLVMSymbolizer Symbolizer;
+    if (Error E = Symbolizer.writeSymbolIndex(Path, OS)) {
+      consumeError(std::move(E));
+      return static_cast<Inputs *>(nullptr);
+    }
+    OS.flush();
+
+    // Sample addresses from the text sections.
+    auto ObjOrErr = object::ObjectFile::createObjectFile(Path);
+    if (!ObjOrErr) {
+      consumeError(ObjOrErr.takeError());
+      return static_cast<Inputs *>(nullptr);
+    }
+    std::mt19937_64 Gen(0);
+    for (const object::SectionRef &Sec : ObjOrErr->getBinary()->sections()) {
+      if (!Sec.isText() || Sec.getSize() == 0)
+        continue;
+      std::uniform_int_distribution<uint64_t> Dist(
+          Sec.getAddress(), Sec.getAddress() + Sec.getSize() - 1);
+      for (unsigned N = 0; N < 1000; ++N)
+        I->Addresses.push_back(Dist(Gen));
+    }
+    return I.release();
+  }();
+  return I;
+}
+
+LLVMSymbolizer::Options getOptions(bool UseSymbolIndex) {
+  LLVMSymbolizer::Options Opts;
+  Opts.Demangle = false;
+  Opts.UseSymbolIndex = UseSymbolIndex;
+  return Opts;
+}
+
+void lookUpAll(const Inputs &I, LLVMSymbolizer &Symbolizer) {
+  for (uint64_t Address : I.Addresses) {
+    auto ResOrErr = Symbolizer.symbolizeInlinedCode(
+        I.Path, {Address, object::SectionedAddress::UndefSection});
+    if (!ResOrErr)
+      consumeError(ResOrErr.takeError());
+    else
+      benchmark::DoNotOptimize(ResOrErr->getNumberOfFrames());
+  }
+}
+
+void lookUpAll(const Inputs &I, const SymbolIndex &Index) {
+  for (uint64_t Address : I.Addresses)
+    benchmark::DoNotOptimize(
+        Index
+            .symbolizeInlinedCode(
+                {Address, object::SectionedAddress::UndefSection},
+                FunctionNameKind::LinkageName, true)
+            .getNumberOfFrames());
+}
+
+std::unique_ptr<SymbolIndex> loadIndex(const Inputs &I) {
+  return cantFail(SymbolIndex::create(MemoryBuffer::getMemBuffer(
+      I.Index, "", /*RequiresNullTerminator=*/false)));
+}
+
+} // end anonymous namespace
+
+static void BM_DWARFCold(benchmark::State &State) {
+  const Inputs *I = getInputs();
+  if (!I) {
+    State.SkipWithError("SYMBOL_INDEX_BENCHMARK_BINARY is not set or invalid");
+    return;
+  }
+  for (auto _ : State) {
+    LLVMSymbolizer Symbolizer(getOptions(false));
+    lookUpAll(*I, Symbolizer);
+  }
+  State.SetItemsProcessed(State.iterations() * I->Addresses.size());
+}
+BENCHMARK(BM_DWARFCold)->Unit(benchmark::kMillisecond);
+
+static void BM_IndexCold(benchmark::State &State) {
+  const Inputs *I = getInputs();
+  if (!I) {
+    State.SkipWithError("SYMBOL_INDEX_BENCHMARK_BINARY is not set or invalid");
+    return;
+  }
+  for (auto _ : State)
+    lookUpAll(*I, *loadIndex(*I));
+  State.SetItemsProcessed(State.iterations() * I->Addresses.size());
+}
+BENCHMARK(BM_IndexCold)->Unit(benchmark::kMillisecond);
+
+static void BM_DWARFWarm(benchmark::State &State) {
+  const Inputs *I = getInputs();
+  if (!I) {
+    State.SkipWithError("SYMBOL_INDEX_BENCHMARK_BINARY is not set or invalid");
+    return;
+  }
+  LLVMSymbolizer Symbolizer(getOptions(false));
+  lookUpAll(*I, Symbolizer);
+  for (auto _ : State)
+    lookUpAll(*I, Symbolizer);
+  State.SetItemsProcessed(State.iterations() * I->Addresses.size());
+}
+BENCHMARK(BM_DWARFWarm)->Unit(benchmark::kMillisecond);
+
+static void BM_IndexWarm(benchmark::State &State) {
+  const Inputs *I = getInputs();
+  if (!I) {
+    State.SkipWithError("SYMBOL_INDEX_BENCHMARK_BINARY is not set or invalid");
+    return;
+  }
+  std::unique_ptr<SymbolIndex> Index = loadIndex(*I);
+  for (auto _ : State)
+    lookUpAll(*I, *Index);
+  State.SetItemsProcessed(State.iterations() * I->Addresses.size());
+}
+BENCHMARK(BM_IndexWarm)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
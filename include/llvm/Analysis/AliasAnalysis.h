@@ -303,7 +303,12 @@ public:
   using IsCapturedCacheT = SmallDenseMap<const Value *, bool, 8>;
   IsCapturedCacheT IsCapturedCache;
 
-  AAQueryInfo() : AliasCache(), IsCapturedCache() {}
+  /// Underlying objects found by BasicAA's bounded use-def walk, keyed by the
+  /// (already stripped) pointer the walk started from.
+  using UnderlyingObjectCacheT = SmallDenseMap<const Value *, const Value *, 8>;
+  UnderlyingObjectCacheT UnderlyingObjectCache;
+
+  AAQueryInfo() : AliasCache(), IsCapturedCache(), UnderlyingObjectCache() {}
 };
 
 class BatchAAResults;
@@ -163,6 +163,14 @@ private:
   /// Tracks instructions visited by pointsToConstantMemory.
   SmallPtrSet<const Value *, 16> Visited;
 
+  /// Decompositions computed by DecomposeGEPExpression during the current
+  /// top-level query, paired with whether the search limit was reached.
+  /// Recursion through phis and selects decomposes the same GEP once per
+  /// incoming value, so this avoids repeating the walk. It is cleared along
+  /// with VisitedPhiBBs, as the IR may change between top-level queries.
+  SmallDenseMap<const Value *, std::pair<DecomposedGEP, bool>, 4>
+      DecomposedGEPCache;
+
   static const Value *
   GetLinearExpression(const Value *V, APInt &Scale, APInt &Offset,
                       unsigned &ZExtBits, unsigned &SExtBits,
@@ -172,6 +180,14 @@ private:
   static bool DecomposeGEPExpression(const Value *V, DecomposedGEP &Decomposed,
       const DataLayout &DL, AssumptionCache *AC, DominatorTree *DT);
 
+  /// Like DecomposeGEPExpression, but reuses the result of an earlier
+  /// decomposition of \p V in the current query when there is one.
+  bool decomposeGEPExpressionCached(const Value *V, DecomposedGEP &Decomposed);
+
+  /// Returns GetUnderlyingObject(V) with the search depth BasicAA relies on,
+  /// memoized in \p AAQI.
+  const Value *getUnderlyingObjectCached(const Value *V, AAQueryInfo &AAQI);
+
   static bool isGEPBaseAtNegativeOffset(const GEPOperator *GEPOp,
       const DecomposedGEP &DecompGEP, const DecomposedGEP &DecompObject,
       LocationSize ObjectAccessSize);
@@ -124,6 +124,8 @@ public:
 private:
   MCSymbol *CurrentFnBegin = nullptr;
   MCSymbol *CurrentFnEnd = nullptr;
+  MCSymbol *CurrentFnColdBegin = nullptr;
+  MCSymbol *CurrentFnColdEnd = nullptr;
   MCSymbol *CurExceptionSym = nullptr;
 
   // The garbage collection metadata printer table.
@@ -207,6 +209,12 @@ public:
 
   MCSymbol *getFunctionBegin() const { return CurrentFnBegin; }
   MCSymbol *getFunctionEnd() const { return CurrentFnEnd; }
+
+  /// Return the bounds of the cold part of the current function, or null if
+  /// the function is not split. When the function is split, getFunctionEnd()
+  /// returns the end of the hot part.
+  MCSymbol *getFunctionColdBegin() const { return CurrentFnColdBegin; }
+  MCSymbol *getFunctionColdEnd() const { return CurrentFnColdEnd; }
   MCSymbol *getCurExceptionSym();
 
   /// Return information about object file lowering.
@@ -630,6 +638,10 @@ private:
   /// This method emits the header for the current function.
   virtual void EmitFunctionHeader();
 
+  /// End the hot part of the current function and continue in its cold
+  /// section, starting with \p MBB.
+  void emitColdSectionStart(const MachineBasicBlock &MBB);
+
   /// Emit a blob of inline asm to the output streamer.
   void
   EmitInlineAsm(StringRef Str, const MCSubtargetInfo &STI,
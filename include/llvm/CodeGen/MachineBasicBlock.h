@@ -129,6 +129,10 @@ private:
   /// Indicate that this basic block is the entry block of a cleanup funclet.
   bool IsCleanupFuncletEntry = false;
 
+  /// Indicate that this basic block is emitted in the cold section of its
+  /// function rather than with the function entry.
+  bool IsColdSection = false;
+
   /// since getSymbol is a relatively heavy-weight operation, the symbol
   /// is only computed once and is cached.
   mutable MCSymbol *CachedMCSymbol = nullptr;
@@ -410,6 +414,13 @@ public:
   /// Indicates if this is the entry block of a cleanup funclet.
   void setIsCleanupFuncletEntry(bool V = true) { IsCleanupFuncletEntry = V; }
 
+  /// Returns true if this block is emitted in the cold section of its
+  /// function. Cold blocks are laid out after all the other blocks.
+  bool isColdSection() const { return IsColdSection; }
+
+  /// Indicates if this block is emitted in the cold section of its function.
+  void setIsColdSection(bool V = true) { IsColdSection = V; }
+
   /// Returns true if it is legal to hoist instructions into this block.
   bool isLegalToHoistInto() const;
 
@@ -431,6 +431,10 @@ public:
   /// Return true if this DAG supports VReg liveness and RegPressure.
   bool hasVRegLiveness() const override { return true; }
 
+  /// Liveness is exact at any instruction, so splitting a large region does
+  /// not make its register pressure tracking less precise.
+  bool canSplitSchedRegions() const override { return true; }
+
   /// Return true if register pressure tracking is enabled.
   bool isTrackingPressure() const { return ShouldTrackPressure; }
 
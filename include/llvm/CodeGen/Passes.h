@@ -303,6 +303,10 @@ namespace llvm {
   /// This pass lays out funclets contiguously.
   extern char &FuncletLayoutID;
 
+  /// MachineFunctionSplitter - This pass moves the cold blocks of functions
+  /// with profile data to a separate section.
+  extern char &MachineFunctionSplitterID;
+
   /// This pass inserts the XRay instrumentation sleds if they are supported by
   /// the target platform.
   extern char &XRayInstrumentationID;
@@ -0,0 +1,88 @@
+//===- llvm/CodeGen/RegAllocAdvisor.h - Greedy allocator policy -*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The abstract base class RegAllocAdvisor makes the policy decisions of the
+// greedy register allocator: which live ranges may evict each other, and in
+// which order live ranges are dequeued. The allocator keeps the decisions that
+// guarantee correctness and termination, such as eviction cascades, and asks
+// the advisor for the rest.
+//
+// Alternative advisors, e.g. a model trained offline from decisions logged
+// with -regalloc-eviction-log, are registered in RegAllocAdvisorRegistry and
+// selected with -regalloc-advisor=<name>.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_REGALLOCADVISOR_H
+#define LLVM_CODEGEN_REGALLOCADVISOR_H
+
+#include "llvm/Support/Registry.h"
+#include <memory>
+
+namespace llvm {
+
+class LiveInterval;
+class MachineFunction;
+class RegAllocAdvisor;
+
+/// RegAllocAdvisorRegistry - The register allocation advisor registry uses all
+/// the defaults from Registry.
+using RegAllocAdvisorRegistry = Registry<RegAllocAdvisor>;
+
+/// An eviction the greedy allocator is considering: VirtReg is about to be
+/// assigned to a register currently held by Evictee.
+struct EvictionQuery {
+  const LiveInterval &VirtReg;
+  const LiveInterval &Evictee;
+  /// True when the register is VirtReg's preferred register.
+  bool IsHint;
+  /// True when Evictee is assigned to its preferred register.
+  bool BreaksHint;
+  /// True when Evictee may still be split instead of spilled.
+  bool CanSplitEvictee;
+};
+
+/// A live range about to be queued for assignment.
+struct PriorityQuery {
+  const LiveInterval &VirtReg;
+  /// True when the live range is contained in a single basic block.
+  bool IsLocal;
+  /// True when the live range has a known physical register preference.
+  bool HasHint;
+  /// The priority computed by the default policy. Live ranges are dequeued
+  /// in decreasing priority order.
+  unsigned DefaultPriority;
+};
+
+/// RegAllocAdvisor - Policy decisions of the greedy register allocator.
+class RegAllocAdvisor {
+public:
+  virtual ~RegAllocAdvisor();
+
+  /// Called before allocating \p MF. An advisor may fall back to the default
+  /// policy for functions it does not handle.
+  virtual void initialize(const MachineFunction &MF) {}
+
+  /// Return true if Q.Evictee should be evicted so that Q.VirtReg can be
+  /// assigned. Urgent evictions of unspillable ranges are not queried.
+  virtual bool shouldEvict(const EvictionQuery &Q);
+
+  /// Return the priority of a live range that is queued for the first time or
+  /// requeued for assignment. Split and spill products keep their priority.
+  virtual unsigned getPriority(const PriorityQuery &Q) {
+    return Q.DefaultPriority;
+  }
+};
+
+/// Create the advisor selected by -regalloc-advisor. The default advisor
+/// implements the allocator's historical policy.
+std::unique_ptr<RegAllocAdvisor> createRegAllocAdvisor();
+
+} // end namespace llvm
+
+#endif // LLVM_CODEGEN_REGALLOCADVISOR_H
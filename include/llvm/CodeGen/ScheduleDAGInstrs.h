@@ -284,6 +284,12 @@ namespace llvm {
     /// beginning with the topmost region of MBB.
     virtual bool doMBBSchedRegionsTopDown() const { return false; }
 
+    /// If this method returns true, a scheduling region that is too large may
+    /// be split into several regions at instructions that are not scheduling
+    /// boundaries. Each part is scheduled separately, with the first
+    /// instruction of the part below it acting as its boundary.
+    virtual bool canSplitSchedRegions() const { return false; }
+
     /// Prepares to perform scheduling in the given block.
     virtual void startBlock(MachineBasicBlock *BB);
 
@@ -15,6 +15,7 @@
 #ifndef LLVM_CODEGEN_SELECTIONDAGTARGETINFO_H
 #define LLVM_CODEGEN_SELECTIONDAGTARGETINFO_H
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/CodeGen/MachineMemOperand.h"
 #include "llvm/CodeGen/SelectionDAGNodes.h"
 #include "llvm/Support/CodeGen.h"
@@ -24,6 +25,18 @@ namespace llvm {
 
 class SelectionDAG;
 
+/// The distribution of the size operand of a memory intrinsic, as recorded by
+/// its value profile. Sizes that were profiled as part of a range are
+/// represented by the smallest size in the range.
+struct MemOpSizeProfile {
+  /// The number of profiled executions of the intrinsic.
+  uint64_t TotalCount = 0;
+
+  /// The profiled sizes and their execution counts, most frequent first. The
+  /// counts may add up to less than TotalCount.
+  SmallVector<std::pair<uint64_t, uint64_t>, 8> Sizes;
+};
+
 //===----------------------------------------------------------------------===//
 /// Targets can subclass this to parameterize the
 /// SelectionDAG lowering and instruction selection process.
@@ -58,6 +71,18 @@ public:
     return SDValue();
   }
 
+  /// Emit target-specific code that performs a memcpy of a non-constant size,
+  /// given the sizes it was called with in a profiling run. This function can
+  /// return a null SDValue if the target declines to use custom code, in which
+  /// case the memcpy is lowered as if it had no profile.
+  virtual SDValue EmitTargetCodeForProfiledMemcpy(
+      SelectionDAG &DAG, const SDLoc &dl, SDValue Chain, SDValue Op1,
+      SDValue Op2, SDValue Op3, const MemOpSizeProfile &Profile,
+      unsigned Align, bool isVolatile, MachinePointerInfo DstPtrInfo,
+      MachinePointerInfo SrcPtrInfo) const {
+    return SDValue();
+  }
+
   /// Emit target-specific code that performs a memmove.
   /// This can be used by targets to provide code sequences for cases
   /// that don't fit the target's parameters for simple loads/stores and can be
@@ -85,6 +110,17 @@ public:
     return SDValue();
   }
 
+  /// Emit target-specific code that performs a memset of a non-constant size,
+  /// given the sizes it was called with in a profiling run. This function can
+  /// return a null SDValue if the target declines to use custom code, in which
+  /// case the memset is lowered as if it had no profile.
+  virtual SDValue EmitTargetCodeForProfiledMemset(
+      SelectionDAG &DAG, const SDLoc &dl, SDValue Chain, SDValue Op1,
+      SDValue Op2, SDValue Op3, const MemOpSizeProfile &Profile,
+      unsigned Align, bool isVolatile, MachinePointerInfo DstPtrInfo) const {
+    return SDValue();
+  }
+
   /// Emit target-specific code that performs a memcmp, in cases where that is
   /// faster than a libcall. The first returned SDValue is the result of the
   /// memcmp and the second is the chain. Both SDValues can be null if a normal
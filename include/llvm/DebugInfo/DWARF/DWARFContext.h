@@ -36,10 +36,13 @@
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/Threading.h"
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
 
 namespace llvm {
 
@@ -55,6 +58,10 @@ enum class ErrorPolicy { Halt, Continue };
 /// DWARFContext
 /// This data structure is the top level entity that deals with dwarf debug
 /// information parsing. The actual data is supplied through DWARFObj.
+///
+/// The sections are parsed lazily, the first time they are asked for, and the
+/// units extract their DIEs the first time they are walked. Both are safe to
+/// do from several threads at once, so a context can be queried concurrently.
 class DWARFContext : public DIContext {
   DWARFUnitVector NormalUnits;
   std::unique_ptr<DWARFUnitIndex> CUIndex;
@@ -77,13 +84,26 @@ class DWARFContext : public DIContext {
   std::unique_ptr<DWARFDebugAbbrev> AbbrevDWO;
   std::unique_ptr<DWARFDebugLoclists> LocDWO;
 
+  /// Each of the lazily parsed members above is created under its own flag.
+  /// \{
+  llvm::once_flag NormalUnitsOnce, CUIndexOnce, GdbIndexOnce, TUIndexOnce,
+      AbbrevOnce, LocOnce, ArangesOnce, LineOnce, DebugFrameOnce, EHFrameOnce,
+      MacroOnce, NamesOnce, AppleNamesOnce, AppleTypesOnce,
+      AppleNamespacesOnce, AppleObjCOnce, AbbrevDWOOnce, LocDWOOnce;
+  /// \}
+  /// Guards the parsing of DWOUnits, which a lazy parse leaves empty so that
+  /// a later full parse still reads all units.
+  std::mutex DWOUnitsMutex;
+
   /// The maximum DWARF version of all units.
-  unsigned MaxVersion = 0;
+  std::atomic<unsigned> MaxVersion{0};
 
   struct DWOFile {
     object::OwningBinary<object::ObjectFile> File;
     std::unique_ptr<DWARFContext> Context;
   };
+  /// Guards DWOFiles, DWP and CheckedForDWP.
+  std::mutex DWOFilesMutex;
   StringMap<std::weak_ptr<DWOFile>> DWOFiles;
   std::weak_ptr<DWOFile> DWP;
   bool CheckedForDWP = false;
@@ -129,7 +149,13 @@ public:
     dump(OS, DumpOpts, DumpOffsets);
   }
 
-  bool verify(raw_ostream &OS, DIDumpOptions DumpOpts = {}) override;
+  bool verify(raw_ostream &OS, DIDumpOptions DumpOpts = {}) override {
+    return verify(OS, DumpOpts, 1);
+  }
+
+  /// Verifies the debug info, checking the units of the .debug_info and
+  /// .debug_types sections on \p NumThreads threads.
+  bool verify(raw_ostream &OS, DIDumpOptions DumpOpts, unsigned NumThreads);
 
   using unit_iterator_range = DWARFUnitVector::iterator_range;
 
@@ -243,8 +269,9 @@ public:
   }
 
   void setMaxVersionIfGreater(unsigned Version) {
-    if (Version > MaxVersion)
-      MaxVersion = Version;
+    unsigned Max = MaxVersion;
+    while (Version > Max && !MaxVersion.compare_exchange_weak(Max, Version))
+      ;
   }
 
   const DWARFUnitIndex &getCUIndex();
@@ -13,6 +13,7 @@
 #include "llvm/Support/DataExtractor.h"
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <vector>
 
 namespace llvm {
@@ -55,6 +56,9 @@ class DWARFDebugAbbrev {
   using DWARFAbbreviationDeclarationSetMap =
       std::map<uint64_t, DWARFAbbreviationDeclarationSet>;
 
+  /// Guards the sets parsed on demand, so that units can look theirs up
+  /// concurrently. Once parse() has run, the map no longer changes.
+  mutable std::mutex Mutex;
   mutable DWARFAbbreviationDeclarationSetMap AbbrDeclSets;
   mutable DWARFAbbreviationDeclarationSetMap::const_iterator PrevAbbrOffsetPos;
   mutable Optional<DataExtractor> Data;
@@ -10,6 +10,7 @@
 #define LLVM_DEBUGINFO_DWARFDEBUGARANGES_H
 
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/DataExtractor.h"
 #include <cstdint>
 #include <vector>
@@ -22,6 +23,12 @@ class DWARFDebugAranges {
 public:
   void generate(DWARFContext *CTX);
   uint32_t findAddress(uint64_t Address) const;
+  /// Calls \p Fn, in address order, with each part of [LowPC, HighPC) that is
+  /// described by a single compile unit, and the offset of that unit.
+  void forEachUnitInRange(
+      uint64_t LowPC, uint64_t HighPC,
+      function_ref<void(uint32_t CUOffset, uint64_t LowPC, uint64_t HighPC)> Fn)
+      const;
 
 private:
   void clear();
@@ -20,6 +20,7 @@
 #include "llvm/Support/MD5.h"
 #include <cstdint>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -237,11 +238,19 @@ public:
     /// or UnknownRowIndex if there is no such row.
     uint32_t lookupAddress(object::SectionedAddress Address) const;
 
+    /// Fills Result with the indices of the rows describing the range
+    /// [Address, Address + Size), which does not need to start inside of a
+    /// sequence. Returns false if no sequence overlaps the range.
     bool lookupAddressRange(object::SectionedAddress Address, uint64_t Size,
                             std::vector<uint32_t> &Result) const;
 
     bool hasFileAtIndex(uint64_t FileIndex) const;
 
+    /// Returns the embedded source of the file at \p FileIndex, if any.
+    Optional<StringRef>
+    getSourceByIndex(uint64_t FileIndex,
+                     DILineInfoSpecifier::FileLineInfoKind Kind) const;
+
     /// Extracts filename by its index in filename table in prologue.
     /// In Dwarf 4, the files are 1-indexed and the current compilation file
     /// name is not represented in the list. In DWARF v5, the files are
@@ -282,9 +291,6 @@ public:
     getFileNameEntry(uint64_t Index) const;
     uint32_t findRowInSeq(const DWARFDebugLine::Sequence &Seq,
                           object::SectionedAddress Address) const;
-    Optional<StringRef>
-    getSourceByIndex(uint64_t FileIndex,
-                     DILineInfoSpecifier::FileLineInfoKind Kind) const;
 
     uint32_t lookupAddressImpl(object::SectionedAddress Address) const;
 
@@ -368,6 +374,9 @@ private:
   using LineTableIter = LineTableMapTy::iterator;
   using LineTableConstIter = LineTableMapTy::const_iterator;
 
+  /// Guards LineTableMap. A table is parsed with the lock held, so that
+  /// concurrent lookups of it wait for it to be complete.
+  mutable std::mutex LineTableMutex;
   LineTableMapTy LineTableMap;
 };
 
@@ -25,11 +25,13 @@
 #include "llvm/DebugInfo/DWARF/DWARFUnitIndex.h"
 #include "llvm/Support/DataExtractor.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -106,12 +108,18 @@ const DWARFUnitIndex &getDWARFUnitIndex(DWARFContext &Context,
 
 /// Describe a collection of units. Intended to hold all units either from
 /// .debug_info and .debug_types, or from .debug_info.dwo and .debug_types.dwo.
+///
+/// The lookups can run concurrently, including the ones that parse a unit of
+/// a lazily read .dwp index, but they must not run while the vector is being
+/// iterated over or filled.
 class DWARFUnitVector final : public SmallVector<std::unique_ptr<DWARFUnit>, 1> {
   std::function<std::unique_ptr<DWARFUnit>(uint32_t, DWARFSectionKind,
                                            const DWARFSection *,
                                            const DWARFUnitIndex::Entry *)>
       Parser;
   int NumInfoUnits = -1;
+  /// Guards the units parsed by getUnitForIndexEntry().
+  mutable std::mutex LookupMutex;
 
 public:
   using UnitVector = SmallVectorImpl<std::unique_ptr<DWARFUnit>>;
@@ -216,8 +224,21 @@ class DWARFUnit {
   /// A table of range lists (DWARF v5 and later).
   Optional<DWARFDebugRnglistTable> RngListTable;
 
-  mutable const DWARFAbbreviationDeclarationSet *Abbrevs;
+  mutable std::atomic<const DWARFAbbreviationDeclarationSet *> Abbrevs;
   llvm::Optional<object::SectionedAddress> BaseAddr;
+
+  /// How far extractDIEsIfNeeded() got. DieArray is only written while the
+  /// state is not AllDIEs, and readers check for AllDIEs before reading it,
+  /// so that concurrent readers of a unit only ever see it fully extracted.
+  enum ExtractionState : uint8_t { NoDIEs, UnitDIEOnly, AllDIEs };
+  std::atomic<ExtractionState> Extracted{NoDIEs};
+  /// Serializes the lazy parsing of the unit: the extraction of its DIEs, its
+  /// base address, the address to DIE map and the split unit.
+  std::recursive_mutex Mutex;
+  /// The unit DIE, valid unless the state is NoDIEs. DWARFDies returned while
+  /// it was the only DIE extracted point to it, so it outlives the extraction
+  /// of the other DIEs.
+  DWARFDebugInfoEntry UnitDieEntry;
   /// The compile unit debug information entry items.
   std::vector<DWARFDebugInfoEntry> DieArray;
 
@@ -232,6 +253,8 @@ class DWARFUnit {
   std::shared_ptr<DWARFUnit> DWO;
 
   uint32_t getDIEIndex(const DWARFDebugInfoEntry *Die) {
+    if (Die == &UnitDieEntry)
+      return 0;
     auto First = DieArray.data();
     assert(Die >= First && Die < First + DieArray.size());
     return Die - First;
@@ -247,7 +270,8 @@ protected:
   /// length and form. The given offset is expected to be derived from the unit
   /// DIE's DW_AT_str_offsets_base attribute.
   Optional<StrOffsetsContributionDescriptor>
-  determineStringOffsetsTableContribution(DWARFDataExtractor &DA);
+  determineStringOffsetsTableContribution(DWARFDataExtractor &DA,
+                                          uint64_t Offset);
 
   /// Find the unit's contribution to the string offsets table and determine its
   /// length and form. The given offset is expected to be 0 in a dwo file or,
@@ -380,9 +404,15 @@ public:
 
   DWARFDie getUnitDIE(bool ExtractUnitDIEOnly = true) {
     extractDIEsIfNeeded(ExtractUnitDIEOnly);
-    if (DieArray.empty())
+    switch (Extracted.load(std::memory_order_acquire)) {
+    case NoDIEs:
       return DWARFDie();
-    return DWARFDie(this, &DieArray[0]);
+    case UnitDIEOnly:
+      return DWARFDie(this, &UnitDieEntry);
+    case AllDIEs:
+      return DWARFDie(this, &DieArray[0]);
+    }
+    llvm_unreachable("Invalid ExtractionState.");
   }
 
   const char *getCompilationDir();
@@ -491,13 +521,19 @@ private:
 
   /// extractDIEsIfNeeded - Parses a compile unit and indexes its DIEs if it
   /// hasn't already been done. Returns the number of DIEs parsed at this call.
+  /// Several threads may call it at once.
   size_t extractDIEsIfNeeded(bool CUDieOnly);
 
+  /// Reads the unit attributes that the rest of the parsing depends on from
+  /// the freshly extracted unit DIE \p Die.
+  void readUnitDIEAttributes(const DWARFDebugInfoEntry &Die);
+
   /// extractDIEsToVector - Appends all parsed DIEs to a vector.
   void extractDIEsToVector(bool AppendCUDie, bool AppendNonCUDIEs,
                            std::vector<DWARFDebugInfoEntry> &DIEs) const;
 
-  /// clearDIEs - Clear parsed DIEs to keep memory usage low.
+  /// clearDIEs - Clear parsed DIEs to keep memory usage low. This must not
+  /// run concurrently with any other use of the unit.
   void clearDIEs(bool KeepCUDie);
 
   /// parseDWO - Parses .dwo file for current compile unit. Returns true if
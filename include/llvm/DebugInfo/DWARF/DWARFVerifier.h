@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <map>
 #include <set>
+#include <string>
 
 namespace llvm {
 class raw_ostream;
@@ -99,6 +100,15 @@ private:
   // Used to relax some checks that do not currently work portably
   bool IsObjectFile;
   bool IsMachOObject;
+  /// The number of threads the units of a section are verified with.
+  unsigned NumThreads;
+
+  /// A unit collected for verification by verifyUnitsInParallel, and the
+  /// report on its header.
+  struct PendingUnit {
+    std::string Report;
+    DWARFUnit *Unit = nullptr;
+  };
 
   raw_ostream &error() const;
   raw_ostream &warn() const;
@@ -168,6 +178,18 @@ private:
   unsigned verifyUnitSection(const DWARFSection &S,
                              DWARFSectionKind SectionKind);
 
+  /// Verifies the contents of \p Units on NumThreads threads.
+  ///
+  /// Each unit is verified by a separate verifier writing to a buffer, and
+  /// the buffers are appended to the output in order, after the reports on
+  /// the unit headers, so the output is the same as that of a sequential run.
+  /// The DIEs of all the units and the sections that their verification
+  /// parses lazily are extracted before, so the verifiers only read shared
+  /// state.
+  ///
+  /// \returns The number of errors that occurred during verification.
+  unsigned verifyUnitsInParallel(MutableArrayRef<PendingUnit> Units);
+
   /// Verifies that a call site entry is nested within a subprogram with a
   /// DW_AT_call attribute.
   ///
@@ -288,7 +310,8 @@ private:
 
 public:
   DWARFVerifier(raw_ostream &S, DWARFContext &D,
-                DIDumpOptions DumpOpts = DIDumpOptions::getForSingleDIE());
+                DIDumpOptions DumpOpts = DIDumpOptions::getForSingleDIE(),
+                unsigned NumThreads = 1);
 
   /// Verify the information in any of the following sections, if available:
   /// .debug_abbrev, debug_abbrev.dwo
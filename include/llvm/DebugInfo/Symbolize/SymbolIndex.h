@@ -0,0 +1,211 @@
+//===- SymbolIndex.h --------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a precomputed, memory-mappable index of the symbolization
+// results of a module, and the builder that writes it.
+//
+// Symbolizing an address with DWARF requires parsing the unit that contains
+// it, its line table and its subroutine DIEs. The index stores the answers
+// instead: a sorted array of addresses, each mapped to the innermost frame of
+// its inlining chain, the frames themselves, the function and data symbols of
+// the symbol table, and a string table. Lookups are a binary search followed
+// by a walk up the chain, and only touch the pages they need.
+//
+// An index is only used for the binary it was built from, which is identified
+// by its build ID or UUID if it has one and by a hash of its contents
+// otherwise.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLINDEX_H
+#define LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLINDEX_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/DebugInfo/Symbolize/SymbolizableModule.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace llvm {
+
+class DWARFContext;
+class MemoryBuffer;
+class raw_ostream;
+
+namespace symbolize {
+
+/// A symbol index mapped from a file. All tables are little-endian and
+/// referenced by offsets from the start of the file.
+class SymbolIndex : public SymbolizableModule {
+public:
+  static const uint32_t Magic = 0x58444953; // "SIDX"
+  static const uint16_t Version = 1;
+  static const uint32_t NoFrame = UINT32_MAX;
+
+  enum HeaderFlags : uint16_t { Win32Module = 1 };
+
+  struct Header {
+    support::ulittle32_t Magic;
+    support::ulittle16_t Version;
+    support::ulittle16_t Flags;
+    support::ulittle64_t PreferredBase;
+    support::ulittle32_t IdentityOffset;
+    support::ulittle32_t IdentitySize;
+    /// NumEntries addresses, followed by the index of the innermost Frame of
+    /// each, or NoFrame. An entry covers the addresses up to the next one.
+    support::ulittle32_t EntriesOffset;
+    support::ulittle32_t NumEntries;
+    support::ulittle32_t FramesOffset;
+    support::ulittle32_t NumFrames;
+    support::ulittle32_t FunctionsOffset;
+    support::ulittle32_t NumFunctions;
+    support::ulittle32_t ObjectsOffset;
+    support::ulittle32_t NumObjects;
+    support::ulittle32_t StringsOffset;
+    support::ulittle32_t StringsSize;
+  };
+
+  /// One level of an inlining chain. Names are offsets into the string table;
+  /// Caller is the index of the calling frame, which is always smaller than
+  /// that of the frame itself, or NoFrame.
+  struct Frame {
+    support::ulittle32_t FunctionName;
+    support::ulittle32_t ShortName;
+    support::ulittle32_t FileName;
+    support::ulittle32_t Line;
+    support::ulittle32_t Column;
+    support::ulittle32_t Discriminator;
+    support::ulittle32_t StartLine;
+    support::ulittle32_t Caller;
+  };
+
+  /// A symbol table entry. Symbols are sorted by address, which is unique.
+  struct Symbol {
+    support::ulittle64_t Address;
+    support::ulittle64_t Size;
+    support::ulittle32_t Name;
+  };
+
+  /// Checks the header and the bounds of the tables of \p Buffer. The frames
+  /// and strings they refer to are only checked when they are looked up.
+  static Expected<std::unique_ptr<SymbolIndex>>
+  create(std::unique_ptr<MemoryBuffer> Buffer);
+
+  /// Returns the path at which the symbolizer looks for the index of the
+  /// binary at \p BinaryPath.
+  static std::string getDefaultPath(StringRef BinaryPath);
+
+  /// Returns the string identifying \p Obj, which an index built from it
+  /// records.
+  static std::string getModuleIdentity(const object::ObjectFile &Obj);
+
+  StringRef getIdentity() const { return Identity; }
+  size_t getFileSize() const;
+
+  DILineInfo symbolizeCode(object::SectionedAddress ModuleOffset,
+                           FunctionNameKind FNKind,
+                           bool UseSymbolTable) const override;
+  DILineInfoTable symbolizeCodeRange(object::SectionedAddress ModuleOffset,
+                                     uint64_t Size,
+                                     FunctionNameKind FNKind) const override;
+  DIInliningInfo symbolizeInlinedCode(object::SectionedAddress ModuleOffset,
+                                      FunctionNameKind FNKind,
+                                      bool UseSymbolTable) const override;
+  DIGlobal symbolizeData(object::SectionedAddress ModuleOffset) const override;
+  bool isWin32Module() const override;
+  uint64_t getModulePreferredBase() const override;
+
+private:
+  explicit SymbolIndex(std::unique_ptr<MemoryBuffer> Buffer);
+
+  uint32_t lookUpFrame(uint64_t Address) const;
+  DILineInfo getFrameInfo(const Frame &F, FunctionNameKind FNKind) const;
+  bool getNameFromSymbolTable(ArrayRef<Symbol> Symbols, uint64_t Address,
+                              std::string &Name, uint64_t &Addr,
+                              uint64_t &Size) const;
+  StringRef getString(uint32_t Offset) const;
+
+  std::unique_ptr<MemoryBuffer> Buffer;
+  const Header *Hdr;
+  StringRef Identity;
+  ArrayRef<support::ulittle64_t> Addresses;
+  ArrayRef<support::ulittle32_t> EntryFrames;
+  ArrayRef<Frame> Frames;
+  ArrayRef<Symbol> Functions;
+  ArrayRef<Symbol> Objects;
+  StringRef Strings;
+};
+
+/// Collects the symbols and debug info of a linked module and writes them as
+/// a SymbolIndex.
+class SymbolIndexBuilder {
+public:
+  explicit SymbolIndexBuilder(StringRef Identity) : Identity(Identity) {
+    addString("");
+  }
+
+  void setPreferredBase(uint64_t Base) { PreferredBase = Base; }
+  void setWin32Module(bool Win32) { Win32Module = Win32; }
+
+  /// Adds a function or data symbol. Symbols must have distinct addresses.
+  void addSymbol(object::SymbolRef::Type Type, uint64_t Address, uint64_t Size,
+                 StringRef Name);
+
+  /// Records what \p DICtx answers for every address of the module, with
+  /// absolute file paths.
+  void addDebugInfo(DWARFContext &DICtx);
+
+  Error write(raw_ostream &OS) const;
+
+private:
+  struct FrameInfo {
+    uint32_t FunctionName, ShortName, FileName, Line, Column, Discriminator,
+        StartLine, Caller;
+
+    bool operator<(const FrameInfo &RHS) const {
+      return std::tie(FunctionName, ShortName, FileName, Line, Column,
+                      Discriminator, StartLine, Caller) <
+             std::tie(RHS.FunctionName, RHS.ShortName, RHS.FileName, RHS.Line,
+                      RHS.Column, RHS.Discriminator, RHS.StartLine,
+                      RHS.Caller);
+    }
+  };
+
+  struct SymbolInfo {
+    uint64_t Address, Size;
+    uint32_t Name;
+  };
+
+  uint32_t addString(StringRef S);
+  uint32_t addFrame(const DILineInfo &Info, StringRef ShortName,
+                    uint32_t Caller);
+
+  std::string Identity;
+  uint64_t PreferredBase = 0;
+  bool Win32Module = false;
+  std::vector<std::pair<uint64_t, uint32_t>> Entries;
+  std::vector<FrameInfo> Frames;
+  std::map<FrameInfo, uint32_t> FrameIds;
+  std::vector<SymbolInfo> Functions;
+  std::vector<SymbolInfo> Objects;
+  StringMap<uint32_t> StringIds;
+  std::string Strings;
+};
+
+} // end namespace symbolize
+} // end namespace llvm
+
+#endif // LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLINDEX_H
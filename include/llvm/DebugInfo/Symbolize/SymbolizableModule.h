@@ -27,6 +27,11 @@ public:
   virtual DILineInfo symbolizeCode(object::SectionedAddress ModuleOffset,
                                    FunctionNameKind FNKind,
                                    bool UseSymbolTable) const = 0;
+  // Returns the line table rows of [ModuleOffset, ModuleOffset + Size), sorted
+  // by address. Function names are not taken from the symbol table.
+  virtual DILineInfoTable
+  symbolizeCodeRange(object::SectionedAddress ModuleOffset, uint64_t Size,
+                     FunctionNameKind FNKind) const = 0;
   virtual DIInliningInfo
   symbolizeInlinedCode(object::SectionedAddress ModuleOffset,
                        FunctionNameKind FNKind, bool UseSymbolTable) const = 0;
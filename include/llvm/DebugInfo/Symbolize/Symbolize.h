@@ -19,6 +19,7 @@
 #include "llvm/Support/Error.h"
 #include <algorithm>
 #include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
 #include <string>
@@ -26,6 +27,9 @@
 #include <vector>
 
 namespace llvm {
+
+class raw_ostream;
+
 namespace symbolize {
 
 using namespace object;
@@ -39,9 +43,17 @@ public:
     bool UseSymbolTable : 1;
     bool Demangle : 1;
     bool RelativeAddresses : 1;
+    /// Use the SymbolIndex next to a binary instead of its debug info when
+    /// there is one that was built from it. Off by default; llvm-symbolizer
+    /// turns it on.
+    bool UseSymbolIndex : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
     std::string FallbackDebugPath;
+    /// Evict the least recently used modules once the files mapped for loaded
+    /// modules exceed this many bytes. Zero means no limit. The debug info
+    /// parsed from those files is not counted.
+    uint64_t MaxCacheSize = 0;
 
     Options(FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool UseSymbolTable = true, bool Demangle = true,
@@ -49,7 +61,7 @@ public:
             std::string FallbackDebugPath = "")
         : PrintFunctions(PrintFunctions), UseSymbolTable(UseSymbolTable),
           Demangle(Demangle), RelativeAddresses(RelativeAddresses),
-          DefaultArch(std::move(DefaultArch)),
+          UseSymbolIndex(false), DefaultArch(std::move(DefaultArch)),
           FallbackDebugPath(std::move(FallbackDebugPath)) {}
   };
 
@@ -62,6 +74,13 @@ public:
   Expected<DILineInfo> symbolizeCode(const std::string &ModuleName,
                                      object::SectionedAddress ModuleOffset,
                                      StringRef DWPName = "");
+  /// Symbolizes all of [ModuleOffset, ModuleOffset + Size) at once. Each row
+  /// of the result describes the code from its address up to that of the next
+  /// row, which is much cheaper than calling symbolizeCode on every address.
+  Expected<DILineInfoTable>
+  symbolizeCodeRange(const std::string &ModuleName,
+                     object::SectionedAddress ModuleOffset, uint64_t Size,
+                     StringRef DWPName = "");
   Expected<DIInliningInfo>
   symbolizeInlinedCode(const std::string &ModuleName,
                        object::SectionedAddress ModuleOffset,
@@ -70,6 +89,16 @@ public:
                                    object::SectionedAddress ModuleOffset);
   void flush();
 
+  /// Returns the number of bytes of files mapped for loaded modules.
+  uint64_t getCacheSize() const { return CacheSize; }
+  size_t getNumLoadedModules() const { return ModuleLRU.size(); }
+  uint64_t getNumEvictions() const { return NumEvictions; }
+
+  /// Writes a SymbolIndex of \p ModuleName, which must be a linked image, to
+  /// \p OS. Debug info is looked up the same way as for symbolization.
+  Error writeSymbolIndex(const std::string &ModuleName, raw_ostream &OS,
+                         StringRef DWPName = "");
+
   static std::string
   DemangleName(const std::string &Name,
                const SymbolizableModule *DbiModuleDescriptor);
@@ -103,8 +132,32 @@ private:
   Expected<ObjectFile *> getOrCreateObject(const std::string &Path,
                                           const std::string &ArchName);
 
+  /// Records that the module just loaded as \p ModuleName uses the binaries
+  /// at \p Paths and \p ExtraSize bytes of its own, then evicts the least
+  /// recently used modules while the cache exceeds Opts.MaxCacheSize.
+  void cacheModule(const std::string &ModuleName, ArrayRef<std::string> Paths,
+                   uint64_t ExtraSize);
+  /// Drops the binary at \p Path and everything that refers to it from the
+  /// caches below.
+  void releaseBinary(const std::string &Path);
+  /// Returns the path \p Obj was loaded from, or an empty string.
+  std::string getPathOfObject(const ObjectFile *Obj) const;
+
   std::map<std::string, std::unique_ptr<SymbolizableModule>> Modules;
 
+  struct CachedModule {
+    std::string Name;
+    std::vector<std::string> BinaryPaths;
+    uint64_t Size;
+  };
+  /// Successfully loaded modules, most recently used first.
+  std::list<CachedModule> ModuleLRU;
+  std::map<std::string, std::list<CachedModule>::iterator> ModuleLRUPos;
+  /// The number of loaded modules using each binary, and its size.
+  std::map<std::string, std::pair<unsigned, uint64_t>> BinaryUsers;
+  uint64_t CacheSize = 0;
+  uint64_t NumEvictions = 0;
+
   /// Contains cached results of getOrCreateObjectPair().
   std::map<std::pair<std::string, std::string>, ObjectPair>
       ObjectPairForPathArch;
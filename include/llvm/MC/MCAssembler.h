@@ -10,8 +10,10 @@
 #define LLVM_MC_MCASSEMBLER_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/ADT/iterator_range.h"
@@ -154,6 +156,46 @@ private:
 
   VersionInfoType VersionInfo;
 
+  /// A fragment which may need relaxation, and what its last relaxation check
+  /// depended on.
+  struct RelaxationCandidate {
+    MCFragment *F;
+
+    /// The section containing every fragment whose offset the last check
+    /// depended on, or null if the fragment must be checked again.
+    const MCSection *DepSection = nullptr;
+
+    /// The highest layout order of those fragments in DepSection.
+    unsigned MaxDepLayoutOrder = 0;
+
+    /// The value of RelaxationEpoch when the last check took place.
+    unsigned Epoch = 0;
+
+    RelaxationCandidate(MCFragment *F) : F(F) {}
+  };
+
+  /// The relaxation state of a section.
+  struct SectionRelaxationState {
+    /// The fragments of the section which may still need relaxation, in
+    /// layout order.
+    std::vector<RelaxationCandidate> Candidates;
+
+    /// The epoch and the layout order of the first invalidated fragment of
+    /// every invalidation of the section's layout, oldest first.
+    SmallVector<std::pair<unsigned, unsigned>, 8> Invalidations;
+
+    /// True if fragments of the section can be invalidated by relaxation
+    /// without it being recorded in Invalidations, in which case nothing
+    /// depending on its layout is known to be up to date.
+    bool HasUntrackedInvalidations = false;
+  };
+
+  /// The relaxation state of each section during layout.
+  DenseMap<const MCSection *, SectionRelaxationState> RelaxationStates;
+
+  /// Counts the invalidations recorded in RelaxationStates.
+  unsigned RelaxationEpoch = 0;
+
   /// Evaluate a fixup to a relocatable expression and the value which should be
   /// placed into the fixup.
   ///
@@ -186,6 +228,16 @@ private:
   /// were adjusted.
   bool layoutOnce(MCAsmLayout &Layout);
 
+  /// Collect the fragments of each section which may need relaxation.
+  void initRelaxationStates();
+
+  /// Return true if the last relaxation check of \p C may no longer hold
+  /// because a fragment it depended on has moved since.
+  bool isRelaxationCheckStale(const RelaxationCandidate &C) const;
+
+  /// Relax fragment \p F if needed, and return true if its size changed.
+  bool relaxFragment(MCAsmLayout &Layout, MCFragment &F);
+
   /// Perform one layout iteration of the given section and return true
   /// if any offsets were adjusted.
   bool layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec);
@@ -54,6 +54,10 @@ public:
   /// Preserve Comments in Assembly.
   bool PreserveAsmComments : 1;
 
+  /// Refer to other DWARF sections with plain offsets, as in a linked image,
+  /// even on targets that use relocations for them.
+  bool DwarfNoRelocationsAcrossSections : 1;
+
   int DwarfVersion = 0;
 
   std::string ABIName;
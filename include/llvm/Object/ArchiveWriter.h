@@ -38,10 +38,21 @@ struct NewArchiveMember {
 
 std::string computeArchiveRelativePath(StringRef From, StringRef To);
 
+/// How writeArchive finds the symbols of the members for the symbol table.
+/// The archive is the same whatever the options.
+struct ArchiveSymtabOptions {
+  /// Number of threads reading the members, or 0 for one per hardware thread.
+  unsigned NumThreads = 1;
+  /// Read the symbols of bitcode members from the symbol table embedded in
+  /// them instead of loading their modules, when it is up to date.
+  bool UseIRSymtab = false;
+};
+
 Error writeArchive(StringRef ArcName, ArrayRef<NewArchiveMember> NewMembers,
                    bool WriteSymtab, object::Archive::Kind Kind,
                    bool Deterministic, bool Thin,
-                   std::unique_ptr<MemoryBuffer> OldArchiveBuf = nullptr);
+                   std::unique_ptr<MemoryBuffer> OldArchiveBuf = nullptr,
+                   const ArchiveSymtabOptions &SymtabOptions = {});
 }
 
 #endif
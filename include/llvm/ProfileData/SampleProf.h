@@ -359,6 +359,7 @@ public:
   sampleprof_error merge(const FunctionSamples &Other, uint64_t Weight = 1) {
     sampleprof_error Result = sampleprof_error::success;
     Name = Other.getName();
+    Context = Other.getContext();
     MergeResult(Result, addTotalSamples(Other.getTotalSamples(), Weight));
     MergeResult(Result, addHeadSamples(Other.getHeadSamples(), Weight));
     for (const auto &I : Other.getBodySamples()) {
@@ -405,6 +406,31 @@ public:
   /// Return the function name.
   StringRef getName() const { return Name; }
 
+  /// Set the calling context of a context-sensitive profile.
+  ///
+  /// The context lists the callers outermost first, each with the callsite
+  /// location in that caller, and ends with the function itself, e.g.
+  /// "main:3 @ foo:5.1 @ bar" for the samples of bar collected while it was
+  /// called from foo at line offset 5, discriminator 1, and foo was called
+  /// from main at line offset 3.
+  void setContext(StringRef FunctionContext) { Context = FunctionContext; }
+
+  /// Return the calling context, or an empty string if these samples are
+  /// not context-sensitive.
+  StringRef getContext() const { return Context; }
+
+  /// Return true if these samples were collected in a specific calling
+  /// context.
+  bool hasContext() const { return !Context.empty(); }
+
+  /// Split calling context \p Context into its caller frames, outermost
+  /// first, and the name of the function at the end of the context.
+  /// Return false if \p Context is malformed.
+  static bool
+  decodeContext(StringRef Context,
+                SmallVectorImpl<std::pair<StringRef, LineLocation>> &Callers,
+                StringRef &Leaf);
+
   /// Return the original function name if it exists in Module \p M.
   StringRef getFuncNameInModule(const Module *M) const {
     return getNameInModule(Name, M);
@@ -521,6 +547,9 @@ private:
   /// Mangled name of the function.
   StringRef Name;
 
+  /// Calling context of context-sensitive samples, see setContext().
+  StringRef Context;
+
   /// Total number of samples collected inside this function.
   ///
   /// Samples are cumulative, they include all the samples collected
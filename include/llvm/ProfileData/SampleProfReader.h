@@ -306,6 +306,22 @@ public:
   /// Return all the profiles.
   StringMap<FunctionSamples> &getProfiles() { return Profiles; }
 
+  /// Return true if the profile has context-sensitive profiles, i.e.
+  /// top-level profiles keyed by their full calling context.
+  bool profileIsCS() const { return ProfileIsCS; }
+
+  /// Fold every context-sensitive profile into the profile of its outermost
+  /// caller, as if the whole context had been inlined in the profiled
+  /// binary. The samples of a context are not added to the context-less
+  /// profile of the function, so they are only counted once. A context whose
+  /// outermost caller has no profile is merged into the context-less profile
+  /// instead.
+  ///
+  /// Afterwards the profiles can be used by clients that only understand
+  /// inline callsite samples: inlining along a hot context picks up the
+  /// samples collected in that context.
+  std::error_code nestContextProfiles();
+
   /// Report a parse error message.
   void reportError(int64_t LineNumber, Twine Msg) const {
     Ctx.diagnose(DiagnosticInfoSampleProfile(Buffer->getBufferIdentifier(),
@@ -354,6 +370,9 @@ protected:
 
   /// \brief The format of sample.
   SampleProfileFormat Format = SPF_None;
+
+  /// Whether the profile has context-sensitive profiles.
+  bool ProfileIsCS = false;
 };
 
 class SampleProfileReaderText : public SampleProfileReader {
@@ -0,0 +1,309 @@
+//===- llvm/Support/SuffixTree.h - Tree for substring queries ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the SuffixTree class, which finds repeated substrings of a
+// sequence of unsigned integers. It is used by the MachineOutliner to find
+// repeated sequences of instructions.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_SUFFIXTREE_H
+#define LLVM_SUPPORT_SUFFIXTREE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+/// A node in a suffix tree which represents a substring or suffix.
+///
+/// Nodes are stored in a single array owned by the SuffixTree and refer to
+/// each other by their index in that array, so a node is a handful of
+/// integers and the tree needs no per-node allocations.
+///
+/// Each node has either no children or at least two children, with the root
+/// being a exception in the empty tree. The children of a node form a
+/// singly-linked list threaded through \p FirstChild and \p NextSibling.
+///
+/// Each internal node contains the index of the internal node representing
+/// the same string, but with the first character chopped off. This is stored
+/// in \p Link. Each leaf node stores the start index of its respective
+/// suffix in \p SuffixIdx.
+struct SuffixTreeNode {
+  /// Represents an undefined index in the suffix tree.
+  static const unsigned EmptyIdx = -1;
+
+  /// The start index of this node's substring in the main string.
+  unsigned StartIdx = EmptyIdx;
+
+  /// The end index of this node's substring in the main string.
+  ///
+  /// Every leaf node must have its end index incremented at the end of every
+  /// step in the construction algorithm. To avoid having to update O(N)
+  /// nodes individually at the end of every step, leaves leave this as
+  /// \p EmptyIdx and share the end index stored in the tree.
+  unsigned EndIdx = EmptyIdx;
+
+  /// For internal nodes, the internal node representing the same sequence
+  /// with the first character chopped off.
+  ///
+  /// This acts as a shortcut in Ukkonen's algorithm. One of the things that
+  /// Ukkonen's algorithm does to achieve linear-time construction is
+  /// keep track of which node the next insert should be at. This makes each
+  /// insert O(1), and there are a total of O(N) inserts. The suffix link
+  /// helps with inserting children of internal nodes.
+  unsigned Link = EmptyIdx;
+
+  /// The length of the string formed by concatenating the edge labels from the
+  /// root to this node.
+  unsigned ConcatLen = 0;
+
+  /// For leaves, the start index of the suffix represented by this node.
+  unsigned SuffixIdx = EmptyIdx;
+
+  /// The first child of this node, and the next child of this node's parent.
+  unsigned FirstChild = EmptyIdx;
+  unsigned NextSibling = EmptyIdx;
+
+  /// The range of the tree's leaf list covered by the leaf descendants of
+  /// this node, inclusive on both ends.
+  unsigned LeftLeafIdx = EmptyIdx;
+  unsigned RightLeafIdx = EmptyIdx;
+
+  /// Returns true if this node is a leaf.
+  bool isLeaf() const { return EndIdx == EmptyIdx && StartIdx != EmptyIdx; }
+
+  /// Returns true if this node is the root of its owning \p SuffixTree.
+  bool isRoot() const { return StartIdx == EmptyIdx; }
+
+  SuffixTreeNode(unsigned StartIdx, unsigned EndIdx, unsigned Link)
+      : StartIdx(StartIdx), EndIdx(EndIdx), Link(Link) {}
+};
+
+/// A data structure for fast substring queries.
+///
+/// Suffix trees represent the suffixes of their input strings in their leaves.
+/// A suffix tree is a type of compressed trie structure where each node
+/// represents an entire substring rather than a single character. Each leaf
+/// of the tree is a suffix.
+///
+/// A suffix tree can be seen as a type of state machine where each state is a
+/// substring of the full string. The tree is structured so that, for a string
+/// of length N, there are exactly N leaves in the tree. This structure allows
+/// us to quickly find repeated substrings of the input string.
+///
+/// In this implementation, a "string" is a vector of unsigned integers.
+/// These integers may result from hashing some data type. A suffix tree can
+/// contain 1 or many strings, which can then be queried as one large string.
+///
+/// The suffix tree is implemented using Ukkonen's algorithm for linear-time
+/// suffix tree construction. Ukkonen's algorithm is explained in more detail
+/// in the paper by Esko Ukkonen "On-line construction of suffix trees. The
+/// paper is available at
+///
+/// https://www.cs.helsinki.fi/u/ukkonen/SuffixT1withFigs.pdf
+class SuffixTree {
+public:
+  /// Each element is an integer representing an instruction in the module.
+  ArrayRef<unsigned> Str;
+
+  /// A repeated substring in the tree.
+  struct RepeatedSubstring {
+    /// The length of the string.
+    unsigned Length;
+
+    /// The start indices of each occurrence.
+    std::vector<unsigned> StartIndices;
+  };
+
+private:
+  static const unsigned EmptyIdx = SuffixTreeNode::EmptyIdx;
+
+  /// The index of the root node, which represents the empty string.
+  static const unsigned Root = 0;
+
+  /// Every node in the tree.
+  std::vector<SuffixTreeNode> Nodes;
+
+  /// The leaves of the tree in depth-first order. The leaf descendants of an
+  /// internal node are the range [LeftLeafIdx, RightLeafIdx] of this list.
+  std::vector<unsigned> LeafNodes;
+
+  /// The child of each node along each outgoing edge, keyed by the node index
+  /// and the first character of the edge.
+  ///
+  /// This is only needed to find children during construction; the child
+  /// lists are built from it and it is released afterwards.
+  DenseMap<std::pair<unsigned, unsigned>, unsigned> Edges;
+
+  /// For each node, the position at which the edge leading to it was added
+  /// among all edges. A node that replaces another one on the same edge takes
+  /// over its position. Only needed during construction.
+  std::vector<unsigned> EdgeOrder;
+
+  /// The number of edges in the tree.
+  unsigned NumEdges = 0;
+
+  /// The end index of each leaf in the tree.
+  unsigned LeafEndIdx = -1;
+
+  /// If true, a repeated substring is reported at every leaf descendant of
+  /// its node rather than only at the node's leaf children.
+  bool OutlinerLeafDescendants;
+
+  /// Helper struct which keeps track of the next insertion point in
+  /// Ukkonen's algorithm.
+  struct ActiveState {
+    /// The next node to insert at.
+    unsigned Node = Root;
+
+    /// The index of the first character in the substring currently being added.
+    unsigned Idx = EmptyIdx;
+
+    /// The length of the substring we have to add at the current step.
+    unsigned Len = 0;
+  };
+
+  /// The point the next insertion will take place at in the
+  /// construction algorithm.
+  ActiveState Active;
+
+  /// Return the number of elements in the substring associated with \p N.
+  unsigned nodeSize(const SuffixTreeNode &N) const {
+    // Is it the root? If so, it's the empty string so return 0.
+    if (N.isRoot())
+      return 0;
+    unsigned EndIdx = N.isLeaf() ? LeafEndIdx : N.EndIdx;
+    assert(EndIdx != EmptyIdx && "EndIdx is undefined!");
+    // Size = the number of elements in the string.
+    // For example, [0 1 2 3] has length 4, not 3. 3-0 = 3, so we have 3-0+1.
+    return EndIdx - N.StartIdx + 1;
+  }
+
+  /// Allocate a leaf node and add it to the tree.
+  ///
+  /// \param Parent The parent of this node.
+  /// \param StartIdx The start index of this node's associated string.
+  /// \param Edge The label on the edge leaving \p Parent to this node.
+  ///
+  /// \returns The index of the allocated leaf node.
+  unsigned insertLeaf(unsigned Parent, unsigned StartIdx, unsigned Edge);
+
+  /// Allocate an internal node and add it to the tree.
+  ///
+  /// \param Parent The parent of this node. Only EmptyIdx when allocating the
+  /// root.
+  /// \param StartIdx The start index of this node's associated string.
+  /// \param EndIdx The end index of this node's associated string.
+  /// \param Edge The label on the edge leaving \p Parent to this node.
+  ///
+  /// \returns The index of the allocated internal node.
+  unsigned insertInternalNode(unsigned Parent, unsigned StartIdx,
+                              unsigned EndIdx, unsigned Edge);
+
+  /// Build the child lists from \p Edges and release it.
+  ///
+  /// The children of each node are listed in the iteration order of a
+  /// DenseMap keyed by the first character of their edge and filled in the
+  /// order the edges were added. That is the order in which the tree visited
+  /// children when each node owned such a map. The MachineOutliner numbers
+  /// and ranks its candidates in this order, so keeping it keeps the outlined
+  /// functions and their names stable.
+  void buildChildLists();
+
+  /// Set the suffix indices of the leaves to the start indices of their
+  /// respective suffixes, and the leaf ranges of the internal nodes. Walks
+  /// the tree iteratively, so it works for arbitrarily deep trees.
+  void setSuffixIndices();
+
+  /// Construct the suffix tree for the prefix of the input ending at
+  /// \p EndIdx.
+  ///
+  /// Used to construct the full suffix tree iteratively. At the end of each
+  /// step, the constructed suffix tree is either a valid suffix tree, or a
+  /// suffix tree with implicit suffixes. At the end of the final step, the
+  /// suffix tree is a valid tree.
+  ///
+  /// \param EndIdx The end index of the current prefix in the main string.
+  /// \param SuffixesToAdd The number of suffixes that must be added
+  /// to complete the suffix tree at the current phase.
+  ///
+  /// \returns The number of suffixes that have not been added at the end of
+  /// this step.
+  unsigned extend(unsigned EndIdx, unsigned SuffixesToAdd);
+
+public:
+  /// Construct a suffix tree from a sequence of unsigned integers.
+  ///
+  /// \param Str The string to construct the suffix tree for.
+  /// \param OutlinerLeafDescendants Whether to report the occurrences of a
+  /// repeated substring at all leaf descendants of its node.
+  SuffixTree(ArrayRef<unsigned> Str, bool OutlinerLeafDescendants = false);
+
+  /// Return the number of nodes in the tree, including the root.
+  size_t getNumNodes() const { return Nodes.size(); }
+
+  /// Iterator for finding all repeated substrings in the suffix tree.
+  struct RepeatedSubstringIterator {
+  private:
+    /// The tree being iterated over.
+    const SuffixTree *ST = nullptr;
+
+    /// The current node we're visiting.
+    unsigned N = EmptyIdx;
+
+    /// The repeated substring associated with this node.
+    RepeatedSubstring RS;
+
+    /// The nodes left to visit.
+    std::vector<unsigned> ToVisit;
+
+    /// The minimum length of a repeated substring to find.
+    /// Since we're outlining, we want at least two instructions in the range.
+    /// FIXME: This may not be true for targets like X86 which support many
+    /// instruction lengths.
+    const unsigned MinLength = 2;
+
+    /// Move the iterator to the next repeated substring.
+    void advance();
+
+  public:
+    /// Return the current repeated substring.
+    RepeatedSubstring &operator*() { return RS; }
+
+    RepeatedSubstringIterator &operator++() {
+      advance();
+      return *this;
+    }
+
+    RepeatedSubstringIterator operator++(int I) {
+      RepeatedSubstringIterator It(*this);
+      advance();
+      return It;
+    }
+
+    bool operator==(const RepeatedSubstringIterator &Other) const {
+      return N == Other.N;
+    }
+    bool operator!=(const RepeatedSubstringIterator &Other) const {
+      return !(*this == Other);
+    }
+
+    RepeatedSubstringIterator(const SuffixTree *ST, unsigned N);
+  };
+
+  typedef RepeatedSubstringIterator iterator;
+  iterator begin() const { return iterator(this, Root); }
+  iterator end() const { return iterator(this, EmptyIdx); }
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_SUFFIXTREE_H
@@ -118,6 +118,14 @@ public:
   virtual bool shouldPutJumpTableInFunctionSection(bool UsesLabelDifference,
                                                    const Function &F) const;
 
+  /// Return the section for the cold blocks of a function that was split by
+  /// the machine function splitter, or null if the object file format does
+  /// not support splitting functions.
+  virtual MCSection *getSectionForColdFragment(const Function &F,
+                                               const TargetMachine &TM) const {
+    return nullptr;
+  }
+
   /// Targets should implement this method to assign a section to globals with
   /// an explicit section specfied. The implementation of this method can
   /// assume that GO->hasSection() is true.
@@ -142,6 +142,10 @@ struct LoopVectorizePass : public PassInfoMixin<LoopVectorizePass> {
   OptimizationRemarkEmitter *ORE;
   ProfileSummaryInfo *PSI;
 
+  /// Number of instructions the cost model has evaluated in the function
+  /// being processed, checked against -vectorizer-cost-budget.
+  unsigned CostModelBudgetUsed = 0;
+
   PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
 
   // Shim for old PM.
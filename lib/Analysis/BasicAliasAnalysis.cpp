@@ -82,6 +82,14 @@ static cl::opt<bool> DoubleCalcBits("basicaa-double-calc-bits",
 STATISTIC(SearchLimitReached, "Number of times the limit to "
                               "decompose GEPs is reached");
 STATISTIC(SearchTimes, "Number of times a GEP is decomposed");
+STATISTIC(DecomposeGEPCacheHits,
+          "Number of GEP decompositions reused within a query");
+STATISTIC(UnderlyingObjectLookups, "Number of underlying object lookups");
+STATISTIC(UnderlyingObjectCacheHits,
+          "Number of underlying object lookups answered from the query cache");
+STATISTIC(AliasCacheLookups, "Number of alias query cache lookups");
+STATISTIC(AliasCacheHits,
+          "Number of alias queries answered from the query cache");
 
 /// Cutoff after which to stop analysing a set of phi nodes potentially involved
 /// in a cycle. Because we are analysing 'through' phi nodes, we need to be
@@ -627,6 +635,37 @@ bool BasicAAResult::DecomposeGEPExpression(const Value *V,
   return true;
 }
 
+bool BasicAAResult::decomposeGEPExpressionCached(const Value *V,
+                                                 DecomposedGEP &Decomposed) {
+  auto CacheIt = DecomposedGEPCache.find(V);
+  if (CacheIt != DecomposedGEPCache.end()) {
+    ++DecomposeGEPCacheHits;
+    Decomposed = CacheIt->second.first;
+    return CacheIt->second.second;
+  }
+
+  unsigned MaxPointerSize = getMaxPointerSize(DL);
+  Decomposed.StructOffset = Decomposed.OtherOffset = APInt(MaxPointerSize, 0);
+  bool MaxLookupReached = DecomposeGEPExpression(V, Decomposed, DL, &AC, DT);
+  DecomposedGEPCache.try_emplace(V, Decomposed, MaxLookupReached);
+  return MaxLookupReached;
+}
+
+const Value *BasicAAResult::getUnderlyingObjectCached(const Value *V,
+                                                      AAQueryInfo &AAQI) {
+  ++UnderlyingObjectLookups;
+  auto Pair = AAQI.UnderlyingObjectCache.try_emplace(V, nullptr);
+  if (!Pair.second) {
+    ++UnderlyingObjectCacheHits;
+    return Pair.first->second;
+  }
+  // GetUnderlyingObject does not consult the cache, so the iterator is still
+  // valid here.
+  const Value *O = GetUnderlyingObject(V, DL, MaxLookupSearchDepth);
+  Pair.first->second = O;
+  return O;
+}
+
 /// Returns whether the given pointer value points to memory that is local to
 /// the function, with global constants being considered local to all
 /// functions.
@@ -824,19 +863,22 @@ AliasResult BasicAAResult::alias(const MemoryLocation &LocA,
 
   // If we have a directly cached entry for these locations, we have recursed
   // through this once, so just return the cached results. Notably, when this
-  // happens, we don't clear the cache.
+  // happens, we don't clear the cache. A miss is counted by aliasCheck, which
+  // looks the query up again.
   auto CacheIt = AAQI.AliasCache.find(AAQueryInfo::LocPair(LocA, LocB));
-  if (CacheIt != AAQI.AliasCache.end())
-    return CacheIt->second;
-
-  CacheIt = AAQI.AliasCache.find(AAQueryInfo::LocPair(LocB, LocA));
-  if (CacheIt != AAQI.AliasCache.end())
+  if (CacheIt == AAQI.AliasCache.end())
+    CacheIt = AAQI.AliasCache.find(AAQueryInfo::LocPair(LocB, LocA));
+  if (CacheIt != AAQI.AliasCache.end()) {
+    ++AliasCacheLookups;
+    ++AliasCacheHits;
     return CacheIt->second;
+  }
 
   AliasResult Alias = aliasCheck(LocA.Ptr, LocA.Size, LocA.AATags, LocB.Ptr,
                                  LocB.Size, LocB.AATags, AAQI);
 
   VisitedPhiBBs.clear();
+  DecomposedGEPCache.clear();
   return Alias;
 }
 
@@ -1293,13 +1335,9 @@ AliasResult BasicAAResult::aliasGEP(
     const Value *UnderlyingV1, const Value *UnderlyingV2, AAQueryInfo &AAQI) {
   DecomposedGEP DecompGEP1, DecompGEP2;
   unsigned MaxPointerSize = getMaxPointerSize(DL);
-  DecompGEP1.StructOffset = DecompGEP1.OtherOffset = APInt(MaxPointerSize, 0);
-  DecompGEP2.StructOffset = DecompGEP2.OtherOffset = APInt(MaxPointerSize, 0);
 
-  bool GEP1MaxLookupReached =
-    DecomposeGEPExpression(GEP1, DecompGEP1, DL, &AC, DT);
-  bool GEP2MaxLookupReached =
-    DecomposeGEPExpression(V2, DecompGEP2, DL, &AC, DT);
+  bool GEP1MaxLookupReached = decomposeGEPExpressionCached(GEP1, DecompGEP1);
+  bool GEP2MaxLookupReached = decomposeGEPExpressionCached(V2, DecompGEP2);
 
   APInt GEP1BaseOffset = DecompGEP1.StructOffset + DecompGEP1.OtherOffset;
   APInt GEP2BaseOffset = DecompGEP2.StructOffset + DecompGEP2.OtherOffset;
@@ -1742,10 +1780,10 @@ AliasResult BasicAAResult::aliasCheck(const Value *V1, LocationSize V1Size,
 
   // Figure out what objects these things are pointing to if we can.
   if (O1 == nullptr)
-    O1 = GetUnderlyingObject(V1, DL, MaxLookupSearchDepth);
+    O1 = getUnderlyingObjectCached(V1, AAQI);
 
   if (O2 == nullptr)
-    O2 = GetUnderlyingObject(V2, DL, MaxLookupSearchDepth);
+    O2 = getUnderlyingObjectCached(V2, AAQI);
 
   // Null values in the default address space don't point to any object, so they
   // don't alias any other pointer.
@@ -1804,10 +1842,13 @@ AliasResult BasicAAResult::aliasCheck(const Value *V1, LocationSize V1Size,
                             MemoryLocation(V2, V2Size, V2AAInfo));
   if (V1 > V2)
     std::swap(Locs.first, Locs.second);
+  ++AliasCacheLookups;
   std::pair<AAQueryInfo::AliasCacheT::iterator, bool> Pair =
       AAQI.AliasCache.try_emplace(Locs, MayAlias);
-  if (!Pair.second)
+  if (!Pair.second) {
+    ++AliasCacheHits;
     return Pair.first->second;
+  }
 
   // FIXME: This isn't aggressively handling alias(GEP, PHI) for example: if the
   // GEP can't simplify, we don't even look at the PHI cases.
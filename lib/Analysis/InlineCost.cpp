@@ -43,6 +43,7 @@ using namespace llvm;
 #define DEBUG_TYPE "inline-cost"
 
 STATISTIC(NumCallsAnalyzed, "Number of call sites analyzed");
+STATISTIC(NumInstructionsAnalyzed, "Number of callee instructions analyzed");
 
 static cl::opt<int> InlineThreshold(
     "inline-threshold", cl::Hidden, cl::init(225), cl::ZeroOrMore,
@@ -1570,6 +1571,7 @@ CallAnalyzer::analyzeBlock(BasicBlock *BB,
       continue;
 
     ++NumInstructions;
+    ++NumInstructionsAnalyzed;
     if (isa<ExtractElementInst>(I) || I->getType()->isVectorTy())
       ++NumVectorInstructions;
 
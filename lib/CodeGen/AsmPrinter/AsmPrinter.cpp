@@ -1008,6 +1008,46 @@ static bool needFuncLabelsForEHOrDebugInfo(const MachineFunction &MF,
       classifyEHPersonality(MF.getFunction().getPersonalityFn()));
 }
 
+void AsmPrinter::emitColdSectionStart(const MachineBasicBlock &MBB) {
+  MCSection *ColdSection =
+      getObjFileLowering().getSectionForColdFragment(MF->getFunction(), TM);
+  if (!ColdSection)
+    return;
+
+  // End the hot part of the function.
+  if (needFuncLabelsForEHOrDebugInfo(*MF, MMI) ||
+      MAI->hasDotTypeDotSizeDirective()) {
+    CurrentFnEnd = createTempSymbol("func_end");
+    OutStreamer->EmitLabel(CurrentFnEnd);
+  }
+  for (const HandlerInfo &HI : Handlers)
+    HI.Handler->endFragment();
+
+  OutStreamer->SwitchSection(ColdSection);
+  EmitAlignment(MF->getAlignment(), &MF->getFunction());
+  CurrentFnColdBegin =
+      OutContext.getOrCreateSymbol(CurrentFnSym->getName() + ".cold");
+  if (MAI->hasDotTypeDotSizeDirective())
+    OutStreamer->EmitSymbolAttribute(CurrentFnColdBegin,
+                                     MCSA_ELF_TypeFunction);
+  OutStreamer->EmitLabel(CurrentFnColdBegin);
+
+  // The cold part gets a frame description of its own. Its initial state is
+  // the state at the end of the hot part, which the CFI instructions of the
+  // hot blocks describe in layout order.
+  for (const HandlerInfo &HI : Handlers)
+    HI.Handler->beginFragment(&MBB, [](AsmPrinter *Asm) {
+      return Asm->getCurExceptionSym();
+    });
+  for (const MachineBasicBlock &HotMBB : *MF) {
+    if (&HotMBB == &MBB)
+      break;
+    for (const MachineInstr &MI : HotMBB)
+      if (MI.isCFIInstruction())
+        emitCFIInstruction(MI);
+  }
+}
+
 /// EmitFunctionBody - This method emits the body and trailer for a
 /// function.
 void AsmPrinter::EmitFunctionBody() {
@@ -1040,6 +1080,11 @@ void AsmPrinter::EmitFunctionBody() {
   bool HasAnyRealCode = false;
   int NumInstsInFunction = 0;
   for (auto &MBB : *MF) {
+    // Cold blocks are laid out last; switch sections before the first one.
+    if (MBB.isColdSection() && &MBB != &MF->front() &&
+        !std::prev(MBB.getIterator())->isColdSection())
+      emitColdSectionStart(MBB);
+
     // Print a label for the basic block.
     EmitBasicBlockStart(MBB);
     for (auto &MI : MBB) {
@@ -1167,9 +1212,15 @@ void AsmPrinter::EmitFunctionBody() {
 
   if (needFuncLabelsForEHOrDebugInfo(*MF, MMI) ||
       MAI->hasDotTypeDotSizeDirective()) {
-    // Create a symbol for the end of function.
-    CurrentFnEnd = createTempSymbol("func_end");
-    OutStreamer->EmitLabel(CurrentFnEnd);
+    // Create a symbol for the end of function. The end of the hot part of a
+    // split function was emitted before its cold section.
+    if (CurrentFnColdBegin) {
+      CurrentFnColdEnd = createTempSymbol("func_cold_end");
+      OutStreamer->EmitLabel(CurrentFnColdEnd);
+    } else {
+      CurrentFnEnd = createTempSymbol("func_end");
+      OutStreamer->EmitLabel(CurrentFnEnd);
+    }
   }
 
   // If the target wants a .size directive for the size of the function, emit
@@ -1181,6 +1232,12 @@ void AsmPrinter::EmitFunctionBody() {
         MCSymbolRefExpr::create(CurrentFnEnd, OutContext),
         MCSymbolRefExpr::create(CurrentFnSymForSize, OutContext), OutContext);
     OutStreamer->emitELFSize(CurrentFnSym, SizeExp);
+    if (CurrentFnColdBegin) {
+      const MCExpr *ColdSizeExp = MCBinaryExpr::createSub(
+          MCSymbolRefExpr::create(CurrentFnColdEnd, OutContext),
+          MCSymbolRefExpr::create(CurrentFnColdBegin, OutContext), OutContext);
+      OutStreamer->emitELFSize(CurrentFnColdBegin, ColdSizeExp);
+    }
   }
 
   for (const HandlerInfo &HI : Handlers) {
@@ -1657,6 +1714,8 @@ void AsmPrinter::SetupMachineFunction(MachineFunction &MF) {
   CurrentFnSym = getSymbol(&MF.getFunction());
   CurrentFnSymForSize = CurrentFnSym;
   CurrentFnBegin = nullptr;
+  CurrentFnColdBegin = nullptr;
+  CurrentFnColdEnd = nullptr;
   CurExceptionSym = nullptr;
   bool NeedsLocalForSize = MAI->needsLocalForSize();
   if (needFuncLabelsForEHOrDebugInfo(MF, MMI) || NeedsLocalForSize ||
@@ -384,7 +384,13 @@ void DwarfCompileUnit::attachLowHighPC(DIE &D, const MCSymbol *Begin,
 DIE &DwarfCompileUnit::updateSubprogramScopeDIE(const DISubprogram *SP) {
   DIE *SPDie = getOrCreateSubprogramDIE(SP, includeMinimalInlineScopes());
 
-  attachLowHighPC(*SPDie, Asm->getFunctionBegin(), Asm->getFunctionEnd());
+  if (Asm->getFunctionColdBegin())
+    attachRangesOrLowHighPC(
+        *SPDie,
+        {RangeSpan(Asm->getFunctionBegin(), Asm->getFunctionEnd()),
+         RangeSpan(Asm->getFunctionColdBegin(), Asm->getFunctionColdEnd())});
+  else
+    attachLowHighPC(*SPDie, Asm->getFunctionBegin(), Asm->getFunctionEnd());
   if (DD->useAppleExtensionAttributes() &&
       !DD->getCurrentFunction()->getTarget().Options.DisableFramePointerElim(
           *DD->getCurrentFunction()))
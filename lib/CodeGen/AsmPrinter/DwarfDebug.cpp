@@ -1164,7 +1164,8 @@ void DwarfDebug::buildLocationList(SmallVectorImpl<DebugLocEntry> &DebugLoc,
 
     const MCSymbol *EndLabel;
     if (std::next(EI) == Entries.end())
-      EndLabel = Asm->getFunctionEnd();
+      EndLabel = Asm->getFunctionColdEnd() ? Asm->getFunctionColdEnd()
+                                           : Asm->getFunctionEnd();
     else if (std::next(EI)->isClobber())
       EndLabel = getLabelAfterInsn(std::next(EI)->getInstr());
     else
@@ -1211,6 +1212,26 @@ void DwarfDebug::buildLocationList(SmallVectorImpl<DebugLocEntry> &DebugLoc,
     if (PrevEntry != DebugLoc.rend() && PrevEntry->MergeRanges(*CurEntry))
       DebugLoc.pop_back();
   }
+
+  // In a split function, an entry that starts in the hot part and ends in the
+  // cold part describes two address ranges.
+  if (const MCSymbol *ColdBegin = Asm->getFunctionColdBegin()) {
+    SmallVector<DebugLocEntry, 4> SplitLoc;
+    for (const DebugLocEntry &Entry : DebugLoc) {
+      const MCSymbol *Begin = Entry.getBeginSym();
+      const MCSymbol *End = Entry.getEndSym();
+      if (Begin->isInSection() && End->isInSection() &&
+          &Begin->getSection() != &End->getSection()) {
+        SplitLoc.emplace_back(Begin, Asm->getFunctionEnd(),
+                              Entry.getValues());
+        SplitLoc.emplace_back(ColdBegin, End, Entry.getValues());
+      } else {
+        SplitLoc.push_back(Entry);
+      }
+    }
+    DebugLoc.clear();
+    DebugLoc.append(SplitLoc.begin(), SplitLoc.end());
+  }
 }
 
 DbgEntity *DwarfDebug::createConcreteEntity(DwarfCompileUnit &TheCU,
@@ -1609,6 +1630,9 @@ void DwarfDebug::endFunctionImpl(const MachineFunction *MF) {
 
   // Add the range of this function to the list of ranges for the CU.
   TheCU.addRange(RangeSpan(Asm->getFunctionBegin(), Asm->getFunctionEnd()));
+  if (Asm->getFunctionColdBegin())
+    TheCU.addRange(
+        RangeSpan(Asm->getFunctionColdBegin(), Asm->getFunctionColdEnd()));
 
   // Under -gmlt, skip building the subprogram if there are no inlined
   // subroutines inside it. But with -fdebug-info-for-profiling, the subprogram
@@ -11,6 +11,7 @@
 
 #include "llvm/CodeGen/GlobalISel/InstructionSelect.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
 #include "llvm/CodeGen/GlobalISel/LegalizerInfo.h"
@@ -31,6 +32,9 @@
 
 using namespace llvm;
 
+STATISTIC(NumSelectFailures,
+          "Number of functions that fell back because of instruction select");
+
 #ifdef LLVM_GISEL_COV_PREFIX
 static cl::opt<std::string>
     CoveragePrefix("gisel-coverage-prefix", cl::init(LLVM_GISEL_COV_PREFIX),
@@ -85,6 +89,7 @@ bool InstructionSelect::runOnMachineFunction(MachineFunction &MF) {
   // property check already is.
   if (!DisableGISelLegalityCheck)
     if (const MachineInstr *MI = machineFunctionIsIllegal(MF)) {
+      ++NumSelectFailures;
       reportGISelFailure(MF, TPC, MORE, "gisel-select",
                          "instruction is not legal", *MI);
       return false;
@@ -129,6 +134,7 @@ bool InstructionSelect::runOnMachineFunction(MachineFunction &MF) {
       if (!ISel->select(MI, CoverageInfo)) {
         // FIXME: It would be nice to dump all inserted instructions.  It's
         // not obvious how, esp. considering select() can insert after MI.
+        ++NumSelectFailures;
         reportGISelFailure(MF, TPC, MORE, "gisel-select", "cannot select", MI);
         return false;
       }
@@ -193,6 +199,7 @@ bool InstructionSelect::runOnMachineFunction(MachineFunction &MF) {
 
     const TargetRegisterClass *RC = MRI.getRegClassOrNull(VReg);
     if (!RC) {
+      ++NumSelectFailures;
       reportGISelFailure(MF, TPC, MORE, "gisel-select",
                          "VReg has no regclass after selection", *MI);
       return false;
@@ -200,6 +207,7 @@ bool InstructionSelect::runOnMachineFunction(MachineFunction &MF) {
 
     const LLT Ty = MRI.getType(VReg);
     if (Ty.isValid() && Ty.getSizeInBits() > TRI.getRegSizeInBits(*RC)) {
+      ++NumSelectFailures;
       reportGISelFailure(
           MF, TPC, MORE, "gisel-select",
           "VReg's low-level type and register class have different sizes", *MI);
@@ -212,6 +220,7 @@ bool InstructionSelect::runOnMachineFunction(MachineFunction &MF) {
                                       MF.getFunction().getSubprogram(),
                                       /*MBB=*/nullptr);
     R << "inserting blocks is not supported yet";
+    ++NumSelectFailures;
     reportGISelFailure(MF, TPC, MORE, R);
     return false;
   }
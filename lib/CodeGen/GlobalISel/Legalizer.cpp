@@ -15,6 +15,7 @@
 #include "llvm/CodeGen/GlobalISel/Legalizer.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/GlobalISel/CSEInfo.h"
 #include "llvm/CodeGen/GlobalISel/CSEMIRBuilder.h"
 #include "llvm/CodeGen/GlobalISel/GISelChangeObserver.h"
@@ -35,6 +36,9 @@
 
 using namespace llvm;
 
+STATISTIC(NumLegalizeFailures,
+          "Number of functions that fell back because of the legalizer");
+
 static cl::opt<bool>
     EnableCSEInLegalizer("enable-cse-in-legalizer",
                          cl::desc("Should enable CSE in Legalizer"),
@@ -225,6 +229,7 @@ bool Legalizer::runOnMachineFunction(MachineFunction &MF) {
       // fall back to DAG ISel instead in the future.
       if (Res == LegalizerHelper::UnableToLegalize) {
         Helper.MIRBuilder.stopObservingChanges();
+        ++NumLegalizeFailures;
         reportGISelFailure(MF, TPC, MORE, "gisel-legalize",
                            "unable to legalize instruction", MI);
         return false;
@@ -268,6 +273,7 @@ bool Legalizer::runOnMachineFunction(MachineFunction &MF) {
                                       MF.getFunction().getSubprogram(),
                                       /*MBB=*/nullptr);
     R << "inserting blocks is not supported yet";
+    ++NumLegalizeFailures;
     reportGISelFailure(MF, TPC, MORE, R);
     return false;
   }
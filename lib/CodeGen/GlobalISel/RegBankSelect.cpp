@@ -13,6 +13,7 @@
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/GlobalISel/LegalizerInfo.h"
 #include "llvm/CodeGen/GlobalISel/RegisterBank.h"
 #include "llvm/CodeGen/GlobalISel/RegisterBankInfo.h"
@@ -50,6 +51,9 @@
 
 using namespace llvm;
 
+STATISTIC(NumRegBankSelectFailures,
+          "Number of functions that fell back because of regbankselect");
+
 static cl::opt<RegBankSelect::Mode> RegBankSelectMode(
     cl::desc("Mode of the RegBankSelect pass"), cl::Hidden, cl::Optional,
     cl::values(clEnumValN(RegBankSelect::Mode::Fast, "regbankselect-fast",
@@ -667,6 +671,7 @@ bool RegBankSelect::runOnMachineFunction(MachineFunction &MF) {
   // FIXME: This should be in the MachineVerifier.
   if (!DisableGISelLegalityCheck)
     if (const MachineInstr *MI = machineFunctionIsIllegal(MF)) {
+      ++NumRegBankSelectFailures;
       reportGISelFailure(MF, *TPC, *MORE, "gisel-regbankselect",
                          "instruction is not legal", *MI);
       return false;
@@ -692,6 +697,7 @@ bool RegBankSelect::runOnMachineFunction(MachineFunction &MF) {
         continue;
 
       if (!assignInstr(MI)) {
+        ++NumRegBankSelectFailures;
         reportGISelFailure(MF, *TPC, *MORE, "gisel-regbankselect",
                            "unable to map instruction", MI);
         return false;
@@ -67,6 +67,9 @@ void LLVMTargetMachine::initAsmInfo() {
 
   TmpAsmInfo->setRelaxELFRelocations(Options.RelaxELFRelocations);
 
+  if (Options.MCOptions.DwarfNoRelocationsAcrossSections)
+    TmpAsmInfo->setDwarfUsesRelocationsAcrossSections(false);
+
   if (Options.ExceptionModel != ExceptionHandling::None)
     TmpAsmInfo->setExceptionsType(Options.ExceptionModel);
 
@@ -258,14 +258,21 @@ void LexicalScopes::assignInstructionRanges(
     SmallVectorImpl<InsnRange> &MIRanges,
     DenseMap<const MachineInstr *, LexicalScope *> &MI2ScopeMap) {
   LexicalScope *PrevLexicalScope = nullptr;
+  const MachineInstr *PrevMI = nullptr;
   for (const auto &R : MIRanges) {
     LexicalScope *S = MI2ScopeMap.lookup(R.first);
     assert(S && "Lost LexicalScope for a machine instruction!");
-    if (PrevLexicalScope && !PrevLexicalScope->dominates(S))
+    // No range extends from the hot part of a split function into its cold
+    // section.
+    if (PrevLexicalScope && PrevMI->getParent()->isColdSection() !=
+                                R.first->getParent()->isColdSection())
+      PrevLexicalScope->closeInsnRange();
+    else if (PrevLexicalScope && !PrevLexicalScope->dominates(S))
       PrevLexicalScope->closeInsnRange(S);
     S->openInsnRange(R.first);
     S->extendInsnRange(R.second);
     PrevLexicalScope = S;
+    PrevMI = R.second;
   }
 
   if (PrevLexicalScope)
@@ -20,6 +20,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/SparseBitVector.h"
 #include "llvm/ADT/Statistic.h"
@@ -49,6 +50,7 @@
 #include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
@@ -65,6 +67,23 @@ using namespace llvm;
 #define DEBUG_TYPE "livedebugvalues"
 
 STATISTIC(NumInserted, "Number of DBG_VALUE instructions inserted");
+STATISTIC(NumBlocksJoined, "Number of block joins performed");
+STATISTIC(NumBlocksProcessed,
+          "Number of blocks reprocessed after their live-ins changed");
+STATISTIC(NumFunctionsSkipped,
+          "Number of functions too large for debug range extension");
+
+// Functions above both limits are left as they are: their variable locations
+// are not extended across blocks, which bounds the time and memory spent on
+// them at the cost of shorter location ranges.
+static cl::opt<unsigned>
+    InputBBLimit("livedebugvalues-input-bb-limit", cl::Hidden, cl::init(10000),
+                 cl::desc("Maximum number of blocks in a function before the "
+                          "DBG_VALUE limit applies"));
+static cl::opt<unsigned> InputDbgValueLimit(
+    "livedebugvalues-input-dbg-value-limit", cl::Hidden, cl::init(50000),
+    cl::desc("Maximum number of DBG_VALUEs in a function that has more "
+             "blocks than -livedebugvalues-input-bb-limit"));
 
 // If @MI is a DBG_VALUE with debug value described by a defined
 // register, returns the number of this register. In the other case, returns 0.
@@ -88,24 +107,24 @@ private:
 
   enum struct TransferKind { TransferCopy, TransferSpill, TransferRestore };
 
-  /// Keeps track of lexical scopes associated with a user value's source
-  /// location.
-  class UserValueScopes {
-    DebugLoc DL;
-    LexicalScopes &LS;
-    SmallPtrSet<const MachineBasicBlock *, 4> LBlocks;
+  /// Identifies the lexical scope of a debug location: its scope and the
+  /// location it was inlined at.
+  using ScopeKey = std::pair<const DILocalScope *, const DILocation *>;
 
-  public:
-    UserValueScopes(DebugLoc D, LexicalScopes &L) : DL(std::move(D)), LS(L) {}
-
-    /// Return true if current scope dominates at least one machine
-    /// instruction in a given machine basic block.
-    bool dominates(MachineBasicBlock *MBB) {
-      if (LBlocks.empty())
-        LS.getMachineBasicBlocks(DL, LBlocks);
-      return LBlocks.count(MBB) != 0 || LS.dominates(DL, MBB);
-    }
-  };
+  /// Blocks with instructions in each lexical scope. They are computed once
+  /// per scope and shared by all variable locations in it: computing them per
+  /// location costs a block set per DBG_VALUE, which does not scale to
+  /// functions with tens of thousands of blocks and DBG_VALUEs.
+  DenseMap<ScopeKey, SmallPtrSet<const MachineBasicBlock *, 4>> ScopeBlocks;
+
+  /// Answers of LexicalScopes::dominates for blocks outside of a scope's
+  /// ranges. Computing one scans the whole block.
+  DenseMap<std::pair<ScopeKey, const MachineBasicBlock *>, bool>
+      ScopeDominatesBlock;
+
+  /// Return true if the lexical scope of \p DL dominates at least one
+  /// instruction in \p MBB.
+  bool scopeDominates(const DILocation *DL, MachineBasicBlock &MBB);
 
   /// Based on std::pair so it can be used as an index into a DenseMap.
   using DebugVariableBase =
@@ -139,7 +158,6 @@ private:
 
     const DebugVariable Var;
     const MachineInstr &MI; ///< Only used for cloning a new DBG_VALUE.
-    mutable UserValueScopes UVS;
     enum VarLocKind {
       InvalidKind = 0,
       RegisterKind,
@@ -158,9 +176,8 @@ private:
       const ConstantInt *CImm;
     } Loc;
 
-    VarLoc(const MachineInstr &MI, LexicalScopes &LS)
-        : Var(MI.getDebugVariable(), MI.getDebugLoc()->getInlinedAt()), MI(MI),
-          UVS(MI.getDebugLoc(), LS) {
+    VarLoc(const MachineInstr &MI)
+        : Var(MI.getDebugVariable(), MI.getDebugLoc()->getInlinedAt()), MI(MI) {
       static_assert((sizeof(Loc) == sizeof(uint64_t)),
                     "hash does not cover all members of Loc");
       assert(MI.isDebugValue() && "not a DBG_VALUE");
@@ -181,10 +198,8 @@ private:
     }
 
     /// The constructor for spill locations.
-    VarLoc(const MachineInstr &MI, unsigned SpillBase, int SpillOffset,
-           LexicalScopes &LS)
-        : Var(MI.getDebugVariable(), MI.getDebugLoc()->getInlinedAt()), MI(MI),
-          UVS(MI.getDebugLoc(), LS) {
+    VarLoc(const MachineInstr &MI, unsigned SpillBase, int SpillOffset)
+        : Var(MI.getDebugVariable(), MI.getDebugLoc()->getInlinedAt()), MI(MI) {
       assert(MI.isDebugValue() && "not a DBG_VALUE");
       assert(MI.getNumOperands() == 4 && "malformed DBG_VALUE");
       Kind = SpillLocKind;
@@ -202,10 +217,6 @@ private:
       return 0;
     }
 
-    /// Determine whether the lexical scope of this value's debug location
-    /// dominates MBB.
-    bool dominates(MachineBasicBlock &MBB) const { return UVS.dominates(&MBB); }
-
 #if !defined(NDEBUG) || defined(LLVM_ENABLE_DUMP)
     LLVM_DUMP_METHOD void dump() const { MI.dump(); }
 #endif
@@ -429,13 +440,13 @@ void LiveDebugValues::transferDebugValue(const MachineInstr &MI,
   if (isDbgValueDescribedByReg(MI) || MI.getOperand(0).isImm() ||
       MI.getOperand(0).isFPImm() || MI.getOperand(0).isCImm()) {
     // Use normal VarLoc constructor for registers and immediates.
-    VarLoc VL(MI, LS);
+    VarLoc VL(MI);
     ID = VarLocIDs.insert(VL);
     OpenRanges.insert(ID, VL.Var);
   } else if (MI.hasOneMemOperand()) {
     // It's a stack spill -- fetch spill base and offset.
     VarLoc::SpillLoc SpillLocation = extractSpillBaseRegAndOffset(MI);
-    VarLoc VL(MI, SpillLocation.SpillBase, SpillLocation.SpillOffset, LS);
+    VarLoc VL(MI, SpillLocation.SpillBase, SpillLocation.SpillOffset);
     ID = VarLocIDs.insert(VL);
     OpenRanges.insert(ID, VL.Var);
   } else {
@@ -481,7 +492,7 @@ void LiveDebugValues::insertTransferDebugPair(
                      DMI->getDebugVariable(), DMI->getDebugExpression());
     if (DMI->isIndirectDebugValue())
       NewDMI->getOperand(1).setImm(DMI->getOperand(1).getImm());
-    VarLoc VL(*NewDMI, LS);
+    VarLoc VL(*NewDMI);
     ProcessVarLoc(VL, NewDMI);
     LLVM_DEBUG(dbgs() << "Creating DBG_VALUE inst for register copy: ";
                NewDMI->print(dbgs(), false, false, false, TII));
@@ -497,7 +508,7 @@ void LiveDebugValues::insertTransferDebugPair(
     NewDMI =
         BuildMI(*MF, DMI->getDebugLoc(), DMI->getDesc(), true,
                 SpillLocation.SpillBase, DMI->getDebugVariable(), SpillExpr);
-    VarLoc VL(*NewDMI, SpillLocation.SpillBase, SpillLocation.SpillOffset, LS);
+    VarLoc VL(*NewDMI, SpillLocation.SpillBase, SpillLocation.SpillOffset);
     ProcessVarLoc(VL, NewDMI);
     LLVM_DEBUG(dbgs() << "Creating DBG_VALUE inst for spill: ";
                NewDMI->print(dbgs(), false, false, false, TII));
@@ -510,7 +521,7 @@ void LiveDebugValues::insertTransferDebugPair(
     DIBuilder DIB(*const_cast<Function &>(MF->getFunction()).getParent());
     NewDMI = BuildMI(*MF, DMI->getDebugLoc(), DMI->getDesc(), false, NewReg,
                      DMI->getDebugVariable(), DIB.createExpression());
-    VarLoc VL(*NewDMI, LS);
+    VarLoc VL(*NewDMI);
     ProcessVarLoc(VL, NewDMI);
     LLVM_DEBUG(dbgs() << "Creating DBG_VALUE inst for register restore: ";
                NewDMI->print(dbgs(), false, false, false, TII));
@@ -527,7 +538,13 @@ void LiveDebugValues::transferRegisterDef(MachineInstr &MI,
   MachineFunction *MF = MI.getMF();
   const TargetLowering *TLI = MF->getSubtarget().getTargetLowering();
   unsigned SP = TLI->getStackPointerRegisterToSaveRestore();
-  SparseBitVector<> KillSet;
+  if (OpenRanges.empty())
+    return;
+
+  // Collect the registers defined by MI first, so that the open ranges are
+  // scanned once per instruction instead of once per defined register alias.
+  SmallSet<unsigned, 32> DeadRegs;
+  SmallVector<const uint32_t *, 4> RegMasks;
   for (const MachineOperand &MO : MI.operands()) {
     // Determine whether the operand is a register def.  Assume that call
     // instructions never clobber SP, because some backends (e.g., AArch64)
@@ -537,21 +554,32 @@ void LiveDebugValues::transferRegisterDef(MachineInstr &MI,
         !(MI.isCall() && MO.getReg() == SP)) {
       // Remove ranges of all aliased registers.
       for (MCRegAliasIterator RAI(MO.getReg(), TRI, true); RAI.isValid(); ++RAI)
-        for (unsigned ID : OpenRanges.getVarLocs())
-          if (VarLocIDs[ID].isDescribedByReg() == *RAI)
-            KillSet.set(ID);
+        DeadRegs.insert(*RAI);
     } else if (MO.isRegMask()) {
-      // Remove ranges of all clobbered registers. Register masks don't usually
-      // list SP as preserved.  While the debug info may be off for an
-      // instruction or two around callee-cleanup calls, transferring the
-      // DEBUG_VALUE across the call is still a better user experience.
-      for (unsigned ID : OpenRanges.getVarLocs()) {
-        unsigned Reg = VarLocIDs[ID].isDescribedByReg();
-        if (Reg && Reg != SP && MO.clobbersPhysReg(Reg))
-          KillSet.set(ID);
-      }
+      RegMasks.push_back(MO.getRegMask());
     }
   }
+  if (DeadRegs.empty() && RegMasks.empty())
+    return;
+
+  SparseBitVector<> KillSet;
+  for (unsigned ID : OpenRanges.getVarLocs()) {
+    unsigned Reg = VarLocIDs[ID].isDescribedByReg();
+    if (!Reg)
+      continue;
+    if (DeadRegs.count(Reg)) {
+      KillSet.set(ID);
+      continue;
+    }
+    // Remove ranges of all clobbered registers. Register masks don't usually
+    // list SP as preserved.  While the debug info may be off for an
+    // instruction or two around callee-cleanup calls, transferring the
+    // DEBUG_VALUE across the call is still a better user experience.
+    if (Reg != SP && any_of(RegMasks, [Reg](const uint32_t *RegMask) {
+          return MachineOperand::clobbersPhysReg(RegMask, Reg);
+        }))
+      KillSet.set(ID);
+  }
   OpenRanges.erase(KillSet, VarLocIDs);
 }
 
@@ -752,6 +780,23 @@ bool LiveDebugValues::process(MachineInstr &MI, OpenRangesSet &OpenRanges,
   return Changed;
 }
 
+bool LiveDebugValues::scopeDominates(const DILocation *DL,
+                                     MachineBasicBlock &MBB) {
+  ScopeKey Key(DL->getScope(), DL->getInlinedAt());
+  SmallPtrSet<const MachineBasicBlock *, 4> &Blocks = ScopeBlocks[Key];
+  if (Blocks.empty())
+    LS.getMachineBasicBlocks(DL, Blocks);
+  if (Blocks.count(&MBB))
+    return true;
+
+  auto Cached = ScopeDominatesBlock.find(std::make_pair(Key, &MBB));
+  if (Cached != ScopeDominatesBlock.end())
+    return Cached->second;
+  bool Dominates = LS.dominates(DL, &MBB);
+  ScopeDominatesBlock[std::make_pair(Key, &MBB)] = Dominates;
+  return Dominates;
+}
+
 /// This routine joins the analysis results of all incoming edges in @MBB by
 /// inserting a new DBG_VALUE instruction at the start of the @MBB - if the same
 /// source variable in all the predecessors of @MBB reside in the same location.
@@ -762,6 +807,7 @@ bool LiveDebugValues::join(
     SmallPtrSetImpl<const MachineBasicBlock *> &ArtificialBlocks) {
   LLVM_DEBUG(dbgs() << "join MBB: " << MBB.getNumber() << "\n");
   bool Changed = false;
+  ++NumBlocksJoined;
 
   VarLocSet InLocsT; // Temporary incoming locations.
 
@@ -805,7 +851,7 @@ bool LiveDebugValues::join(
   bool IsArtificial = ArtificialBlocks.count(&MBB);
   if (!IsArtificial) {
     for (auto ID : InLocsT) {
-      if (!VarLocIDs[ID].dominates(MBB)) {
+      if (!scopeDominates(VarLocIDs[ID].MI.getDebugLoc(), MBB)) {
         KillSet.set(ID);
         LLVM_DEBUG({
           auto Name = VarLocIDs[ID].Var.getVar()->getName();
@@ -875,7 +921,7 @@ bool LiveDebugValues::ExtendRanges(MachineFunction &MF) {
   // instructions without locations, or with line 0 locations.
   SmallPtrSet<const MachineBasicBlock *, 16> ArtificialBlocks;
 
-  DenseMap<unsigned int, MachineBasicBlock *> OrderToBB;
+  SmallVector<MachineBasicBlock *, 32> OrderToBB;
   DenseMap<MachineBasicBlock *, unsigned int> BBToOrder;
   std::priority_queue<unsigned int, std::vector<unsigned int>,
                       std::greater<unsigned int>>
@@ -911,7 +957,7 @@ bool LiveDebugValues::ExtendRanges(MachineFunction &MF) {
   ReversePostOrderTraversal<MachineFunction *> RPOT(&MF);
   unsigned int RPONumber = 0;
   for (auto RI = RPOT.begin(), RE = RPOT.end(); RI != RE; ++RI) {
-    OrderToBB[RPONumber] = *RI;
+    OrderToBB.push_back(*RI);
     BBToOrder[*RI] = RPONumber;
     Worklist.push(RPONumber);
     ++RPONumber;
@@ -936,6 +982,7 @@ bool LiveDebugValues::ExtendRanges(MachineFunction &MF) {
       if (MBBJoined) {
         MBBJoined = false;
         Changed = true;
+        ++NumBlocksProcessed;
         // Now that we have started to extend ranges across BBs we need to
         // examine spill instructions to see whether they spill registers that
         // correspond to user variables.
@@ -984,6 +1031,21 @@ bool LiveDebugValues::runOnMachineFunction(MachineFunction &MF) {
       DICompileUnit::NoDebug)
     return false;
 
+  if (MF.size() > InputBBLimit) {
+    unsigned NumDbgValues = 0;
+    for (const MachineBasicBlock &MBB : MF)
+      for (const MachineInstr &MI : MBB)
+        if (MI.isDebugValue())
+          ++NumDbgValues;
+    if (NumDbgValues > InputDbgValueLimit) {
+      LLVM_DEBUG(dbgs() << "Disabling LiveDebugValues for " << MF.getName()
+                        << ": " << MF.size() << " blocks, " << NumDbgValues
+                        << " DBG_VALUEs\n");
+      ++NumFunctionsSkipped;
+      return false;
+    }
+  }
+
   TRI = MF.getSubtarget().getRegisterInfo();
   TII = MF.getSubtarget().getInstrInfo();
   TFI = MF.getSubtarget().getFrameLowering();
@@ -992,5 +1054,7 @@ bool LiveDebugValues::runOnMachineFunction(MachineFunction &MF) {
   LS.initialize(MF);
 
   bool Changed = ExtendRanges(MF);
+  ScopeBlocks.clear();
+  ScopeDominatesBlock.clear();
   return Changed;
 }
@@ -325,6 +325,11 @@ void MachineBasicBlock::print(raw_ostream &OS, ModuleSlotTracker &MST,
     OS << "align " << getAlignment();
     HasAttributes = true;
   }
+  if (isColdSection()) {
+    OS << (HasAttributes ? ", " : " (");
+    OS << "cold-section";
+    HasAttributes = true;
+  }
   if (HasAttributes)
     OS << ")";
   OS << ":\n";
@@ -56,6 +56,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include <algorithm>
@@ -63,6 +64,7 @@
 #include <cstdint>
 #include <iterator>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -78,6 +80,9 @@ STATISTIC(CondBranchTakenFreq,
           "Potential frequency of taking conditional branches");
 STATISTIC(UncondBranchTakenFreq,
           "Potential frequency of taking unconditional branches");
+STATISTIC(NumExtTspLayouts, "Number of functions laid out with Ext-TSP");
+STATISTIC(NumExtTspRejected,
+          "Number of Ext-TSP layouts rejected for a lower score");
 
 static cl::opt<unsigned> AlignAllBlock("align-all-blocks",
                                        cl::desc("Force the alignment of all "
@@ -181,6 +186,37 @@ static cl::opt<unsigned> TriangleChainCount(
     cl::init(2),
     cl::Hidden);
 
+// Ext-TSP layout.
+static cl::opt<bool> EnableExtTspBlockPlacement(
+    "enable-ext-tsp-block-placement",
+    cl::desc("Lay out functions with profile data so as to maximize the "
+             "extended TSP score (fallthroughs plus short jumps)."),
+    cl::init(false), cl::Hidden);
+
+static cl::opt<bool> ExtTspReport(
+    "ext-tsp-block-placement-report",
+    cl::desc("Print the Ext-TSP score and taken-branch frequency of the "
+             "chain-based and the Ext-TSP layout of every function."),
+    cl::init(false), cl::Hidden);
+
+// The chain merging is quadratic in the number of blocks, see ExtTspLayout.
+static cl::opt<unsigned> ExtTspMaxBlocks(
+    "ext-tsp-block-placement-max-blocks",
+    cl::desc("Keep the chain-based layout for functions with more blocks."),
+    cl::init(1024), cl::Hidden);
+
+static cl::opt<unsigned> ExtTspForwardDistance(
+    "ext-tsp-forward-distance",
+    cl::desc("Maximum distance (in bytes) of a forward jump that still "
+             "contributes to the Ext-TSP score."),
+    cl::init(1024), cl::Hidden);
+
+static cl::opt<unsigned> ExtTspBackwardDistance(
+    "ext-tsp-backward-distance",
+    cl::desc("Maximum distance (in bytes) of a backward jump that still "
+             "contributes to the Ext-TSP score."),
+    cl::init(640), cl::Hidden);
+
 extern cl::opt<unsigned> StaticLikelyProb;
 extern cl::opt<unsigned> ProfileLikelyProb;
 
@@ -470,6 +506,8 @@ class MachineBlockPlacement : public MachineFunctionPass {
   void buildCFGChains();
   void optimizeBranches();
   void alignBlocks();
+  void applyExtTspLayout();
+  void assignBlockOrder(ArrayRef<MachineBasicBlock *> NewOrder);
   /// Returns true if a block should be tail-duplicated to increase fallthrough
   /// opportunities.
   bool shouldTailDuplicate(MachineBasicBlock *BB);
@@ -2788,6 +2826,359 @@ bool MachineBlockPlacement::maybeTailDuplicateBlock(
   return Removed;
 }
 
+namespace {
+
+/// Ext-TSP block layout.
+///
+/// The extended TSP score of a layout credits every control-flow edge whose
+/// target directly follows its source (a fallthrough) with the edge frequency,
+/// and short forward and backward jumps with a fraction of it that decreases
+/// linearly with the jump distance. Blocks start out in singleton chains; the
+/// pair of chains whose concatenation increases the score the most is merged
+/// until no merge is profitable, and the remaining chains are ordered by
+/// decreasing execution density. Blocks are identified by their index in the
+/// original layout, and block 0, the entry, is always placed first.
+///
+/// Each merge rescans all J jumps for the best candidate pair and rescores the
+/// pairs next to the merged chain, so laying out N blocks takes O(N * J) time
+/// plus the rescoring, which is at worst O(N^2 * J) for long chains with many
+/// neighbors. -ext-tsp-block-placement-max-blocks bounds N.
+class ExtTspLayout {
+public:
+  struct Jump {
+    unsigned Src;
+    unsigned Dst;
+    uint64_t Freq;
+  };
+
+  ExtTspLayout(ArrayRef<uint64_t> Sizes, ArrayRef<uint64_t> Freqs,
+               ArrayRef<Jump> Jumps);
+
+  /// Keep block \p Src immediately followed by block Src + 1. Must be called
+  /// in increasing order of \p Src before run().
+  void forceFallthrough(unsigned Src);
+
+  /// Compute the layout, as a permutation of the block indices.
+  std::vector<unsigned> run();
+
+  /// Returns the Ext-TSP score of placing the blocks in \p Order.
+  double score(ArrayRef<unsigned> Order) const;
+
+  /// Returns the total frequency of the jumps that are not fallthroughs when
+  /// the blocks are placed in \p Order.
+  uint64_t takenFrequency(ArrayRef<unsigned> Order) const;
+
+private:
+  static constexpr double FallthroughWeight = 1.0;
+  static constexpr double ForwardWeight = 0.1;
+  static constexpr double BackwardWeight = 0.1;
+
+  static double jumpScore(uint64_t SrcAddr, uint64_t SrcSize, uint64_t DstAddr,
+                          uint64_t Freq);
+
+  /// Score of the jumps within chain \p X followed by chain \p Y.
+  double mergedScore(unsigned X, unsigned Y) const;
+  void mergeChains(unsigned X, unsigned Y);
+
+  ArrayRef<uint64_t> Sizes;
+  ArrayRef<uint64_t> Freqs;
+  ArrayRef<Jump> Jumps;
+  std::vector<SmallVector<unsigned, 2>> OutJumps;
+
+  /// Chains are identified by their first block in the original layout.
+  std::vector<std::vector<unsigned>> ChainBlocks;
+  std::vector<unsigned> ChainOf;
+  std::vector<double> ChainScore;
+
+  /// Scratch block addresses used while scoring.
+  mutable std::vector<uint64_t> Addrs;
+};
+
+} // end anonymous namespace
+
+constexpr double ExtTspLayout::FallthroughWeight;
+constexpr double ExtTspLayout::ForwardWeight;
+constexpr double ExtTspLayout::BackwardWeight;
+
+ExtTspLayout::ExtTspLayout(ArrayRef<uint64_t> Sizes, ArrayRef<uint64_t> Freqs,
+                           ArrayRef<Jump> Jumps)
+    : Sizes(Sizes), Freqs(Freqs), Jumps(Jumps), OutJumps(Sizes.size()),
+      ChainBlocks(Sizes.size()), ChainOf(Sizes.size()),
+      ChainScore(Sizes.size()), Addrs(Sizes.size()) {
+  assert(Sizes.size() == Freqs.size() && "Inconsistent block count");
+  for (unsigned J = 0, E = Jumps.size(); J != E; ++J)
+    OutJumps[Jumps[J].Src].push_back(J);
+  for (unsigned B = 0, E = Sizes.size(); B != E; ++B) {
+    ChainBlocks[B].push_back(B);
+    ChainOf[B] = B;
+  }
+  for (unsigned B = 0, E = Sizes.size(); B != E; ++B)
+    ChainScore[B] = mergedScore(B, B);
+}
+
+double ExtTspLayout::jumpScore(uint64_t SrcAddr, uint64_t SrcSize,
+                               uint64_t DstAddr, uint64_t Freq) {
+  uint64_t SrcEnd = SrcAddr + SrcSize;
+  if (SrcEnd == DstAddr)
+    return FallthroughWeight * Freq;
+  if (SrcEnd < DstAddr) {
+    uint64_t Dist = DstAddr - SrcEnd;
+    if (Dist <= ExtTspForwardDistance)
+      return ForwardWeight * Freq * (1.0 - double(Dist) / ExtTspForwardDistance);
+    return 0;
+  }
+  uint64_t Dist = SrcEnd - DstAddr;
+  if (Dist <= ExtTspBackwardDistance)
+    return BackwardWeight * Freq * (1.0 - double(Dist) / ExtTspBackwardDistance);
+  return 0;
+}
+
+double ExtTspLayout::mergedScore(unsigned X, unsigned Y) const {
+  uint64_t Addr = 0;
+  for (unsigned B : ChainBlocks[X]) {
+    Addrs[B] = Addr;
+    Addr += Sizes[B];
+  }
+  if (Y != X)
+    for (unsigned B : ChainBlocks[Y]) {
+      Addrs[B] = Addr;
+      Addr += Sizes[B];
+    }
+
+  double Score = 0;
+  auto ScoreChain = [&](unsigned C) {
+    for (unsigned B : ChainBlocks[C])
+      for (unsigned J : OutJumps[B]) {
+        unsigned Dst = Jumps[J].Dst;
+        if (ChainOf[Dst] == X || ChainOf[Dst] == Y)
+          Score += jumpScore(Addrs[B], Sizes[B], Addrs[Dst], Jumps[J].Freq);
+      }
+  };
+  ScoreChain(X);
+  if (Y != X)
+    ScoreChain(Y);
+  return Score;
+}
+
+void ExtTspLayout::mergeChains(unsigned X, unsigned Y) {
+  double Score = mergedScore(X, Y);
+  for (unsigned B : ChainBlocks[Y])
+    ChainOf[B] = X;
+  ChainBlocks[X].insert(ChainBlocks[X].end(), ChainBlocks[Y].begin(),
+                        ChainBlocks[Y].end());
+  ChainBlocks[Y].clear();
+  ChainScore[X] = Score;
+  ChainScore[Y] = 0;
+}
+
+void ExtTspLayout::forceFallthrough(unsigned Src) {
+  unsigned X = ChainOf[Src], Y = ChainOf[Src + 1];
+  assert(ChainBlocks[X].back() == Src && ChainBlocks[Y].front() == Src + 1 &&
+         "Fallthroughs must be forced in layout order");
+  if (X != Y)
+    mergeChains(X, Y);
+}
+
+std::vector<unsigned> ExtTspLayout::run() {
+  const unsigned EntryChain = ChainOf[0];
+  // Gain of placing chain First directly before chain Second. Entries are
+  // dropped when either chain changes.
+  DenseMap<std::pair<unsigned, unsigned>, double> GainCache;
+
+  while (true) {
+    double BestGain = 0;
+    unsigned BestX = 0, BestY = 0;
+    for (const Jump &J : Jumps) {
+      unsigned A = ChainOf[J.Src], B = ChainOf[J.Dst];
+      if (A == B)
+        continue;
+      for (std::pair<unsigned, unsigned> Key : {std::make_pair(A, B),
+                                                std::make_pair(B, A)}) {
+        // The entry block must stay first.
+        if (Key.second == EntryChain)
+          continue;
+        auto It = GainCache.find(Key);
+        if (It == GainCache.end()) {
+          double Gain = mergedScore(Key.first, Key.second) -
+                        ChainScore[Key.first] - ChainScore[Key.second];
+          It = GainCache.insert({Key, Gain}).first;
+        }
+        if (It->second > BestGain) {
+          BestGain = It->second;
+          BestX = Key.first;
+          BestY = Key.second;
+        }
+      }
+    }
+    if (BestGain <= 0)
+      break;
+
+    mergeChains(BestX, BestY);
+    for (auto I = GainCache.begin(), E = GainCache.end(); I != E;) {
+      auto Cur = I++;
+      const std::pair<unsigned, unsigned> &Key = Cur->first;
+      if (Key.first == BestX || Key.second == BestX || Key.first == BestY ||
+          Key.second == BestY)
+        GainCache.erase(Cur);
+    }
+  }
+
+  // Place the entry chain first and the remaining chains hottest first.
+  SmallVector<unsigned, 16> Chains;
+  std::vector<double> Density(ChainBlocks.size());
+  for (unsigned C = 0, E = ChainBlocks.size(); C != E; ++C) {
+    if (ChainBlocks[C].empty())
+      continue;
+    uint64_t Size = 0;
+    double Freq = 0;
+    for (unsigned B : ChainBlocks[C]) {
+      Size += Sizes[B];
+      Freq += Freqs[B];
+    }
+    Density[C] = Freq / std::max<uint64_t>(Size, 1);
+    Chains.push_back(C);
+  }
+  std::stable_sort(Chains.begin(), Chains.end(), [&](unsigned L, unsigned R) {
+    if (L == EntryChain || R == EntryChain)
+      return L == EntryChain && R != EntryChain;
+    return Density[L] > Density[R];
+  });
+
+  std::vector<unsigned> Order;
+  Order.reserve(Sizes.size());
+  for (unsigned C : Chains)
+    Order.insert(Order.end(), ChainBlocks[C].begin(), ChainBlocks[C].end());
+  return Order;
+}
+
+double ExtTspLayout::score(ArrayRef<unsigned> Order) const {
+  uint64_t Addr = 0;
+  for (unsigned B : Order) {
+    Addrs[B] = Addr;
+    Addr += Sizes[B];
+  }
+  double Score = 0;
+  for (const Jump &J : Jumps)
+    Score += jumpScore(Addrs[J.Src], Sizes[J.Src], Addrs[J.Dst], J.Freq);
+  return Score;
+}
+
+uint64_t ExtTspLayout::takenFrequency(ArrayRef<unsigned> Order) const {
+  std::vector<unsigned> Position(Order.size());
+  for (unsigned I = 0, E = Order.size(); I != E; ++I)
+    Position[Order[I]] = I;
+  uint64_t Taken = 0;
+  for (const Jump &J : Jumps)
+    if (Position[J.Dst] != Position[J.Src] + 1)
+      Taken += J.Freq;
+  return Taken;
+}
+
+/// Replace the chain-based layout by the Ext-TSP layout when the latter has a
+/// higher score.
+void MachineBlockPlacement::applyExtTspLayout() {
+  if (F->size() > ExtTspMaxBlocks || F->getTarget().requiresStructuredCFG())
+    return;
+
+  // Index the blocks in the current layout. Functions with EH pads keep their
+  // chain-based layout, which already handles funclets and landing pads.
+  SmallVector<MachineBasicBlock *, 16> Blocks;
+  DenseMap<const MachineBasicBlock *, unsigned> BlockIndex;
+  for (MachineBasicBlock &MBB : *F) {
+    if (MBB.isEHPad())
+      return;
+    BlockIndex[&MBB] = Blocks.size();
+    Blocks.push_back(&MBB);
+  }
+
+  std::vector<uint64_t> Sizes, Freqs;
+  std::vector<ExtTspLayout::Jump> Jumps;
+  for (MachineBasicBlock *MBB : Blocks) {
+    // There is no target-independent size estimate at this point; assume four
+    // bytes per instruction, which is enough to tell short jumps from long
+    // ones.
+    unsigned NumInsts = 0;
+    for (const MachineInstr &MI : *MBB)
+      if (!MI.isMetaInstruction())
+        ++NumInsts;
+    Sizes.push_back(4 * std::max(NumInsts, 1u));
+
+    BlockFrequency Freq = MBFI->getBlockFreq(MBB);
+    Freqs.push_back(Freq.getFrequency());
+    for (MachineBasicBlock *Succ : MBB->successors()) {
+      BlockFrequency EdgeFreq = Freq * MBPI->getEdgeProbability(MBB, Succ);
+      Jumps.push_back(
+          {BlockIndex[MBB], BlockIndex[Succ], EdgeFreq.getFrequency()});
+    }
+  }
+
+  ExtTspLayout Layout(Sizes, Freqs, Jumps);
+  SmallVector<MachineOperand, 4> Cond; // For AnalyzeBranch.
+  // A fallthrough out of a block whose terminators cannot be analyzed cannot
+  // be rewritten, so such a block stays in front of its layout successor.
+  for (unsigned I = 0, E = Blocks.size(); I + 1 < E; ++I) {
+    Cond.clear();
+    MachineBasicBlock *TBB = nullptr, *FBB = nullptr; // For AnalyzeBranch.
+    if (TII->analyzeBranch(*Blocks[I], TBB, FBB, Cond) &&
+        Blocks[I]->canFallThrough())
+      Layout.forceFallthrough(I);
+  }
+
+  std::vector<unsigned> ChainOrder(Blocks.size());
+  std::iota(ChainOrder.begin(), ChainOrder.end(), 0);
+  std::vector<unsigned> NewOrder = Layout.run();
+  double ChainScore = Layout.score(ChainOrder);
+  double NewScore = Layout.score(NewOrder);
+  bool Accept = NewScore > ChainScore;
+
+  LLVM_DEBUG(dbgs() << "[MBP] Ext-TSP score of " << F->getName() << ": "
+                    << ChainScore << " -> " << NewScore << "\n");
+  if (ExtTspReport) {
+    // Scores and frequencies are reported relative to the entry frequency.
+    double EntryFreq = std::max<uint64_t>(MBFI->getEntryFreq(), 1);
+    errs() << "ext-tsp: " << F->getName() << ": score "
+           << format("%.2f", ChainScore / EntryFreq) << " -> "
+           << format("%.2f", NewScore / EntryFreq) << ", taken branches "
+           << format("%.2f", Layout.takenFrequency(ChainOrder) / EntryFreq)
+           << " -> "
+           << format("%.2f", Layout.takenFrequency(NewOrder) / EntryFreq)
+           << (Accept ? "" : " (kept chain layout)") << "\n";
+  }
+
+  if (!Accept) {
+    ++NumExtTspRejected;
+    return;
+  }
+  ++NumExtTspLayouts;
+
+  SmallVector<MachineBasicBlock *, 16> NewBlockOrder;
+  for (unsigned I : NewOrder)
+    NewBlockOrder.push_back(Blocks[I]);
+  assignBlockOrder(NewBlockOrder);
+}
+
+/// Splice the blocks of the function into \p NewOrder and update their
+/// terminators accordingly.
+void MachineBlockPlacement::assignBlockOrder(
+    ArrayRef<MachineBasicBlock *> NewOrder) {
+  assert(NewOrder.size() == F->size() && "Incomplete block order");
+  MachineFunction::iterator InsertPos = F->begin();
+  for (MachineBasicBlock *MBB : NewOrder) {
+    if (InsertPos != MachineFunction::iterator(MBB))
+      F->splice(InsertPos, MBB);
+    else
+      ++InsertPos;
+  }
+
+  SmallVector<MachineOperand, 4> Cond; // For AnalyzeBranch.
+  for (MachineBasicBlock &MBB : *F) {
+    Cond.clear();
+    MachineBasicBlock *TBB = nullptr, *FBB = nullptr; // For AnalyzeBranch.
+    if (!TII->analyzeBranch(MBB, TBB, FBB, Cond))
+      MBB.updateTerminator();
+  }
+}
+
 bool MachineBlockPlacement::runOnMachineFunction(MachineFunction &MF) {
   if (skipFunction(MF.getFunction()))
     return false;
@@ -2869,6 +3260,9 @@ bool MachineBlockPlacement::runOnMachineFunction(MachineFunction &MF) {
     }
   }
 
+  if (EnableExtTspBlockPlacement && MF.getFunction().hasProfileData())
+    applyExtTspLayout();
+
   optimizeBranches();
   alignBlocks();
 
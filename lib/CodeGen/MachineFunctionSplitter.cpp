@@ -0,0 +1,153 @@
+//===-- MachineFunctionSplitter.cpp - Split out cold blocks ---------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass moves the blocks of a function that the profile shows to be cold
+// to the end of the function and marks them, so that the AsmPrinter emits them
+// in a separate section with a frame description of their own. Unlike the IR
+// hot/cold splitting pass, no call is introduced: the hot and cold parts of
+// the function branch to each other directly, and the hot text of the program
+// gets denser without any runtime overhead.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineBasicBlock.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/CodeGen/TargetInstrInfo.h"
+#include "llvm/CodeGen/TargetSubtargetInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Target/TargetMachine.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "machine-function-splitter"
+
+STATISTIC(NumSplitFunctions, "Number of functions split");
+STATISTIC(NumColdBlocks, "Number of blocks moved to a cold section");
+STATISTIC(NumColdInstrs, "Number of instructions moved to a cold section");
+
+static cl::opt<unsigned> ColdCountThreshold(
+    "mfs-count-threshold", cl::Hidden,
+    cl::desc("Blocks with a profile count below this threshold are moved to "
+             "the cold section"),
+    cl::init(1));
+
+namespace {
+class MachineFunctionSplitter : public MachineFunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  MachineFunctionSplitter() : MachineFunctionPass(ID) {
+    initializeMachineFunctionSplitterPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<MachineBlockFrequencyInfo>();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
+  MachineFunctionProperties getRequiredProperties() const override {
+    return MachineFunctionProperties().set(
+        MachineFunctionProperties::Property::NoVRegs);
+  }
+};
+} // end anonymous namespace
+
+char MachineFunctionSplitter::ID = 0;
+char &llvm::MachineFunctionSplitterID = MachineFunctionSplitter::ID;
+INITIALIZE_PASS_BEGIN(MachineFunctionSplitter, DEBUG_TYPE,
+                      "Split Cold Blocks out of Machine Functions", false,
+                      false)
+INITIALIZE_PASS_DEPENDENCY(MachineBlockFrequencyInfo)
+INITIALIZE_PASS_END(MachineFunctionSplitter, DEBUG_TYPE,
+                    "Split Cold Blocks out of Machine Functions", false, false)
+
+bool MachineFunctionSplitter::runOnMachineFunction(MachineFunction &MF) {
+  const Function &F = MF.getFunction();
+  if (skipFunction(F) || !F.hasProfileData() ||
+      !MF.getTarget().getTargetTriple().isOSBinFormatELF())
+    return false;
+
+  // The call-site tables of the LSDA describe the function as a single range,
+  // so functions with a personality keep all their blocks together.
+  if (F.hasPersonalityFn())
+    return false;
+  for (const MachineBasicBlock &MBB : MF)
+    if (MBB.isEHPad() || MBB.isColdSection())
+      return false;
+
+  const MachineBlockFrequencyInfo &MBFI =
+      getAnalysis<MachineBlockFrequencyInfo>();
+  auto IsCold = [&](const MachineBasicBlock &MBB) {
+    if (&MBB == &MF.front())
+      return false;
+    Optional<uint64_t> Count = MBFI.getBlockProfileCount(&MBB);
+    return Count && *Count < ColdCountThreshold;
+  };
+
+  SmallVector<MachineBasicBlock *, 16> Blocks;
+  SmallVector<bool, 16> Cold;
+  for (MachineBasicBlock &MBB : MF) {
+    Blocks.push_back(&MBB);
+    Cold.push_back(IsCold(MBB));
+  }
+
+  // A fallthrough out of a block whose terminators cannot be analyzed cannot be
+  // rewritten into a branch, so both blocks stay in the hot part.
+  const TargetInstrInfo *TII = MF.getSubtarget().getInstrInfo();
+  SmallVector<MachineOperand, 4> Cond; // For AnalyzeBranch.
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (unsigned I = 0, E = Blocks.size(); I + 1 < E; ++I) {
+      if (Cold[I] == Cold[I + 1])
+        continue;
+      Cond.clear();
+      MachineBasicBlock *TBB = nullptr, *FBB = nullptr; // For AnalyzeBranch.
+      if (TII->analyzeBranch(*Blocks[I], TBB, FBB, Cond) &&
+          Blocks[I]->canFallThrough()) {
+        Cold[I] = Cold[I + 1] = false;
+        Changed = true;
+      }
+    }
+  }
+
+  if (llvm::none_of(Cold, [](bool C) { return C; }))
+    return false;
+
+  // Move the cold blocks after the hot ones, keeping their relative order.
+  for (unsigned I = 0, E = Blocks.size(); I != E; ++I) {
+    if (!Cold[I])
+      continue;
+    MachineBasicBlock *MBB = Blocks[I];
+    LLVM_DEBUG(dbgs() << "Moving " << printMBBReference(*MBB)
+                      << " to the cold section of " << MF.getName() << "\n");
+    MBB->moveAfter(&MF.back());
+    MBB->setIsColdSection();
+    ++NumColdBlocks;
+    for (const MachineInstr &MI : *MBB)
+      if (!MI.isMetaInstruction())
+        ++NumColdInstrs;
+  }
+  ++NumSplitFunctions;
+
+  // No block may fall through into the other part of the function.
+  for (MachineBasicBlock &MBB : MF) {
+    Cond.clear();
+    MachineBasicBlock *TBB = nullptr, *FBB = nullptr; // For AnalyzeBranch.
+    if (!TII->analyzeBranch(MBB, TBB, FBB, Cond))
+      MBB.updateTerminator();
+  }
+  return true;
+}
@@ -18,6 +18,7 @@
 #include "llvm/ADT/PriorityQueue.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveInterval.h"
@@ -72,6 +73,11 @@ using namespace llvm;
 
 #define DEBUG_TYPE "machine-scheduler"
 
+STATISTIC(NumRegionsSplit, "Number of scheduling regions split");
+STATISTIC(NumSplitRegionParts, "Number of parts split regions were split into");
+STATISTIC(NumDepPairsSaved,
+          "Number of instruction pairs not in the same region due to splits");
+
 namespace llvm {
 
 cl::opt<bool> ForceTopDown("misched-topdown", cl::Hidden,
@@ -112,6 +118,14 @@ static const bool PrintDAGs = false;
 static cl::opt<unsigned> ReadyListLimit("misched-limit", cl::Hidden,
   cl::desc("Limit ready list to N instructions"), cl::init(256));
 
+/// Avoid the superlinear cost of building and scheduling the DAG of unusually
+/// large regions, such as fully unrolled generated code, by scheduling them in
+/// parts. Off by default, because it changes the schedule of those regions.
+static cl::opt<unsigned> MaxRegionInstrs("misched-max-region-instrs",
+  cl::Hidden, cl::init(0),
+  cl::desc("Split scheduling regions with more than N instructions "
+           "(0 = unlimited)"));
+
 static cl::opt<bool> EnableRegPressure("misched-regpressure", cl::Hidden,
   cl::desc("Enable register pressure scheduling."), cl::init(true));
 
@@ -453,18 +467,58 @@ struct SchedRegion {
   MachineBasicBlock::iterator RegionEnd;
   unsigned NumRegionInstrs;
 
+  /// True if RegionEnd is not a scheduling boundary but the first instruction
+  /// of the next part of a split region.
+  bool EndsAtSplit;
+
   SchedRegion(MachineBasicBlock::iterator B, MachineBasicBlock::iterator E,
-              unsigned N) :
-    RegionBegin(B), RegionEnd(E), NumRegionInstrs(N) {}
+              unsigned N, bool EndsAtSplit = false) :
+    RegionBegin(B), RegionEnd(E), NumRegionInstrs(N),
+    EndsAtSplit(EndsAtSplit) {}
 };
 } // end anonymous namespace
 
 using MBBRegionsVector = SmallVector<SchedRegion, 16>;
 
+/// Split the region [RegionBegin, RegionEnd) into parts of at most MaxInstrs
+/// instructions of about equal size, and add them to Regions bottom-up.
+static void splitSchedRegion(MachineBasicBlock::iterator RegionBegin,
+                             MachineBasicBlock::iterator RegionEnd,
+                             unsigned NumRegionInstrs, unsigned MaxInstrs,
+                             MBBRegionsVector &Regions) {
+  unsigned NumParts = (NumRegionInstrs + MaxInstrs - 1) / MaxInstrs;
+  LLVM_DEBUG(dbgs() << "Splitting scheduling region of " << NumRegionInstrs
+                    << " instructions into " << NumParts << " parts\n");
+  ++NumRegionsSplit;
+  NumSplitRegionParts += NumParts;
+  uint64_t NumPairs = uint64_t(NumRegionInstrs) * (NumRegionInstrs - 1) / 2;
+
+  MachineBasicBlock::iterator PartEnd = RegionEnd;
+  unsigned NumLeft = NumRegionInstrs;
+  for (unsigned PartsLeft = NumParts; PartsLeft > 1; --PartsLeft) {
+    unsigned PartInstrs = NumLeft / PartsLeft;
+    // Each part begins at a non-debug instruction. Debug values between two
+    // parts stay in the upper one, with the instruction they follow.
+    MachineBasicBlock::iterator PartBegin = PartEnd;
+    for (unsigned N = 0; N < PartInstrs;)
+      if (!(--PartBegin)->isDebugInstr())
+        ++N;
+    Regions.push_back(SchedRegion(PartBegin, PartEnd, PartInstrs,
+                                  PartEnd != RegionEnd));
+    NumPairs -= uint64_t(PartInstrs) * (PartInstrs - 1) / 2;
+    NumLeft -= PartInstrs;
+    PartEnd = PartBegin;
+  }
+  Regions.push_back(SchedRegion(RegionBegin, PartEnd, NumLeft, true));
+  NumPairs -= uint64_t(NumLeft) * (NumLeft - 1) / 2;
+  NumDepPairsSaved += NumPairs;
+}
+
 static void
 getSchedRegions(MachineBasicBlock *MBB,
                 MBBRegionsVector &Regions,
-                bool RegionsTopDown) {
+                bool RegionsTopDown,
+                unsigned MaxInstrs) {
   MachineFunction *MF = MBB->getParent();
   const TargetInstrInfo *TII = MF->getSubtarget().getInstrInfo();
 
@@ -493,6 +547,11 @@ getSchedRegions(MachineBasicBlock *MBB,
       }
     }
 
+    if (MaxInstrs && NumRegionInstrs > MaxInstrs) {
+      splitSchedRegion(I, RegionEnd, NumRegionInstrs, MaxInstrs, Regions);
+      continue;
+    }
+
     // It's possible we found a scheduling region that only has debug
     // instructions. Don't bother scheduling these.
     if (NumRegionInstrs != 0)
@@ -536,13 +595,22 @@ void MachineSchedulerBase::scheduleRegions(ScheduleDAGInstrs &Scheduler,
     // exitRegion(), even for empty regions. So the local iterators 'I' and
     // 'RegionEnd' are invalid across these calls. Instructions must not be
     // added to other regions than the current one without updating MBBRegions.
+    //
+    // Large regions may be split into parts, if the scheduler allows it. When
+    // the parts are scheduled bottom-up, the part below has been reordered by
+    // the time a part is scheduled, so its end is the new first instruction
+    // of the part below rather than the one recorded in MBBRegions.
 
     MBBRegionsVector MBBRegions;
-    getSchedRegions(&*MBB, MBBRegions, Scheduler.doMBBSchedRegionsTopDown());
+    bool RegionsTopDown = Scheduler.doMBBSchedRegionsTopDown();
+    getSchedRegions(&*MBB, MBBRegions, RegionsTopDown,
+                    Scheduler.canSplitSchedRegions() ? MaxRegionInstrs : 0);
+    MachineBasicBlock::iterator PrevRegionBegin;
     for (MBBRegionsVector::iterator R = MBBRegions.begin();
          R != MBBRegions.end(); ++R) {
       MachineBasicBlock::iterator I = R->RegionBegin;
-      MachineBasicBlock::iterator RegionEnd = R->RegionEnd;
+      MachineBasicBlock::iterator RegionEnd =
+          R->EndsAtSplit && !RegionsTopDown ? PrevRegionBegin : R->RegionEnd;
       unsigned NumRegionInstrs = R->NumRegionInstrs;
 
       // Notify the scheduler of the region, even if we may skip scheduling
@@ -554,6 +622,7 @@ void MachineSchedulerBase::scheduleRegions(ScheduleDAGInstrs &Scheduler,
         // Close the current region. Bundle the terminator if needed.
         // This invalidates 'RegionEnd' and 'I'.
         Scheduler.exitRegion();
+        PrevRegionBegin = Scheduler.begin();
         continue;
       }
       LLVM_DEBUG(dbgs() << "********** MI Scheduling **********\n");
@@ -575,6 +644,7 @@ void MachineSchedulerBase::scheduleRegions(ScheduleDAGInstrs &Scheduler,
 
       // Close the current region.
       Scheduler.exitRegion();
+      PrevRegionBegin = Scheduler.begin();
     }
     Scheduler.finishBlock();
     // FIXME: Ideally, no further passes should rely on kill flags. However,
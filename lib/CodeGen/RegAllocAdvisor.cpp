@@ -0,0 +1,50 @@
+//===- RegAllocAdvisor.cpp - Greedy register allocator policy -------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the default policy of the greedy register allocator
+// and the selection of alternative policies.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/RegAllocAdvisor.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/CodeGen/LiveInterval.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorHandling.h"
+
+using namespace llvm;
+
+static cl::opt<std::string> AdvisorName(
+    "regalloc-advisor", cl::Hidden, cl::init("default"),
+    cl::desc("Name of the registered policy advisor used by the greedy "
+             "register allocator"));
+
+LLVM_INSTANTIATE_REGISTRY(RegAllocAdvisorRegistry)
+
+RegAllocAdvisor::~RegAllocAdvisor() = default;
+
+bool RegAllocAdvisor::shouldEvict(const EvictionQuery &Q) {
+  // Be fairly aggressive about following hints as long as the evictee can be
+  // split.
+  if (Q.CanSplitEvictee && Q.IsHint && !Q.BreaksHint)
+    return true;
+
+  return Q.VirtReg.weight > Q.Evictee.weight;
+}
+
+std::unique_ptr<RegAllocAdvisor> llvm::createRegAllocAdvisor() {
+  if (AdvisorName == "default")
+    return llvm::make_unique<RegAllocAdvisor>();
+
+  for (const auto &Entry : RegAllocAdvisorRegistry::entries())
+    if (Entry.getName() == AdvisorName)
+      return Entry.instantiate();
+
+  report_fatal_error("unknown register allocation advisor '" + AdvisorName +
+                     "'");
+}
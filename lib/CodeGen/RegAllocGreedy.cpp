@@ -50,6 +50,7 @@
 #include "llvm/CodeGen/MachineOperand.h"
 #include "llvm/CodeGen/MachineOptimizationRemarkEmitter.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/RegAllocAdvisor.h"
 #include "llvm/CodeGen/RegAllocRegistry.h"
 #include "llvm/CodeGen/RegisterClassInfo.h"
 #include "llvm/CodeGen/SlotIndexes.h"
@@ -65,6 +66,7 @@
 #include "llvm/Support/BranchProbability.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -142,6 +144,11 @@ static cl::opt<bool> ConsiderLocalIntervalCost(
              "candidate when choosing the best split candidate."),
     cl::init(false));
 
+static cl::opt<std::string> EvictionLogFile(
+    "regalloc-eviction-log", cl::Hidden,
+    cl::desc("Write the features and the outcome of every eviction decision "
+             "of the greedy register allocator to this file"));
+
 static RegisterRegAlloc greedyRegAlloc("greedy", "greedy register allocator",
                                        createGreedyRegisterAllocator);
 
@@ -178,6 +185,8 @@ class RAGreedy : public MachineFunctionPass,
   std::unique_ptr<Spiller> SpillerInstance;
   PQueue Queue;
   unsigned NextCascade;
+  std::unique_ptr<RegAllocAdvisor> Advisor;
+  std::unique_ptr<raw_fd_ostream> EvictionLog;
 
   // Live ranges pass through a number of stages as we try to allocate them.
   // Some of the stages may also create new live ranges:
@@ -674,6 +683,7 @@ void RAGreedy::LRE_DidCloneVirtReg(unsigned New, unsigned Old) {
 
 void RAGreedy::releaseMemory() {
   SpillerInstance.reset();
+  Advisor.reset();
   ExtraRegInfo.clear();
   GlobalCand.clear();
 }
@@ -712,8 +722,8 @@ void RAGreedy::enqueue(PQueue &CurQueue, LiveInterval *LI) {
     bool ForceGlobal = !ReverseLocal &&
       (Size / SlotIndex::InstrDist) > (2 * RC.getNumRegs());
 
-    if (ExtraRegInfo[Reg].Stage == RS_Assign && !ForceGlobal && !LI->empty() &&
-        LIS->intervalIsInOneMBB(*LI)) {
+    bool IsLocal = !LI->empty() && LIS->intervalIsInOneMBB(*LI);
+    if (ExtraRegInfo[Reg].Stage == RS_Assign && !ForceGlobal && IsLocal) {
       // Allocate original local ranges in linear instruction order. Since they
       // are singly defined, this produces optimal coloring in the absence of
       // global interference and other constraints.
@@ -736,8 +746,11 @@ void RAGreedy::enqueue(PQueue &CurQueue, LiveInterval *LI) {
     Prio |= (1u << 31);
 
     // Boost ranges that have a physical register hint.
-    if (VRM->hasKnownPreference(Reg))
+    bool HasHint = VRM->hasKnownPreference(Reg);
+    if (HasHint)
       Prio |= (1u << 30);
+
+    Prio = Advisor->getPriority({*LI, IsLocal, HasHint, Prio});
   }
   // The virtual register number is a tie breaker for same-sized ranges.
   // Give lower vreg numbers higher priority to assign them first.
@@ -847,17 +860,18 @@ unsigned RAGreedy::canReassign(LiveInterval &VirtReg, unsigned PrevReg) {
 bool RAGreedy::shouldEvict(LiveInterval &A, bool IsHint,
                            LiveInterval &B, bool BreaksHint) {
   bool CanSplit = getStage(B) < RS_Spill;
-
-  // Be fairly aggressive about following hints as long as the evictee can be
-  // split.
-  if (CanSplit && IsHint && !BreaksHint)
-    return true;
-
-  if (A.weight > B.weight) {
-    LLVM_DEBUG(dbgs() << "should evict: " << B << " w= " << B.weight << '\n');
-    return true;
-  }
-  return false;
+  bool Evict = Advisor->shouldEvict({A, B, IsHint, BreaksHint, CanSplit});
+  LLVM_DEBUG(if (Evict) dbgs()
+             << "should evict: " << B << " w= " << B.weight << '\n');
+
+  // One tab-separated line per decision: the features, then the outcome.
+  if (EvictionLog)
+    *EvictionLog << MF->getName() << '\t' << printReg(A.reg) << '\t'
+                 << A.weight << '\t' << A.getSize() << '\t'
+                 << printReg(B.reg) << '\t' << B.weight << '\t'
+                 << B.getSize() << '\t' << IsHint << '\t' << BreaksHint
+                 << '\t' << CanSplit << '\t' << Evict << '\n';
+  return Evict;
 }
 
 /// canEvictInterference - Return true if all interferences between VirtReg and
@@ -3234,6 +3248,19 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   DomTree = &getAnalysis<MachineDominatorTree>();
   ORE = &getAnalysis<MachineOptimizationRemarkEmitterPass>().getORE();
   SpillerInstance.reset(createInlineSpiller(*this, *MF, *VRM));
+  Advisor = createRegAllocAdvisor();
+  Advisor->initialize(mf);
+  if (!EvictionLogFile.empty() && !EvictionLog) {
+    std::error_code EC;
+    EvictionLog = llvm::make_unique<raw_fd_ostream>(EvictionLogFile, EC,
+                                                    sys::fs::F_Text);
+    if (EC)
+      report_fatal_error("could not open eviction log '" + EvictionLogFile +
+                         "': " + EC.message());
+    *EvictionLog << "function\tvirtreg\tweight\tsize\tevictee\t"
+                    "evictee_weight\tevictee_size\tis_hint\tbreaks_hint\t"
+                    "can_split\tevict\n";
+  }
   Loops = &getAnalysis<MachineLoopInfo>();
   Bundles = &getAnalysis<EdgeBundles>();
   SpillPlacer = &getAnalysis<SpillPlacement>();
@@ -58,9 +58,13 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/KnownBits.h"
 #include "llvm/Support/MachineValueType.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
@@ -69,6 +73,7 @@
 #include <cstdint>
 #include <functional>
 #include <iterator>
+#include <map>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -111,6 +116,124 @@ static cl::opt<bool>
   MaySplitLoadIndex("combiner-split-load-index", cl::Hidden, cl::init(true),
                     cl::desc("DAG combiner may split indexing from loads"));
 
+static cl::opt<bool>
+ProfileCombines("combiner-profile", cl::Hidden, cl::init(false),
+                cl::desc("Attribute DAG combiner time and hit counts to each "
+                         "combine and print a ranked report at exit"));
+
+static cl::opt<unsigned>
+ProfileReportLimit("combiner-profile-report-limit", cl::Hidden, cl::init(50),
+                   cl::desc("Maximum number of entries in each section of "
+                            "the DAG combiner profile report"));
+
+namespace {
+
+  /// Time and hit count of one kind of combine, e.g. the generic combine of
+  /// ISD::ADD nodes or the target combine of X86ISD::VSHLI nodes.
+  struct CombineProfileRecord {
+    uint64_t Attempts = 0;
+    uint64_t Hits = 0;
+    TimeRecord Time;
+  };
+
+  /// The -combiner-profile data of the whole process. It is printed when it
+  /// is destroyed by llvm_shutdown(), like the -time-passes report.
+  class CombineProfile {
+    sys::SmartMutex<true> Lock;
+    StringMap<CombineProfileRecord> Records;
+    /// How often a node of one kind was combined into a node of another kind.
+    /// Heavy traffic in both directions between two kinds points at combines
+    /// that undo each other.
+    std::map<std::pair<std::string, std::string>, uint64_t> Transitions;
+
+  public:
+    ~CombineProfile() {
+      if (!Records.empty())
+        print(*CreateInfoOutputFile());
+    }
+
+    void addRecord(StringRef Name, bool Hit, const TimeRecord &Time) {
+      sys::SmartScopedLock<true> Guard(Lock);
+      CombineProfileRecord &R = Records[Name];
+      ++R.Attempts;
+      if (Hit)
+        ++R.Hits;
+      R.Time += Time;
+    }
+
+    void addTransition(StringRef From, StringRef To) {
+      sys::SmartScopedLock<true> Guard(Lock);
+      ++Transitions[std::make_pair(From.str(), To.str())];
+    }
+
+    void print(raw_ostream &OS);
+  };
+
+} // end anonymous namespace
+
+static ManagedStatic<CombineProfile> TheCombineProfile;
+
+void CombineProfile::print(raw_ostream &OS) {
+  sys::SmartScopedLock<true> Guard(Lock);
+
+  std::vector<const StringMapEntry<CombineProfileRecord> *> Sorted;
+  double TotalWallTime = 0;
+  for (const auto &R : Records) {
+    Sorted.push_back(&R);
+    TotalWallTime += R.second.Time.getWallTime();
+  }
+  llvm::sort(Sorted, [](const StringMapEntry<CombineProfileRecord> *A,
+                        const StringMapEntry<CombineProfileRecord> *B) {
+    if (A->second.Time.getWallTime() != B->second.Time.getWallTime())
+      return A->second.Time.getWallTime() > B->second.Time.getWallTime();
+    return A->getKey() < B->getKey();
+  });
+
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "                          DAG combiner profile\n"
+     << "===" << std::string(73, '-') << "===\n"
+     << format("  Total wall time: %.4f seconds\n\n", TotalWallTime)
+     << "   ---Wall Time---    Attempts        Hits  Combine\n";
+  for (const auto *R : makeArrayRef(Sorted).take_front(ProfileReportLimit)) {
+    double Wall = R->second.Time.getWallTime();
+    OS << format("  %7.4f (%5.1f%%)  %10llu  %10llu  ", Wall,
+                 TotalWallTime ? Wall * 100 / TotalWallTime : 0.0,
+                 (unsigned long long)R->second.Attempts,
+                 (unsigned long long)R->second.Hits)
+       << R->getKey() << "\n";
+  }
+
+  // A pair of kinds that keep turning into each other is a combine cycle
+  // (ping-pong): rank the pairs by the traffic in the weaker direction.
+  using CycleTy = std::pair<uint64_t, const std::pair<std::string,
+                                                      std::string> *>;
+  std::vector<CycleTy> Cycles;
+  for (const auto &T : Transitions) {
+    if (T.first.first >= T.first.second)
+      continue;
+    auto Reverse =
+        Transitions.find(std::make_pair(T.first.second, T.first.first));
+    if (Reverse != Transitions.end())
+      Cycles.emplace_back(std::min(T.second, Reverse->second), &T.first);
+  }
+  llvm::sort(Cycles, [](const CycleTy &A, const CycleTy &B) {
+    if (A.first != B.first)
+      return A.first > B.first;
+    return *A.second < *B.second;
+  });
+
+  OS << "\n  Possible combine cycles:\n";
+  if (Cycles.empty())
+    OS << "    none\n";
+  for (const CycleTy &C : makeArrayRef(Cycles).take_front(ProfileReportLimit))
+    OS << "    " << C.second->first << " <-> " << C.second->second << ": "
+       << Transitions[*C.second] << " / "
+       << Transitions[std::make_pair(C.second->second, C.second->first)]
+       << " times\n";
+  OS << "\n";
+  OS.flush();
+}
+
 namespace {
 
   class DAGCombiner {
@@ -331,6 +454,22 @@ namespace {
     /// target-specific DAG combines.
     SDValue combine(SDNode *N);
 
+    /// Run \p Combine on a node of kind \p OpName and, with
+    /// -combiner-profile, attribute its time and result to \p Kind.
+    template <typename CombineFnTy>
+    SDValue profileCombine(StringRef Kind, StringRef OpName,
+                           CombineFnTy Combine) {
+      if (!ProfileCombines)
+        return Combine();
+      TimeRecord Start = TimeRecord::getCurrentTime(/*Start=*/true);
+      SDValue RV = Combine();
+      TimeRecord Elapsed = TimeRecord::getCurrentTime(/*Start=*/false);
+      Elapsed -= Start;
+      TheCombineProfile->addRecord((Kind + " " + OpName).str(),
+                                   RV.getNode() != nullptr, Elapsed);
+      return RV;
+    }
+
     // Visitation implementation - Implement dag node combining for different
     // node types.  The semantics are as follows:
     // Return Value:
@@ -1681,7 +1820,11 @@ SDValue DAGCombiner::visit(SDNode *N) {
 }
 
 SDValue DAGCombiner::combine(SDNode *N) {
-  SDValue RV = visit(N);
+  std::string OpName;
+  if (ProfileCombines)
+    OpName = N->getOperationName(&DAG);
+
+  SDValue RV = profileCombine("visit", OpName, [&] { return visit(N); });
 
   // If nothing happened, try a target-specific DAG combine.
   if (!RV.getNode()) {
@@ -1695,7 +1838,9 @@ SDValue DAGCombiner::combine(SDNode *N) {
       TargetLowering::DAGCombinerInfo
         DagCombineInfo(DAG, Level, false, this);
 
-      RV = TLI.PerformDAGCombine(N, DagCombineInfo);
+      RV = profileCombine("target", OpName, [&] {
+        return TLI.PerformDAGCombine(N, DagCombineInfo);
+      });
     }
   }
 
@@ -1709,25 +1854,33 @@ SDValue DAGCombiner::combine(SDNode *N) {
     case ISD::AND:
     case ISD::OR:
     case ISD::XOR:
-      RV = PromoteIntBinOp(SDValue(N, 0));
+      RV = profileCombine("promote", OpName,
+                          [&] { return PromoteIntBinOp(SDValue(N, 0)); });
       break;
     case ISD::SHL:
     case ISD::SRA:
     case ISD::SRL:
-      RV = PromoteIntShiftOp(SDValue(N, 0));
+      RV = profileCombine("promote", OpName,
+                          [&] { return PromoteIntShiftOp(SDValue(N, 0)); });
       break;
     case ISD::SIGN_EXTEND:
     case ISD::ZERO_EXTEND:
     case ISD::ANY_EXTEND:
-      RV = PromoteExtend(SDValue(N, 0));
+      RV = profileCombine("promote", OpName,
+                          [&] { return PromoteExtend(SDValue(N, 0)); });
       break;
     case ISD::LOAD:
-      if (PromoteLoad(SDValue(N, 0)))
-        RV = SDValue(N, 0);
+      RV = profileCombine("promote", OpName, [&] {
+        return PromoteLoad(SDValue(N, 0)) ? SDValue(N, 0) : SDValue();
+      });
       break;
     }
   }
 
+  if (ProfileCombines && RV.getNode() && RV.getNode() != N)
+    TheCombineProfile->addTransition(OpName,
+                                      RV.getNode()->getOperationName(&DAG));
+
   // If N is a commutative binary node, try eliminate it if the commuted
   // version is already present in the DAG.
   if (!RV.getNode() && TLI.isCommutativeBinOp(N->getOpcode()) &&
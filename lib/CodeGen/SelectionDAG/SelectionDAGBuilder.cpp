@@ -94,6 +94,7 @@
 #include "llvm/IR/Value.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCSymbol.h"
+#include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/AtomicOrdering.h"
 #include "llvm/Support/BranchProbability.h"
 #include "llvm/Support/Casting.h"
@@ -5547,6 +5548,22 @@ static unsigned FixedPointIntrinsicToOpcode(unsigned Intrinsic) {
   }
 }
 
+/// Read the value profile of the size operand of memory intrinsic \p I into
+/// \p Profile. Returns false if \p I has no usable profile.
+static bool getMemOpSizeProfile(const Instruction &I,
+                                MemOpSizeProfile &Profile) {
+  const uint32_t MaxNumValues = 16;
+  InstrProfValueData ValueData[MaxNumValues];
+  uint32_t NumValues;
+  if (!getValueProfDataFromInst(I, IPVK_MemOPSize, MaxNumValues, ValueData,
+                                NumValues, Profile.TotalCount) ||
+      Profile.TotalCount == 0)
+    return false;
+  for (const InstrProfValueData &VD : makeArrayRef(ValueData, NumValues))
+    Profile.Sizes.push_back(std::make_pair(VD.Value, VD.Count));
+  return true;
+}
+
 /// Lower the call to the specified intrinsic function. If we want to emit this
 /// as a call to a named external function, return the name. Otherwise, lower it
 /// and return null.
@@ -5620,6 +5637,19 @@ SelectionDAGBuilder::visitIntrinsicCall(const CallInst &I, unsigned Intrinsic) {
     unsigned Align = MinAlign(DstAlign, SrcAlign);
     bool isVol = MCI.isVolatile();
     bool isTC = I.isTailCall() && isInTailCallPosition(&I, DAG.getTarget());
+    // A memcpy of unknown size may still have a profile of the sizes it is
+    // called with, e.g. the fallback path left by PGOMemOPSizeOpt.
+    MemOpSizeProfile Profile;
+    if (!isa<ConstantSDNode>(Op3) && getMemOpSizeProfile(I, Profile)) {
+      SDValue MC = DAG.getSelectionDAGInfo().EmitTargetCodeForProfiledMemcpy(
+          DAG, sdl, getRoot(), Op1, Op2, Op3, Profile, Align, isVol,
+          MachinePointerInfo(I.getArgOperand(0)),
+          MachinePointerInfo(I.getArgOperand(1)));
+      if (MC.getNode()) {
+        DAG.setRoot(MC);
+        return nullptr;
+      }
+    }
     // FIXME: Support passing different dest/src alignments to the memcpy DAG
     // node.
     SDValue MC = DAG.getMemcpy(getRoot(), sdl, Op1, Op2, Op3, Align, isVol,
@@ -5638,6 +5668,16 @@ SelectionDAGBuilder::visitIntrinsicCall(const CallInst &I, unsigned Intrinsic) {
     unsigned Align = std::max<unsigned>(MSI.getDestAlignment(), 1);
     bool isVol = MSI.isVolatile();
     bool isTC = I.isTailCall() && isInTailCallPosition(&I, DAG.getTarget());
+    MemOpSizeProfile Profile;
+    if (!isa<ConstantSDNode>(Op3) && getMemOpSizeProfile(I, Profile)) {
+      SDValue MS = DAG.getSelectionDAGInfo().EmitTargetCodeForProfiledMemset(
+          DAG, sdl, getRoot(), Op1, Op2, Op3, Profile, Align, isVol,
+          MachinePointerInfo(I.getArgOperand(0)));
+      if (MS.getNode()) {
+        DAG.setRoot(MS);
+        return nullptr;
+      }
+    }
     SDValue MS = DAG.getMemset(getRoot(), sdl, Op1, Op2, Op3, Align, isVol,
                                isTC, MachinePointerInfo(I.getArgOperand(0)));
     updateDAGForMaybeTailCall(MS);
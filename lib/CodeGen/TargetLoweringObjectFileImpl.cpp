@@ -704,6 +704,25 @@ bool TargetLoweringObjectFileELF::shouldPutJumpTableInFunctionSection(
   return false;
 }
 
+MCSection *TargetLoweringObjectFileELF::getSectionForColdFragment(
+    const Function &F, const TargetMachine &TM) const {
+  // The cold parts of functions share one section, unless the function has a
+  // section of its own, in which case its cold part gets one too so that the
+  // linker can discard both together.
+  unsigned Flags = ELF::SHF_ALLOC | ELF::SHF_EXECINSTR;
+  StringRef Group = "";
+  if (const Comdat *C = getELFComdat(&F)) {
+    Flags |= ELF::SHF_GROUP;
+    Group = C->getName();
+  }
+
+  SmallString<128> Name(".text.split.");
+  if (TM.getFunctionSections() || !Group.empty())
+    TM.getNameWithPrefix(Name, &F, getMangler(), /*MayAlwaysUsePrivate=*/true);
+  return getContext().getELFSection(Name, ELF::SHT_PROGBITS, Flags,
+                                    /*EntrySize=*/0, Group);
+}
+
 /// Given a mergeable constant with the specified size and relocation
 /// information, return a section that it should be placed in.
 MCSection *TargetLoweringObjectFileELF::getSectionForConstant(
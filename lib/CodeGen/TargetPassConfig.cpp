@@ -122,6 +122,11 @@ static cl::opt<RunOutliner> EnableMachineOutliner(
                clEnumValN(NeverOutline, "never", "Disable all outlining"),
                // Sentinel value for unspecified option.
                clEnumValN(AlwaysOutline, "", "")));
+static cl::opt<bool> EnableMachineFunctionSplitter(
+    "split-machine-functions", cl::Hidden,
+    cl::desc("Move the cold blocks of functions with profile data to a "
+             "separate section"),
+    cl::init(false));
 // Enable or disable FastISel. Both options are needed, because
 // FastISel is enabled by default with -fast, and we wish to be
 // able to enable or disable fast-isel independently from -O0.
@@ -950,6 +955,11 @@ void TargetPassConfig::addMachinePasses() {
   if (getOptLevel() != CodeGenOpt::None)
     addBlockPlacement();
 
+  // Split functions after the final layout is known but before targets relax
+  // branches that may now cross sections.
+  if (getOptLevel() != CodeGenOpt::None && EnableMachineFunctionSplitter)
+    addPass(&MachineFunctionSplitterID);
+
   addPreEmitPass();
 
   if (TM->Options.EnableIPRA)
@@ -646,9 +646,10 @@ DWARFDie DWARFContext::getDIEForOffset(uint32_t Offset) {
   return DWARFDie();
 }
 
-bool DWARFContext::verify(raw_ostream &OS, DIDumpOptions DumpOpts) {
+bool DWARFContext::verify(raw_ostream &OS, DIDumpOptions DumpOpts,
+                          unsigned NumThreads) {
   bool Success = true;
-  DWARFVerifier verifier(OS, *this, DumpOpts);
+  DWARFVerifier verifier(OS, *this, DumpOpts, NumThreads);
 
   Success &= verifier.handleDebugAbbrev();
   if (DumpOpts.DumpType & DIDT_DebugInfo)
@@ -660,101 +661,92 @@ bool DWARFContext::verify(raw_ostream &OS, DIDumpOptions DumpOpts) {
 }
 
 const DWARFUnitIndex &DWARFContext::getCUIndex() {
-  if (CUIndex)
-    return *CUIndex;
+  llvm::call_once(CUIndexOnce, [&] {
+    DataExtractor CUIndexData(DObj->getCUIndexSection(), isLittleEndian(), 0);
 
-  DataExtractor CUIndexData(DObj->getCUIndexSection(), isLittleEndian(), 0);
-
-  CUIndex = llvm::make_unique<DWARFUnitIndex>(DW_SECT_INFO);
-  CUIndex->parse(CUIndexData);
+    CUIndex = llvm::make_unique<DWARFUnitIndex>(DW_SECT_INFO);
+    CUIndex->parse(CUIndexData);
+  });
   return *CUIndex;
 }
 
 const DWARFUnitIndex &DWARFContext::getTUIndex() {
-  if (TUIndex)
-    return *TUIndex;
-
-  DataExtractor TUIndexData(DObj->getTUIndexSection(), isLittleEndian(), 0);
+  llvm::call_once(TUIndexOnce, [&] {
+    DataExtractor TUIndexData(DObj->getTUIndexSection(), isLittleEndian(), 0);
 
-  TUIndex = llvm::make_unique<DWARFUnitIndex>(DW_SECT_TYPES);
-  TUIndex->parse(TUIndexData);
+    TUIndex = llvm::make_unique<DWARFUnitIndex>(DW_SECT_TYPES);
+    TUIndex->parse(TUIndexData);
+  });
   return *TUIndex;
 }
 
 DWARFGdbIndex &DWARFContext::getGdbIndex() {
-  if (GdbIndex)
-    return *GdbIndex;
-
-  DataExtractor GdbIndexData(DObj->getGdbIndexSection(), true /*LE*/, 0);
-  GdbIndex = llvm::make_unique<DWARFGdbIndex>();
-  GdbIndex->parse(GdbIndexData);
+  llvm::call_once(GdbIndexOnce, [&] {
+    DataExtractor GdbIndexData(DObj->getGdbIndexSection(), true /*LE*/, 0);
+    GdbIndex = llvm::make_unique<DWARFGdbIndex>();
+    GdbIndex->parse(GdbIndexData);
+  });
   return *GdbIndex;
 }
 
 const DWARFDebugAbbrev *DWARFContext::getDebugAbbrev() {
-  if (Abbrev)
-    return Abbrev.get();
+  llvm::call_once(AbbrevOnce, [&] {
+    DataExtractor abbrData(DObj->getAbbrevSection(), isLittleEndian(), 0);
 
-  DataExtractor abbrData(DObj->getAbbrevSection(), isLittleEndian(), 0);
-
-  Abbrev.reset(new DWARFDebugAbbrev());
-  Abbrev->extract(abbrData);
+    Abbrev.reset(new DWARFDebugAbbrev());
+    Abbrev->extract(abbrData);
+  });
   return Abbrev.get();
 }
 
 const DWARFDebugAbbrev *DWARFContext::getDebugAbbrevDWO() {
-  if (AbbrevDWO)
-    return AbbrevDWO.get();
-
-  DataExtractor abbrData(DObj->getAbbrevDWOSection(), isLittleEndian(), 0);
-  AbbrevDWO.reset(new DWARFDebugAbbrev());
-  AbbrevDWO->extract(abbrData);
+  llvm::call_once(AbbrevDWOOnce, [&] {
+    DataExtractor abbrData(DObj->getAbbrevDWOSection(), isLittleEndian(), 0);
+    AbbrevDWO.reset(new DWARFDebugAbbrev());
+    AbbrevDWO->extract(abbrData);
+  });
   return AbbrevDWO.get();
 }
 
 const DWARFDebugLoc *DWARFContext::getDebugLoc() {
-  if (Loc)
-    return Loc.get();
-
-  Loc.reset(new DWARFDebugLoc);
-  // Assume all units have the same address byte size.
-  if (getNumCompileUnits()) {
-    DWARFDataExtractor LocData(*DObj, DObj->getLocSection(), isLittleEndian(),
-                               getUnitAtIndex(0)->getAddressByteSize());
-    Loc->parse(LocData);
-  }
+  llvm::call_once(LocOnce, [&] {
+    Loc.reset(new DWARFDebugLoc);
+    // Assume all units have the same address byte size.
+    if (getNumCompileUnits()) {
+      DWARFDataExtractor LocData(*DObj, DObj->getLocSection(),
+                                 isLittleEndian(),
+                                 getUnitAtIndex(0)->getAddressByteSize());
+      Loc->parse(LocData);
+    }
+  });
   return Loc.get();
 }
 
 const DWARFDebugLoclists *DWARFContext::getDebugLocDWO() {
-  if (LocDWO)
-    return LocDWO.get();
-
-  LocDWO.reset(new DWARFDebugLoclists());
-  // Assume all compile units have the same address byte size.
-  // FIXME: We don't need AddressSize for split DWARF since relocatable
-  // addresses cannot appear there. At the moment DWARFExpression requires it.
-  DataExtractor LocData(DObj->getLocDWOSection().Data, isLittleEndian(), 4);
-  // Use version 4. DWO does not support the DWARF v5 .debug_loclists yet and
-  // that means we are parsing the new style .debug_loc (pre-standatized version
-  // of the .debug_loclists).
-  LocDWO->parse(LocData, 4 /* Version */);
+  llvm::call_once(LocDWOOnce, [&] {
+    LocDWO.reset(new DWARFDebugLoclists());
+    // Assume all compile units have the same address byte size.
+    // FIXME: We don't need AddressSize for split DWARF since relocatable
+    // addresses cannot appear there. At the moment DWARFExpression requires
+    // it.
+    DataExtractor LocData(DObj->getLocDWOSection().Data, isLittleEndian(), 4);
+    // Use version 4. DWO does not support the DWARF v5 .debug_loclists yet and
+    // that means we are parsing the new style .debug_loc (pre-standatized
+    // version of the .debug_loclists).
+    LocDWO->parse(LocData, 4 /* Version */);
+  });
   return LocDWO.get();
 }
 
 const DWARFDebugAranges *DWARFContext::getDebugAranges() {
-  if (Aranges)
-    return Aranges.get();
-
-  Aranges.reset(new DWARFDebugAranges());
-  Aranges->generate(this);
+  llvm::call_once(ArangesOnce, [&] {
+    Aranges.reset(new DWARFDebugAranges());
+    Aranges->generate(this);
+  });
   return Aranges.get();
 }
 
 const DWARFDebugFrame *DWARFContext::getDebugFrame() {
-  if (DebugFrame)
-    return DebugFrame.get();
-
   // There's a "bug" in the DWARFv3 standard with respect to the target address
   // size within debug frame sections. While DWARF is supposed to be independent
   // of its container, FDEs have fields with size being "target address size",
@@ -764,72 +756,75 @@ const DWARFDebugFrame *DWARFContext::getDebugFrame() {
   // provides this information). This problem is fixed in DWARFv4
   // See this dwarf-discuss discussion for more details:
   // http://lists.dwarfstd.org/htdig.cgi/dwarf-discuss-dwarfstd.org/2011-December/001173.html
-  DWARFDataExtractor debugFrameData(DObj->getDebugFrameSection(),
-                                    isLittleEndian(), DObj->getAddressSize());
-  DebugFrame.reset(new DWARFDebugFrame(getArch(), false /* IsEH */));
-  DebugFrame->parse(debugFrameData);
+  llvm::call_once(DebugFrameOnce, [&] {
+    DWARFDataExtractor debugFrameData(DObj->getDebugFrameSection(),
+                                      isLittleEndian(), DObj->getAddressSize());
+    DebugFrame.reset(new DWARFDebugFrame(getArch(), false /* IsEH */));
+    DebugFrame->parse(debugFrameData);
+  });
   return DebugFrame.get();
 }
 
 const DWARFDebugFrame *DWARFContext::getEHFrame() {
-  if (EHFrame)
-    return EHFrame.get();
-
-  DWARFDataExtractor debugFrameData(DObj->getEHFrameSection(), isLittleEndian(),
-                                    DObj->getAddressSize());
-  DebugFrame.reset(new DWARFDebugFrame(getArch(), true /* IsEH */));
-  DebugFrame->parse(debugFrameData);
-  return DebugFrame.get();
+  llvm::call_once(EHFrameOnce, [&] {
+    DWARFDataExtractor debugFrameData(DObj->getEHFrameSection(),
+                                      isLittleEndian(), DObj->getAddressSize());
+    EHFrame.reset(new DWARFDebugFrame(getArch(), true /* IsEH */));
+    EHFrame->parse(debugFrameData);
+  });
+  return EHFrame.get();
 }
 
 const DWARFDebugMacro *DWARFContext::getDebugMacro() {
-  if (Macro)
-    return Macro.get();
-
-  DataExtractor MacinfoData(DObj->getMacinfoSection(), isLittleEndian(), 0);
-  Macro.reset(new DWARFDebugMacro());
-  Macro->parse(MacinfoData);
+  llvm::call_once(MacroOnce, [&] {
+    DataExtractor MacinfoData(DObj->getMacinfoSection(), isLittleEndian(), 0);
+    Macro.reset(new DWARFDebugMacro());
+    Macro->parse(MacinfoData);
+  });
   return Macro.get();
 }
 
 template <typename T>
-static T &getAccelTable(std::unique_ptr<T> &Cache, const DWARFObject &Obj,
-                        const DWARFSection &Section, StringRef StringSection,
-                        bool IsLittleEndian) {
-  if (Cache)
-    return *Cache;
-  DWARFDataExtractor AccelSection(Obj, Section, IsLittleEndian, 0);
-  DataExtractor StrData(StringSection, IsLittleEndian, 0);
-  Cache.reset(new T(AccelSection, StrData));
-  if (Error E = Cache->extract())
-    llvm::consumeError(std::move(E));
+static T &getAccelTable(std::unique_ptr<T> &Cache, llvm::once_flag &Once,
+                        const DWARFObject &Obj, const DWARFSection &Section,
+                        StringRef StringSection, bool IsLittleEndian) {
+  llvm::call_once(Once, [&] {
+    DWARFDataExtractor AccelSection(Obj, Section, IsLittleEndian, 0);
+    DataExtractor StrData(StringSection, IsLittleEndian, 0);
+    Cache.reset(new T(AccelSection, StrData));
+    if (Error E = Cache->extract())
+      llvm::consumeError(std::move(E));
+  });
   return *Cache;
 }
 
 const DWARFDebugNames &DWARFContext::getDebugNames() {
-  return getAccelTable(Names, *DObj, DObj->getDebugNamesSection(),
+  return getAccelTable(Names, NamesOnce, *DObj, DObj->getDebugNamesSection(),
                        DObj->getStringSection(), isLittleEndian());
 }
 
 const AppleAcceleratorTable &DWARFContext::getAppleNames() {
-  return getAccelTable(AppleNames, *DObj, DObj->getAppleNamesSection(),
-                       DObj->getStringSection(), isLittleEndian());
+  return getAccelTable(AppleNames, AppleNamesOnce, *DObj,
+                       DObj->getAppleNamesSection(), DObj->getStringSection(),
+                       isLittleEndian());
 }
 
 const AppleAcceleratorTable &DWARFContext::getAppleTypes() {
-  return getAccelTable(AppleTypes, *DObj, DObj->getAppleTypesSection(),
-                       DObj->getStringSection(), isLittleEndian());
+  return getAccelTable(AppleTypes, AppleTypesOnce, *DObj,
+                       DObj->getAppleTypesSection(), DObj->getStringSection(),
+                       isLittleEndian());
 }
 
 const AppleAcceleratorTable &DWARFContext::getAppleNamespaces() {
-  return getAccelTable(AppleNamespaces, *DObj,
+  return getAccelTable(AppleNamespaces, AppleNamespacesOnce, *DObj,
                        DObj->getAppleNamespacesSection(),
                        DObj->getStringSection(), isLittleEndian());
 }
 
 const AppleAcceleratorTable &DWARFContext::getAppleObjC() {
-  return getAccelTable(AppleObjC, *DObj, DObj->getAppleObjCSection(),
-                       DObj->getStringSection(), isLittleEndian());
+  return getAccelTable(AppleObjC, AppleObjCOnce, *DObj,
+                       DObj->getAppleObjCSection(), DObj->getStringSection(),
+                       isLittleEndian());
 }
 
 const DWARFDebugLine::LineTable *
@@ -845,8 +840,7 @@ DWARFContext::getLineTableForUnit(DWARFUnit *U) {
 
 Expected<const DWARFDebugLine::LineTable *> DWARFContext::getLineTableForUnit(
     DWARFUnit *U, std::function<void(Error)> RecoverableErrorCallback) {
-  if (!Line)
-    Line.reset(new DWARFDebugLine);
+  llvm::call_once(LineOnce, [&] { Line.reset(new DWARFDebugLine); });
 
   auto UnitDIE = U->getUnitDIE();
   if (!UnitDIE)
@@ -873,18 +867,19 @@ Expected<const DWARFDebugLine::LineTable *> DWARFContext::getLineTableForUnit(
 }
 
 void DWARFContext::parseNormalUnits() {
-  if (!NormalUnits.empty())
-    return;
-  DObj->forEachInfoSections([&](const DWARFSection &S) {
-    NormalUnits.addUnitsForSection(*this, S, DW_SECT_INFO);
-  });
-  NormalUnits.finishedInfoUnits();
-  DObj->forEachTypesSections([&](const DWARFSection &S) {
-    NormalUnits.addUnitsForSection(*this, S, DW_SECT_TYPES);
+  llvm::call_once(NormalUnitsOnce, [&] {
+    DObj->forEachInfoSections([&](const DWARFSection &S) {
+      NormalUnits.addUnitsForSection(*this, S, DW_SECT_INFO);
+    });
+    NormalUnits.finishedInfoUnits();
+    DObj->forEachTypesSections([&](const DWARFSection &S) {
+      NormalUnits.addUnitsForSection(*this, S, DW_SECT_TYPES);
+    });
   });
 }
 
 void DWARFContext::parseDWOUnits(bool Lazy) {
+  std::lock_guard<std::mutex> Lock(DWOUnitsMutex);
   if (!DWOUnits.empty())
     return;
   DObj->forEachInfoDWOSections([&](const DWARFSection &S) {
@@ -994,46 +989,59 @@ DILineInfo DWARFContext::getLineInfoForAddress(object::SectionedAddress Address,
 DILineInfoTable DWARFContext::getLineInfoForAddressRange(
     object::SectionedAddress Address, uint64_t Size, DILineInfoSpecifier Spec) {
   DILineInfoTable  Lines;
-  DWARFCompileUnit *CU = getCompileUnitForAddress(Address.Address);
-  if (!CU)
-    return Lines;
-
-  std::string FunctionName = "<invalid>";
-  uint32_t StartLine = 0;
-  getFunctionNameAndStartLineForAddress(CU, Address.Address, Spec.FNKind,
-                                        FunctionName, StartLine);
 
   // If the Specifier says we don't need FileLineInfo, just
   // return the top-most function at the starting address.
   if (Spec.FLIKind == FileLineInfoKind::None) {
+    DWARFCompileUnit *CU = getCompileUnitForAddress(Address.Address);
+    if (!CU)
+      return Lines;
     DILineInfo Result;
-    Result.FunctionName = FunctionName;
-    Result.StartLine = StartLine;
+    getFunctionNameAndStartLineForAddress(CU, Address.Address, Spec.FNKind,
+                                          Result.FunctionName,
+                                          Result.StartLine);
     Lines.push_back(std::make_pair(Address.Address, Result));
     return Lines;
   }
 
-  const DWARFLineTable *LineTable = getLineTableForUnit(CU);
+  // The range may cover code of several compile units, e.g. when it is a
+  // stretch of a binary without symbols. Look up each part in the line table
+  // of the unit that describes it.
+  getDebugAranges()->forEachUnitInRange(
+      Address.Address, Address.Address + Size,
+      [&](uint32_t CUOffset, uint64_t LowPC, uint64_t HighPC) {
+        DWARFCompileUnit *CU = getCompileUnitForOffset(CUOffset);
+        if (!CU)
+          return;
+        const DWARFLineTable *LineTable = getLineTableForUnit(CU);
+        if (!LineTable)
+          return;
 
-  // Get the index of row we're looking for in the line table.
-  std::vector<uint32_t> RowVector;
-  if (!LineTable->lookupAddressRange({Address.Address, Address.SectionIndex},
-                                     Size, RowVector)) {
-    return Lines;
-  }
+        // Get the index of row we're looking for in the line table.
+        std::vector<uint32_t> RowVector;
+        if (!LineTable->lookupAddressRange({LowPC, Address.SectionIndex},
+                                           HighPC - LowPC, RowVector))
+          return;
 
-  for (uint32_t RowIndex : RowVector) {
-    // Take file number and line/column from the row.
-    const DWARFDebugLine::Row &Row = LineTable->Rows[RowIndex];
-    DILineInfo Result;
-    LineTable->getFileNameByIndex(Row.File, CU->getCompilationDir(),
-                                  Spec.FLIKind, Result.FileName);
-    Result.FunctionName = FunctionName;
-    Result.Line = Row.Line;
-    Result.Column = Row.Column;
-    Result.StartLine = StartLine;
-    Lines.push_back(std::make_pair(Row.Address.Address, Result));
-  }
+        std::string FunctionName = "<invalid>";
+        uint32_t StartLine = 0;
+        getFunctionNameAndStartLineForAddress(CU, LowPC, Spec.FNKind,
+                                              FunctionName, StartLine);
+
+        for (uint32_t RowIndex : RowVector) {
+          // Take file number and line/column from the row.
+          const DWARFDebugLine::Row &Row = LineTable->Rows[RowIndex];
+          DILineInfo Result;
+          LineTable->getFileNameByIndex(Row.File, CU->getCompilationDir(),
+                                        Spec.FLIKind, Result.FileName);
+          Result.FunctionName = FunctionName;
+          Result.Line = Row.Line;
+          Result.Column = Row.Column;
+          Result.StartLine = StartLine;
+          Result.Source = LineTable->getSourceByIndex(Row.File, Spec.FLIKind);
+          Lines.push_back(std::make_pair(Row.Address.Address, Result));
+        }
+      });
 
   return Lines;
 }
@@ -1106,6 +1114,7 @@ DWARFContext::getInliningInfoForAddress(object::SectionedAddress Address,
 
 std::shared_ptr<DWARFContext>
 DWARFContext::getDWOContext(StringRef AbsolutePath) {
+  std::lock_guard<std::mutex> Lock(DWOFilesMutex);
   if (auto S = DWP.lock()) {
     DWARFContext *Ctxt = S->Context.get();
     return std::shared_ptr<DWARFContext>(std::move(S), Ctxt);
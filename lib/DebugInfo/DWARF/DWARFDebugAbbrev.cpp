@@ -80,6 +80,7 @@ void DWARFDebugAbbrev::extract(DataExtractor Data) {
 }
 
 void DWARFDebugAbbrev::parse() const {
+  std::lock_guard<std::mutex> Lock(Mutex);
   if (!Data)
     return;
   uint32_t Offset = 0;
@@ -112,6 +113,7 @@ void DWARFDebugAbbrev::dump(raw_ostream &OS) const {
 
 const DWARFAbbreviationDeclarationSet*
 DWARFDebugAbbrev::getAbbreviationDeclarationSet(uint64_t CUAbbrOffset) const {
+  std::lock_guard<std::mutex> Lock(Mutex);
   const auto End = AbbrDeclSets.end();
   if (PrevAbbrOffsetPos != End && PrevAbbrOffsetPos->first == CUAbbrOffset) {
     return &(PrevAbbrOffsetPos->second);
@@ -120,3 +120,14 @@ uint32_t DWARFDebugAranges::findAddress(uint64_t Address) const {
     return It->CUOffset;
   return -1U;
 }
+
+void DWARFDebugAranges::forEachUnitInRange(
+    uint64_t LowPC, uint64_t HighPC,
+    function_ref<void(uint32_t CUOffset, uint64_t LowPC, uint64_t HighPC)> Fn)
+    const {
+  RangeCollIterator It =
+      llvm::bsearch(Aranges, [=](Range RHS) { return LowPC < RHS.HighPC(); });
+  for (; It != Aranges.end() && It->LowPC < HighPC; ++It)
+    Fn(It->CUOffset, std::max(LowPC, It->LowPC),
+       std::min(HighPC, It->HighPC()));
+}
@@ -448,6 +448,7 @@ void DWARFDebugLine::ParsingState::appendRowToMatrix() {
 
 const DWARFDebugLine::LineTable *
 DWARFDebugLine::getLineTable(uint32_t Offset) const {
+  std::lock_guard<std::mutex> Lock(LineTableMutex);
   LineTableConstIter Pos = LineTableMap.find(Offset);
   if (Pos != LineTableMap.end())
     return &Pos->second;
@@ -462,6 +463,7 @@ Expected<const DWARFDebugLine::LineTable *> DWARFDebugLine::getOrParseLineTable(
                        " is not a valid debug line section offset",
                        Offset);
 
+  std::lock_guard<std::mutex> Lock(LineTableMutex);
   std::pair<LineTableIter, bool> Pos =
       LineTableMap.insert(LineTableMapTy::value_type(Offset, LineTable()));
   LineTable *LT = &Pos.first->second;
@@ -926,14 +928,16 @@ bool DWARFDebugLine::LineTable::lookupAddressRangeImpl(
   if (Sequences.empty())
     return false;
   uint64_t EndAddr = Address.Address + Size;
-  // First, find an instruction sequence containing the given address.
+  // First, find the first instruction sequence that ends after the given
+  // address. The range does not have to start inside of it.
   DWARFDebugLine::Sequence Sequence;
   Sequence.SectionIndex = Address.SectionIndex;
   Sequence.HighPC = Address.Address;
   SequenceIter LastSeq = Sequences.end();
   SequenceIter SeqPos = llvm::upper_bound(
       Sequences, Sequence, DWARFDebugLine::Sequence::orderByHighPC);
-  if (SeqPos == LastSeq || !SeqPos->containsPC(Address))
+  if (SeqPos == LastSeq || SeqPos->SectionIndex != Address.SectionIndex ||
+      SeqPos->LowPC >= EndAddr)
     return false;
 
   SequenceIter StartPos = SeqPos;
@@ -941,12 +945,13 @@ bool DWARFDebugLine::LineTable::lookupAddressRangeImpl(
   // Add the rows from the first sequence to the vector, starting with the
   // index we just calculated
 
-  while (SeqPos != LastSeq && SeqPos->LowPC < EndAddr) {
+  while (SeqPos != LastSeq && SeqPos->SectionIndex == Address.SectionIndex &&
+         SeqPos->LowPC < EndAddr) {
     const DWARFDebugLine::Sequence &CurSeq = *SeqPos;
     // For the first sequence, we need to find which row in the sequence is the
     // first in our range.
     uint32_t FirstRowIndex = CurSeq.FirstRowIndex;
-    if (SeqPos == StartPos)
+    if (SeqPos == StartPos && CurSeq.containsPC(Address))
       FirstRowIndex = findRowInSeq(CurSeq, Address);
 
     // Figure out the last row in the range.
@@ -958,8 +963,11 @@ bool DWARFDebugLine::LineTable::lookupAddressRangeImpl(
     assert(FirstRowIndex != UnknownRowIndex);
     assert(LastRowIndex != UnknownRowIndex);
 
+    // The end_sequence row only marks the first address after the sequence.
+    // Leave it out so that nothing past the sequence is given a line.
     for (uint32_t I = FirstRowIndex; I <= LastRowIndex; ++I) {
-      Result.push_back(I);
+      if (!Rows[I].EndSequence)
+        Result.push_back(I);
     }
 
     ++SeqPos;
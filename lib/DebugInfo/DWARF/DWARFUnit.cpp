@@ -27,6 +27,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -127,6 +128,7 @@ DWARFUnit *DWARFUnitVector::addUnit(std::unique_ptr<DWARFUnit> Unit) {
 }
 
 DWARFUnit *DWARFUnitVector::getUnitForOffset(uint32_t Offset) const {
+  std::lock_guard<std::mutex> Lock(LookupMutex);
   auto end = begin() + getNumInfoUnits();
   auto *CU =
       std::upper_bound(begin(), end, Offset,
@@ -145,6 +147,7 @@ DWARFUnitVector::getUnitForIndexEntry(const DWARFUnitIndex::Entry &E) {
     return nullptr;
 
   auto Offset = CUOff->Offset;
+  std::lock_guard<std::mutex> Lock(LookupMutex);
   auto end = begin() + getNumInfoUnits();
 
   auto *CU =
@@ -322,7 +325,7 @@ parseRngListTableHeader(DWARFDataExtractor &DA, uint32_t Offset) {
 Error DWARFUnit::extractRangeList(uint32_t RangeListOffset,
                                   DWARFDebugRangeList &RangeList) const {
   // Require that compile unit is extracted.
-  assert(!DieArray.empty());
+  assert(Extracted != NoDIEs);
   DWARFDataExtractor RangesData(Context.getDWARFObj(), *RangeSection,
                                 isLittleEndian, getAddressByteSize());
   uint32_t ActualRangeListOffset = RangeSectionBase + RangeListOffset;
@@ -397,85 +400,107 @@ void DWARFUnit::extractDIEsToVector(
 }
 
 size_t DWARFUnit::extractDIEsIfNeeded(bool CUDieOnly) {
-  if ((CUDieOnly && !DieArray.empty()) ||
-      DieArray.size() > 1)
+  ExtractionState Wanted = CUDieOnly ? UnitDIEOnly : AllDIEs;
+  if (Extracted.load(std::memory_order_acquire) >= Wanted)
     return 0; // Already parsed.
 
-  bool HasCUDie = !DieArray.empty();
-  extractDIEsToVector(!HasCUDie, !CUDieOnly, DieArray);
+  std::lock_guard<std::recursive_mutex> Lock(Mutex);
+  ExtractionState State = Extracted.load(std::memory_order_relaxed);
+  if (State >= Wanted)
+    return 0;
+
+  if (CUDieOnly) {
+    std::vector<DWARFDebugInfoEntry> Dies;
+    extractDIEsToVector(true, false, Dies);
+    if (Dies.empty())
+      return 0;
+    UnitDieEntry = Dies[0];
+    readUnitDIEAttributes(UnitDieEntry);
+    Extracted.store(UnitDIEOnly, std::memory_order_release);
+    return 1;
+  }
 
+  // Nothing reads DieArray before the state becomes AllDIEs, so the DIEs are
+  // extracted into it directly. The unit DIE is extracted again rather than
+  // copied from UnitDieEntry, which other threads may be reading.
+  extractDIEsToVector(true, true, DieArray);
   if (DieArray.empty())
     return 0;
+  if (State == NoDIEs) {
+    UnitDieEntry = DieArray[0];
+    readUnitDIEAttributes(UnitDieEntry);
+  }
+  Extracted.store(AllDIEs, std::memory_order_release);
+  return DieArray.size();
+}
 
-  // If CU DIE was just parsed, copy several attribute values from it.
-  if (!HasCUDie) {
-    DWARFDie UnitDie = getUnitDIE();
-    if (Optional<uint64_t> DWOId = toUnsigned(UnitDie.find(DW_AT_GNU_dwo_id)))
-      Header.setDWOId(*DWOId);
-    if (!IsDWO) {
-      assert(AddrOffsetSectionBase == 0);
-      assert(RangeSectionBase == 0);
-      AddrOffsetSectionBase = toSectionOffset(UnitDie.find(DW_AT_addr_base), 0);
-      if (!AddrOffsetSectionBase)
-        AddrOffsetSectionBase =
-            toSectionOffset(UnitDie.find(DW_AT_GNU_addr_base), 0);
-      RangeSectionBase = toSectionOffset(UnitDie.find(DW_AT_rnglists_base), 0);
-    }
+void DWARFUnit::readUnitDIEAttributes(const DWARFDebugInfoEntry &Die) {
+  DWARFDie UnitDie(this, &Die);
+  if (Optional<uint64_t> DWOId = toUnsigned(UnitDie.find(DW_AT_GNU_dwo_id)))
+    Header.setDWOId(*DWOId);
+  if (!IsDWO) {
+    assert(AddrOffsetSectionBase == 0);
+    assert(RangeSectionBase == 0);
+    AddrOffsetSectionBase = toSectionOffset(UnitDie.find(DW_AT_addr_base), 0);
+    if (!AddrOffsetSectionBase)
+      AddrOffsetSectionBase =
+          toSectionOffset(UnitDie.find(DW_AT_GNU_addr_base), 0);
+    RangeSectionBase = toSectionOffset(UnitDie.find(DW_AT_rnglists_base), 0);
+  }
 
-    // In general, in DWARF v5 and beyond we derive the start of the unit's
-    // contribution to the string offsets table from the unit DIE's
-    // DW_AT_str_offsets_base attribute. Split DWARF units do not use this
-    // attribute, so we assume that there is a contribution to the string
-    // offsets table starting at offset 0 of the debug_str_offsets.dwo section.
-    // In both cases we need to determine the format of the contribution,
-    // which may differ from the unit's format.
-    DWARFDataExtractor DA(Context.getDWARFObj(), StringOffsetSection,
-                          isLittleEndian, 0);
+  // In general, in DWARF v5 and beyond we derive the start of the unit's
+  // contribution to the string offsets table from the unit DIE's
+  // DW_AT_str_offsets_base attribute. Split DWARF units do not use this
+  // attribute, so we assume that there is a contribution to the string
+  // offsets table starting at offset 0 of the debug_str_offsets.dwo section.
+  // In both cases we need to determine the format of the contribution,
+  // which may differ from the unit's format.
+  DWARFDataExtractor DA(Context.getDWARFObj(), StringOffsetSection,
+                        isLittleEndian, 0);
+  if (IsDWO)
+    StringOffsetsTableContribution =
+        determineStringOffsetsTableContributionDWO(DA);
+  else if (getVersion() >= 5)
+    StringOffsetsTableContribution =
+        determineStringOffsetsTableContribution(
+            DA, toSectionOffset(UnitDie.find(DW_AT_str_offsets_base), 0));
+
+  // DWARF v5 uses the .debug_rnglists and .debug_rnglists.dwo sections to
+  // describe address ranges.
+  if (getVersion() >= 5) {
     if (IsDWO)
-      StringOffsetsTableContribution =
-          determineStringOffsetsTableContributionDWO(DA);
-    else if (getVersion() >= 5)
-      StringOffsetsTableContribution =
-          determineStringOffsetsTableContribution(DA);
-
-    // DWARF v5 uses the .debug_rnglists and .debug_rnglists.dwo sections to
-    // describe address ranges.
-    if (getVersion() >= 5) {
-      if (IsDWO)
-        setRangesSection(&Context.getDWARFObj().getRnglistsDWOSection(), 0);
+      setRangesSection(&Context.getDWARFObj().getRnglistsDWOSection(), 0);
+    else
+      setRangesSection(&Context.getDWARFObj().getRnglistsSection(),
+                       toSectionOffset(UnitDie.find(DW_AT_rnglists_base), 0));
+    if (RangeSection->Data.size()) {
+      // Parse the range list table header. Individual range lists are
+      // extracted lazily.
+      DWARFDataExtractor RangesDA(Context.getDWARFObj(), *RangeSection,
+                                  isLittleEndian, 0);
+      if (auto TableOrError =
+              parseRngListTableHeader(RangesDA, RangeSectionBase))
+        RngListTable = TableOrError.get();
       else
-        setRangesSection(&Context.getDWARFObj().getRnglistsSection(),
-                         toSectionOffset(UnitDie.find(DW_AT_rnglists_base), 0));
-      if (RangeSection->Data.size()) {
-        // Parse the range list table header. Individual range lists are
-        // extracted lazily.
-        DWARFDataExtractor RangesDA(Context.getDWARFObj(), *RangeSection,
-                                    isLittleEndian, 0);
-        if (auto TableOrError =
-                parseRngListTableHeader(RangesDA, RangeSectionBase))
-          RngListTable = TableOrError.get();
-        else
-          WithColor::error() << "parsing a range list table: "
-                             << toString(TableOrError.takeError())
-                             << '\n';
-
-        // In a split dwarf unit, there is no DW_AT_rnglists_base attribute.
-        // Adjust RangeSectionBase to point past the table header.
-        if (IsDWO && RngListTable)
-          RangeSectionBase = RngListTable->getHeaderSize();
-      }
-    }
-
-    // Don't fall back to DW_AT_GNU_ranges_base: it should be ignored for
-    // skeleton CU DIE, so that DWARF users not aware of it are not broken.
+        WithColor::error() << "parsing a range list table: "
+                           << toString(TableOrError.takeError())
+                           << '\n';
+
+      // In a split dwarf unit, there is no DW_AT_rnglists_base attribute.
+      // Adjust RangeSectionBase to point past the table header.
+      if (IsDWO && RngListTable)
+        RangeSectionBase = RngListTable->getHeaderSize();
     }
+  }
 
-  return DieArray.size();
+  // Don't fall back to DW_AT_GNU_ranges_base: it should be ignored for
+  // skeleton CU DIE, so that DWARF users not aware of it are not broken.
 }
 
 bool DWARFUnit::parseDWO() {
   if (IsDWO)
     return false;
+  std::lock_guard<std::recursive_mutex> Lock(Mutex);
   if (DWO.get())
     return false;
   DWARFDie UnitDie = getUnitDIE();
@@ -525,10 +550,13 @@ bool DWARFUnit::parseDWO() {
 }
 
 void DWARFUnit::clearDIEs(bool KeepCUDie) {
-  if (DieArray.size() > (unsigned)KeepCUDie) {
-    DieArray.resize((unsigned)KeepCUDie);
-    DieArray.shrink_to_fit();
-  }
+  // The unit DIE stays in UnitDieEntry.
+  DieArray.clear();
+  DieArray.shrink_to_fit();
+  if (!KeepCUDie)
+    Extracted = NoDIEs;
+  else if (Extracted == AllDIEs)
+    Extracted = UnitDIEOnly;
 }
 
 Expected<DWARFAddressRangesVector>
@@ -612,6 +640,7 @@ void DWARFUnit::updateAddressDieMap(DWARFDie Die) {
 
 DWARFDie DWARFUnit::getSubroutineForAddress(uint64_t Address) {
   extractDIEsIfNeeded(false);
+  std::lock_guard<std::recursive_mutex> Lock(Mutex);
   if (AddrDieMap.empty())
     updateAddressDieMap(getUnitDIE());
   auto R = AddrDieMap.upper_bound(Address);
@@ -713,7 +742,9 @@ DWARFDie DWARFUnit::getPreviousSibling(const DWARFDebugInfoEntry *Die) {
 }
 
 DWARFDie DWARFUnit::getFirstChild(const DWARFDebugInfoEntry *Die) {
-  if (!Die->hasChildren())
+  // The children of a unit DIE are only known once all DIEs are extracted.
+  if (!Die->hasChildren() ||
+      Extracted.load(std::memory_order_acquire) != AllDIEs)
     return DWARFDie();
 
   // We do not want access out of bounds when parsing corrupted debug data.
@@ -724,7 +755,8 @@ DWARFDie DWARFUnit::getFirstChild(const DWARFDebugInfoEntry *Die) {
 }
 
 DWARFDie DWARFUnit::getLastChild(const DWARFDebugInfoEntry *Die) {
-  if (!Die->hasChildren())
+  if (!Die->hasChildren() ||
+      Extracted.load(std::memory_order_acquire) != AllDIEs)
     return DWARFDie();
 
   uint32_t Depth = Die->getDepth();
@@ -745,6 +777,7 @@ const DWARFAbbreviationDeclarationSet *DWARFUnit::getAbbreviations() const {
 }
 
 llvm::Optional<object::SectionedAddress> DWARFUnit::getBaseAddress() {
+  std::lock_guard<std::recursive_mutex> Lock(Mutex);
   if (BaseAddr)
     return BaseAddr;
 
@@ -803,8 +836,8 @@ parseDWARF32StringOffsetsTableHeader(DWARFDataExtractor &DA, uint32_t Offset) {
 }
 
 Optional<StrOffsetsContributionDescriptor>
-DWARFUnit::determineStringOffsetsTableContribution(DWARFDataExtractor &DA) {
-  auto Offset = toSectionOffset(getUnitDIE().find(DW_AT_str_offsets_base), 0);
+DWARFUnit::determineStringOffsetsTableContribution(DWARFDataExtractor &DA,
+                                                   uint64_t Offset) {
   Optional<StrOffsetsContributionDescriptor> Descriptor;
   // Attempt to find a DWARF64 contribution 16 bytes before the base.
   if (Offset >= 16)
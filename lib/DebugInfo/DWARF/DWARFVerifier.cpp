@@ -16,6 +16,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFSection.h"
 #include "llvm/Support/DJB.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
@@ -283,10 +284,21 @@ unsigned DWARFVerifier::verifyUnitSection(const DWARFSection &S,
   bool hasDIE = DebugInfoData.isValidOffset(Offset);
   DWARFUnitVector TypeUnitVector;
   DWARFUnitVector CompileUnitVector;
+  // With several threads, the units are only collected here along with the
+  // report on their header, and verified once all of them are known.
+  std::vector<PendingUnit> PendingUnits;
   while (hasDIE) {
     OffsetStart = Offset;
-    if (!verifyUnitHeader(DebugInfoData, &Offset, UnitIdx, UnitType,
-                          isUnitDWARF64)) {
+    Optional<raw_string_ostream> HeaderOS;
+    Optional<DWARFVerifier> HeaderVerifier;
+    if (NumThreads > 1) {
+      PendingUnits.emplace_back();
+      HeaderOS.emplace(PendingUnits.back().Report);
+      HeaderVerifier.emplace(*HeaderOS, DCtx, DumpOpts);
+    }
+    DWARFVerifier &V = HeaderVerifier ? *HeaderVerifier : *this;
+    if (!V.verifyUnitHeader(DebugInfoData, &Offset, UnitIdx, UnitType,
+                            isUnitDWARF64)) {
       isHeaderChainValid = false;
       if (isUnitDWARF64)
         break;
@@ -321,11 +333,16 @@ unsigned DWARFVerifier::verifyUnitSection(const DWARFSection &S,
       }
       default: { llvm_unreachable("Invalid UnitType."); }
       }
-      NumDebugInfoErrors += verifyUnitContents(*Unit);
+      if (NumThreads > 1)
+        PendingUnits.back().Unit = Unit;
+      else
+        NumDebugInfoErrors += verifyUnitContents(*Unit);
     }
     hasDIE = DebugInfoData.isValidOffset(Offset);
     ++UnitIdx;
   }
+  if (NumThreads > 1)
+    NumDebugInfoErrors += verifyUnitsInParallel(PendingUnits);
   if (UnitIdx == 0 && !hasDIE) {
     warn() << "Section is empty.\n";
     isHeaderChainValid = true;
@@ -336,6 +353,37 @@ unsigned DWARFVerifier::verifyUnitSection(const DWARFSection &S,
   return NumDebugInfoErrors;
 }
 
+unsigned
+DWARFVerifier::verifyUnitsInParallel(MutableArrayRef<PendingUnit> Units) {
+  ThreadPool Pool(NumThreads);
+  std::vector<std::unique_ptr<raw_string_ostream>> UnitOS;
+  std::vector<std::unique_ptr<DWARFVerifier>> UnitVerifiers;
+  std::vector<unsigned> NumUnitErrors(Units.size());
+  for (unsigned I = 0, E = Units.size(); I != E; ++I) {
+    UnitOS.push_back(llvm::make_unique<raw_string_ostream>(Units[I].Report));
+    UnitVerifiers.push_back(
+        llvm::make_unique<DWARFVerifier>(*UnitOS.back(), DCtx, DumpOpts));
+    if (DWARFUnit *Unit = Units[I].Unit) {
+      DWARFVerifier *V = UnitVerifiers.back().get();
+      unsigned *NumErrors = &NumUnitErrors[I];
+      Pool.async([V, Unit, NumErrors] {
+        *NumErrors = V->verifyUnitContents(*Unit);
+      });
+    }
+  }
+  Pool.wait();
+
+  unsigned NumErrors = 0;
+  for (unsigned I = 0, E = Units.size(); I != E; ++I) {
+    OS << UnitOS[I]->str();
+    NumErrors += NumUnitErrors[I];
+    for (auto &Ref : UnitVerifiers[I]->ReferenceToDIEOffsets)
+      ReferenceToDIEOffsets[Ref.first].insert(Ref.second.begin(),
+                                              Ref.second.end());
+  }
+  return NumErrors;
+}
+
 bool DWARFVerifier::handleDebugInfo() {
   const DWARFObject &DObj = DCtx.getDWARFObj();
   unsigned NumErrors = 0;
@@ -786,9 +834,9 @@ void DWARFVerifier::verifyDebugLineRows() {
 }
 
 DWARFVerifier::DWARFVerifier(raw_ostream &S, DWARFContext &D,
-                             DIDumpOptions DumpOpts)
+                             DIDumpOptions DumpOpts, unsigned NumThreads)
     : OS(S), DCtx(D), DumpOpts(std::move(DumpOpts)), IsObjectFile(false),
-      IsMachOObject(false) {
+      IsMachOObject(false), NumThreads(NumThreads) {
   if (const auto *F = DCtx.getDWARFObj().getFile()) {
     IsObjectFile = F->isRelocatableObject();
     IsMachOObject = F->isMachO();
@@ -0,0 +1,474 @@
+//===- SymbolIndex.cpp ----------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementation of the SymbolIndex and SymbolIndexBuilder classes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/Symbolize/SymbolIndex.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFDebugAranges.h"
+#include "llvm/Object/MachO.h"
+#include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include <algorithm>
+#include <set>
+
+using namespace llvm;
+using namespace object;
+using namespace symbolize;
+
+const uint32_t SymbolIndex::Magic;
+const uint16_t SymbolIndex::Version;
+const uint32_t SymbolIndex::NoFrame;
+
+static Error createMalformedError(const char *Msg) {
+  return createStringError(errc::invalid_argument,
+                           "malformed symbol index: %s", Msg);
+}
+
+Expected<std::unique_ptr<SymbolIndex>>
+SymbolIndex::create(std::unique_ptr<MemoryBuffer> Buffer) {
+  StringRef Data = Buffer->getBuffer();
+  if (Data.size() < sizeof(Header))
+    return createMalformedError("file too small");
+  const Header *H = reinterpret_cast<const Header *>(Data.data());
+  if (H->Magic != Magic)
+    return createMalformedError("bad magic");
+  if (H->Version != Version)
+    return createStringError(errc::invalid_argument,
+                             "unsupported symbol index version %u",
+                             unsigned(H->Version));
+
+  auto InBounds = [&](uint32_t Offset, uint64_t Count, uint64_t EltSize) {
+    return Offset <= Data.size() && Count * EltSize <= Data.size() - Offset;
+  };
+  if (!InBounds(H->IdentityOffset, H->IdentitySize, 1))
+    return createMalformedError("identity out of bounds");
+  if (!InBounds(H->EntriesOffset, H->NumEntries,
+                sizeof(support::ulittle64_t) + sizeof(support::ulittle32_t)))
+    return createMalformedError("address table out of bounds");
+  if (!InBounds(H->FramesOffset, H->NumFrames, sizeof(Frame)))
+    return createMalformedError("frame table out of bounds");
+  if (!InBounds(H->FunctionsOffset, H->NumFunctions, sizeof(Symbol)) ||
+      !InBounds(H->ObjectsOffset, H->NumObjects, sizeof(Symbol)))
+    return createMalformedError("symbol table out of bounds");
+  if (!InBounds(H->StringsOffset, H->StringsSize, 1) || H->StringsSize == 0 ||
+      Data[H->StringsOffset + H->StringsSize - 1] != '\0')
+    return createMalformedError("bad string table");
+
+  std::unique_ptr<SymbolIndex> Index(new SymbolIndex(std::move(Buffer)));
+  const char *Base = Data.data();
+  Index->Hdr = H;
+  Index->Identity = StringRef(Base + H->IdentityOffset, H->IdentitySize);
+  const auto *Addresses =
+      reinterpret_cast<const support::ulittle64_t *>(Base + H->EntriesOffset);
+  Index->Addresses = makeArrayRef(Addresses, H->NumEntries);
+  Index->EntryFrames = makeArrayRef(
+      reinterpret_cast<const support::ulittle32_t *>(Addresses +
+                                                     H->NumEntries),
+      H->NumEntries);
+  Index->Frames = makeArrayRef(
+      reinterpret_cast<const Frame *>(Base + H->FramesOffset), H->NumFrames);
+  Index->Functions =
+      makeArrayRef(reinterpret_cast<const Symbol *>(Base + H->FunctionsOffset),
+                   H->NumFunctions);
+  Index->Objects =
+      makeArrayRef(reinterpret_cast<const Symbol *>(Base + H->ObjectsOffset),
+                   H->NumObjects);
+  Index->Strings = StringRef(Base + H->StringsOffset, H->StringsSize);
+  return std::move(Index);
+}
+
+SymbolIndex::SymbolIndex(std::unique_ptr<MemoryBuffer> Buffer)
+    : Buffer(std::move(Buffer)) {}
+
+std::string SymbolIndex::getDefaultPath(StringRef BinaryPath) {
+  return (BinaryPath + ".symidx").str();
+}
+
+// Returns the contents of the GNU build ID note of an ELF object, if any.
+static ArrayRef<uint8_t> getELFBuildID(const ObjectFile &Obj) {
+  for (const SectionRef &Section : Obj.sections()) {
+    StringRef Name;
+    StringRef Contents;
+    if (Section.getName(Name) || Name != ".note.gnu.build-id" ||
+        Section.getContents(Contents))
+      continue;
+    DataExtractor DE(Contents, Obj.isLittleEndian(), 0);
+    uint32_t Offset = 0;
+    while (DE.isValidOffsetForDataOfSize(Offset, 12)) {
+      uint32_t NameSize = DE.getU32(&Offset);
+      uint32_t DescSize = DE.getU32(&Offset);
+      uint32_t Type = DE.getU32(&Offset);
+      StringRef NoteName = Contents.substr(Offset, NameSize);
+      Offset += alignTo(NameSize, 4);
+      if (!DE.isValidOffsetForDataOfSize(Offset, DescSize))
+        break;
+      if (Type == ELF::NT_GNU_BUILD_ID && NoteName == StringRef("GNU", 4))
+        return arrayRefFromStringRef(Contents.substr(Offset, DescSize));
+      Offset += alignTo(DescSize, 4);
+    }
+  }
+  return None;
+}
+
+std::string SymbolIndex::getModuleIdentity(const ObjectFile &Obj) {
+  // Prefer identifiers that survive stripping, so that an index built from an
+  // unstripped binary also serves its stripped copies.
+  if (auto *MachO = dyn_cast<MachOObjectFile>(&Obj)) {
+    ArrayRef<uint8_t> UUID = MachO->getUuid();
+    if (!UUID.empty())
+      return "uuid:" + toHex(UUID);
+  }
+  if (Obj.isELF()) {
+    ArrayRef<uint8_t> BuildID = getELFBuildID(Obj);
+    if (!BuildID.empty())
+      return "build-id:" + toHex(BuildID);
+  }
+  StringRef Data = Obj.getData();
+  return "xxh64:" + utohexstr(xxHash64(Data)) + ":" + utostr(Data.size());
+}
+
+size_t SymbolIndex::getFileSize() const { return Buffer->getBufferSize(); }
+
+StringRef SymbolIndex::getString(uint32_t Offset) const {
+  if (Offset >= Strings.size())
+    return StringRef();
+  // The string table is null-terminated, so this stays in bounds.
+  return StringRef(Strings.data() + Offset);
+}
+
+uint32_t SymbolIndex::lookUpFrame(uint64_t Address) const {
+  auto It = std::upper_bound(
+      Addresses.begin(), Addresses.end(), Address,
+      [](uint64_t A, const support::ulittle64_t &E) { return A < E; });
+  if (It == Addresses.begin())
+    return NoFrame;
+  return EntryFrames[It - Addresses.begin() - 1];
+}
+
+DILineInfo SymbolIndex::getFrameInfo(const Frame &F,
+                                     FunctionNameKind FNKind) const {
+  DILineInfo Info;
+  if (FNKind == FunctionNameKind::LinkageName)
+    Info.FunctionName = getString(F.FunctionName);
+  else if (FNKind == FunctionNameKind::ShortName)
+    Info.FunctionName = getString(F.ShortName);
+  Info.FileName = getString(F.FileName);
+  Info.Line = F.Line;
+  Info.Column = F.Column;
+  Info.Discriminator = F.Discriminator;
+  Info.StartLine = F.StartLine;
+  return Info;
+}
+
+bool SymbolIndex::getNameFromSymbolTable(ArrayRef<Symbol> Symbols,
+                                         uint64_t Address, std::string &Name,
+                                         uint64_t &Addr, uint64_t &Size) const {
+  auto It = std::upper_bound(
+      Symbols.begin(), Symbols.end(), Address,
+      [](uint64_t A, const Symbol &S) { return A < S.Address; });
+  if (It == Symbols.begin())
+    return false;
+  --It;
+  if (It->Size != 0 && It->Address + It->Size <= Address)
+    return false;
+  Name = getString(It->Name);
+  Addr = It->Address;
+  Size = It->Size;
+  return true;
+}
+
+DILineInfo SymbolIndex::symbolizeCode(SectionedAddress ModuleOffset,
+                                      FunctionNameKind FNKind,
+                                      bool UseSymbolTable) const {
+  DILineInfo LineInfo;
+  uint32_t Idx = lookUpFrame(ModuleOffset.Address);
+  if (Idx < Frames.size())
+    LineInfo = getFrameInfo(Frames[Idx], FNKind);
+  // Indices are built from DWARF, so always prefer the symbol table for
+  // linkage names like SymbolizableObjectFile does.
+  if (FNKind == FunctionNameKind::LinkageName && UseSymbolTable) {
+    std::string FunctionName;
+    uint64_t Start, Size;
+    if (getNameFromSymbolTable(Functions, ModuleOffset.Address, FunctionName,
+                               Start, Size))
+      LineInfo.FunctionName = FunctionName;
+  }
+  return LineInfo;
+}
+
+DILineInfoTable
+SymbolIndex::symbolizeCodeRange(SectionedAddress ModuleOffset, uint64_t Size,
+                                FunctionNameKind FNKind) const {
+  DILineInfoTable Lines;
+  uint64_t Address = ModuleOffset.Address;
+  auto It = std::upper_bound(
+      Addresses.begin(), Addresses.end(), Address,
+      [](uint64_t A, const support::ulittle64_t &E) { return A < E; });
+  if (It != Addresses.begin())
+    --It;
+  for (; It != Addresses.end() && *It < Address + Size; ++It) {
+    uint32_t Idx = EntryFrames[It - Addresses.begin()];
+    if (Idx < Frames.size())
+      Lines.push_back({std::max<uint64_t>(*It, Address),
+                       getFrameInfo(Frames[Idx], FNKind)});
+  }
+  return Lines;
+}
+
+DIInliningInfo SymbolIndex::symbolizeInlinedCode(SectionedAddress ModuleOffset,
+                                                 FunctionNameKind FNKind,
+                                                 bool UseSymbolTable) const {
+  DIInliningInfo InlinedContext;
+  uint32_t Idx = lookUpFrame(ModuleOffset.Address);
+  while (Idx < Frames.size()) {
+    const Frame &F = Frames[Idx];
+    InlinedContext.addFrame(getFrameInfo(F, FNKind));
+    // Callers come first in the table, which rules out cycles.
+    if (F.Caller >= Idx)
+      break;
+    Idx = F.Caller;
+  }
+  if (InlinedContext.getNumberOfFrames() == 0)
+    InlinedContext.addFrame(DILineInfo());
+
+  if (FNKind == FunctionNameKind::LinkageName && UseSymbolTable) {
+    std::string FunctionName;
+    uint64_t Start, Size;
+    if (getNameFromSymbolTable(Functions, ModuleOffset.Address, FunctionName,
+                               Start, Size))
+      InlinedContext.getMutableFrame(InlinedContext.getNumberOfFrames() - 1)
+          ->FunctionName = FunctionName;
+  }
+  return InlinedContext;
+}
+
+DIGlobal SymbolIndex::symbolizeData(SectionedAddress ModuleOffset) const {
+  DIGlobal Res;
+  getNameFromSymbolTable(Objects, ModuleOffset.Address, Res.Name, Res.Start,
+                         Res.Size);
+  return Res;
+}
+
+bool SymbolIndex::isWin32Module() const {
+  return Hdr->Flags & Win32Module;
+}
+
+uint64_t SymbolIndex::getModulePreferredBase() const {
+  return Hdr->PreferredBase;
+}
+
+void SymbolIndexBuilder::addSymbol(SymbolRef::Type Type, uint64_t Address,
+                                   uint64_t Size, StringRef Name) {
+  auto &Symbols = Type == SymbolRef::ST_Function ? Functions : Objects;
+  Symbols.push_back({Address, Size, addString(Name)});
+}
+
+uint32_t SymbolIndexBuilder::addString(StringRef S) {
+  auto Inserted = StringIds.insert(std::make_pair(S, Strings.size()));
+  if (Inserted.second) {
+    Strings += S;
+    Strings += '\0';
+  }
+  return Inserted.first->second;
+}
+
+uint32_t SymbolIndexBuilder::addFrame(const DILineInfo &Info,
+                                      StringRef ShortName, uint32_t Caller) {
+  FrameInfo F = {addString(Info.FunctionName), addString(ShortName),
+                 addString(Info.FileName),     Info.Line,
+                 Info.Column,                  Info.Discriminator,
+                 Info.StartLine,               Caller};
+  auto Inserted = FrameIds.insert(std::make_pair(F, Frames.size()));
+  if (Inserted.second)
+    Frames.push_back(F);
+  return Inserted.first->second;
+}
+
+void SymbolIndexBuilder::addDebugInfo(DWARFContext &DICtx) {
+  // The answers of DICtx only change at the bounds of the address ranges of
+  // units and subroutines, and at the rows of line tables. Collect all of
+  // them, then record the answer at each.
+  std::set<uint64_t> Bounds;
+  const DWARFDebugAranges *Aranges = DICtx.getDebugAranges();
+  Aranges->forEachUnitInRange(0, UINT64_MAX,
+                              [&](uint32_t, uint64_t LowPC, uint64_t HighPC) {
+                                Bounds.insert(LowPC);
+                                Bounds.insert(HighPC);
+                              });
+  for (const auto &CU : DICtx.compile_units())
+    if (const DWARFDebugLine::LineTable *LT =
+            DICtx.getLineTableForUnit(CU.get()))
+      for (const DWARFDebugLine::Row &Row : LT->Rows)
+        Bounds.insert(Row.Address.Address);
+
+  // Subroutines are found through the inlining chains at the bounds found so
+  // far, which also works for units in .dwo files. Each one adds its own
+  // ranges and those of the subroutines directly nested in it, which may
+  // start in the middle of a line table row.
+  DenseSet<const DWARFDebugInfoEntry *> Visited;
+  std::vector<uint64_t> Missed;
+  auto AddRanges = [&](DWARFDie Die, uint64_t Address) {
+    auto RangesOrErr = Die.getAddressRanges();
+    if (!RangesOrErr) {
+      consumeError(RangesOrErr.takeError());
+      return;
+    }
+    for (const DWARFAddressRange &R : *RangesOrErr) {
+      if (R.LowPC == R.HighPC)
+        continue;
+      for (uint64_t Bound : {R.LowPC, R.HighPC})
+        if (Bounds.insert(Bound).second && Bound < Address)
+          Missed.push_back(Bound);
+    }
+  };
+  auto VisitChain = [&](uint64_t Address) {
+    DWARFCompileUnit *CU =
+        DICtx.getCompileUnitForOffset(Aranges->findAddress(Address));
+    if (!CU)
+      return;
+    SmallVector<DWARFDie, 4> Chain;
+    CU->getInlinedChainForAddress(Address, Chain);
+    for (DWARFDie Die : Chain) {
+      if (!Visited.insert(Die.getDebugInfoEntry()).second)
+        continue;
+      AddRanges(Die, Address);
+      SmallVector<DWARFDie, 8> Worklist(Die.children().begin(),
+                                        Die.children().end());
+      while (!Worklist.empty()) {
+        DWARFDie Child = Worklist.pop_back_val();
+        if (Child.isSubroutineDIE())
+          AddRanges(Child, Address);
+        else
+          Worklist.append(Child.children().begin(), Child.children().end());
+      }
+    }
+  };
+  // Bounds inserted behind the iterator are revisited through Missed.
+  for (uint64_t Address : Bounds)
+    VisitChain(Address);
+  while (!Missed.empty()) {
+    uint64_t Address = Missed.back();
+    Missed.pop_back();
+    VisitChain(Address);
+  }
+
+  DILineInfoSpecifier LinkageSpec(
+      DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+      FunctionNameKind::LinkageName);
+  DILineInfoSpecifier ShortSpec(
+      DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+      FunctionNameKind::ShortName);
+  for (uint64_t Address : Bounds) {
+    SectionedAddress SA = {Address, SectionedAddress::UndefSection};
+    DIInliningInfo Linkage = DICtx.getInliningInfoForAddress(SA, LinkageSpec);
+    DIInliningInfo Short = DICtx.getInliningInfoForAddress(SA, ShortSpec);
+    // Add the outermost frame first so that callers get the smaller indices.
+    uint32_t Frame = SymbolIndex::NoFrame;
+    for (int I = Linkage.getNumberOfFrames() - 1; I >= 0; --I) {
+      const DILineInfo &Info = Linkage.getFrame(I);
+      StringRef ShortName = I < (int)Short.getNumberOfFrames()
+                                ? Short.getFrame(I).FunctionName
+                                : Info.FunctionName;
+      Frame = addFrame(Info, ShortName, Frame);
+    }
+    uint32_t Prev =
+        Entries.empty() ? SymbolIndex::NoFrame : Entries.back().second;
+    if (Frame != Prev)
+      Entries.emplace_back(Address, Frame);
+  }
+}
+
+Error SymbolIndexBuilder::write(raw_ostream &OS) const {
+  std::vector<SymbolInfo> SortedFunctions = Functions;
+  std::vector<SymbolInfo> SortedObjects = Objects;
+  for (auto *Symbols : {&SortedFunctions, &SortedObjects})
+    llvm::sort(*Symbols, [](const SymbolInfo &L, const SymbolInfo &R) {
+      return L.Address < R.Address;
+    });
+
+  // Lay the tables out one after another behind the header.
+  uint64_t Offset = sizeof(SymbolIndex::Header);
+  auto Place = [&](uint64_t Size) {
+    uint64_t Start = Offset;
+    Offset += Size;
+    return Start;
+  };
+  uint64_t IdentityOffset = Place(Identity.size());
+  uint64_t EntriesOffset =
+      Place(Entries.size() *
+            (sizeof(support::ulittle64_t) + sizeof(support::ulittle32_t)));
+  uint64_t FramesOffset = Place(Frames.size() * sizeof(SymbolIndex::Frame));
+  uint64_t FunctionsOffset =
+      Place(SortedFunctions.size() * sizeof(SymbolIndex::Symbol));
+  uint64_t ObjectsOffset =
+      Place(SortedObjects.size() * sizeof(SymbolIndex::Symbol));
+  uint64_t StringsOffset = Place(Strings.size());
+  if (Offset > UINT32_MAX)
+    return createStringError(errc::file_too_large,
+                             "symbol index would be larger than 4 GiB");
+
+  SymbolIndex::Header H;
+  H.Magic = SymbolIndex::Magic;
+  H.Version = SymbolIndex::Version;
+  H.Flags = Win32Module ? SymbolIndex::Win32Module : 0;
+  H.PreferredBase = PreferredBase;
+  H.IdentityOffset = IdentityOffset;
+  H.IdentitySize = Identity.size();
+  H.EntriesOffset = EntriesOffset;
+  H.NumEntries = Entries.size();
+  H.FramesOffset = FramesOffset;
+  H.NumFrames = Frames.size();
+  H.FunctionsOffset = FunctionsOffset;
+  H.NumFunctions = SortedFunctions.size();
+  H.ObjectsOffset = ObjectsOffset;
+  H.NumObjects = SortedObjects.size();
+  H.StringsOffset = StringsOffset;
+  H.StringsSize = Strings.size();
+  OS.write(reinterpret_cast<const char *>(&H), sizeof(H));
+  OS << Identity;
+
+  support::endian::Writer W(OS, support::little);
+  for (const auto &Entry : Entries)
+    W.write<uint64_t>(Entry.first);
+  for (const auto &Entry : Entries)
+    W.write<uint32_t>(Entry.second);
+  for (const FrameInfo &F : Frames) {
+    SymbolIndex::Frame Out;
+    Out.FunctionName = F.FunctionName;
+    Out.ShortName = F.ShortName;
+    Out.FileName = F.FileName;
+    Out.Line = F.Line;
+    Out.Column = F.Column;
+    Out.Discriminator = F.Discriminator;
+    Out.StartLine = F.StartLine;
+    Out.Caller = F.Caller;
+    OS.write(reinterpret_cast<const char *>(&Out), sizeof(Out));
+  }
+  for (const auto *Symbols : {&SortedFunctions, &SortedObjects}) {
+    for (const SymbolInfo &S : *Symbols) {
+      SymbolIndex::Symbol Out;
+      Out.Address = S.Address;
+      Out.Size = S.Size;
+      Out.Name = S.Name;
+      OS.write(reinterpret_cast<const char *>(&Out), sizeof(Out));
+    }
+  }
+  OS << Strings;
+  return Error::success();
+}
@@ -16,6 +16,7 @@
 #include "llvm/ADT/Triple.h"
 #include "llvm/BinaryFormat/COFF.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/DebugInfo/Symbolize/SymbolIndex.h"
 #include "llvm/DebugInfo/Symbolize/SymbolizableModule.h"
 #include "llvm/Object/COFF.h"
 #include "llvm/Object/ObjectFile.h"
@@ -210,6 +211,19 @@ uint64_t SymbolizableObjectFile::getModulePreferredBase() const {
   return 0;
 }
 
+void SymbolizableObjectFile::addToIndex(SymbolIndexBuilder &Builder) const {
+  Builder.setPreferredBase(getModulePreferredBase());
+  Builder.setWin32Module(isWin32Module());
+  for (const auto &F : Functions)
+    Builder.addSymbol(SymbolRef::ST_Function, F.first.Addr, F.first.Size,
+                      F.second);
+  for (const auto &O : Objects)
+    Builder.addSymbol(SymbolRef::ST_Data, O.first.Addr, O.first.Size,
+                      O.second);
+  if (auto *DWARFCtx = dyn_cast_or_null<DWARFContext>(DebugInfoContext.get()))
+    Builder.addDebugInfo(*DWARFCtx);
+}
+
 bool SymbolizableObjectFile::getNameFromSymbolTable(SymbolRef::Type Type,
                                                     uint64_t Address,
                                                     std::string &Name,
@@ -266,6 +280,20 @@ SymbolizableObjectFile::symbolizeCode(object::SectionedAddress ModuleOffset,
   return LineInfo;
 }
 
+DILineInfoTable SymbolizableObjectFile::symbolizeCodeRange(
+    object::SectionedAddress ModuleOffset, uint64_t Size,
+    FunctionNameKind FNKind) const {
+  if (!DebugInfoContext)
+    return DILineInfoTable();
+
+  if (ModuleOffset.SectionIndex == object::SectionedAddress::UndefSection)
+    ModuleOffset.SectionIndex =
+        getModuleSectionIndexForAddress(ModuleOffset.Address);
+
+  return DebugInfoContext->getLineInfoForAddressRange(
+      ModuleOffset, Size, getDILineInfoSpecifier(FNKind));
+}
+
 DIInliningInfo SymbolizableObjectFile::symbolizeInlinedCode(
     object::SectionedAddress ModuleOffset, FunctionNameKind FNKind,
     bool UseSymbolTable) const {
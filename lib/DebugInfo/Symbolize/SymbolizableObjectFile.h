@@ -28,6 +28,8 @@ class DataExtractor;
 
 namespace symbolize {
 
+class SymbolIndexBuilder;
+
 class SymbolizableObjectFile : public SymbolizableModule {
 public:
   static ErrorOr<std::unique_ptr<SymbolizableObjectFile>>
@@ -36,6 +38,9 @@ public:
   DILineInfo symbolizeCode(object::SectionedAddress ModuleOffset,
                            FunctionNameKind FNKind,
                            bool UseSymbolTable) const override;
+  DILineInfoTable symbolizeCodeRange(object::SectionedAddress ModuleOffset,
+                                     uint64_t Size,
+                                     FunctionNameKind FNKind) const override;
   DIInliningInfo symbolizeInlinedCode(object::SectionedAddress ModuleOffset,
                                       FunctionNameKind FNKind,
                                       bool UseSymbolTable) const override;
@@ -48,6 +53,9 @@ public:
   // it in memory assuming there were no conflicts.
   uint64_t getModulePreferredBase() const override;
 
+  // Adds the symbols and the DWARF debug info of the module to \p Builder.
+  void addToIndex(SymbolIndexBuilder &Builder) const;
+
 private:
   bool shouldOverrideWithSymbolTable(FunctionNameKind FNKind,
                                      bool UseSymbolTable) const;
@@ -15,10 +15,12 @@
 #include "SymbolizableObjectFile.h"
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/BinaryFormat/COFF.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/PDB/PDB.h"
 #include "llvm/DebugInfo/PDB/PDBContext.h"
+#include "llvm/DebugInfo/Symbolize/SymbolIndex.h"
 #include "llvm/Demangle/Demangle.h"
 #include "llvm/Object/COFF.h"
 #include "llvm/Object/MachO.h"
@@ -78,6 +80,39 @@ LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
   return LineInfo;
 }
 
+Expected<DILineInfoTable>
+LLVMSymbolizer::symbolizeCodeRange(const std::string &ModuleName,
+                                   object::SectionedAddress ModuleOffset,
+                                   uint64_t Size, StringRef DWPName) {
+  SymbolizableModule *Info;
+  if (auto InfoOrErr = getOrCreateModuleInfo(ModuleName, DWPName))
+    Info = InfoOrErr.get();
+  else
+    return InfoOrErr.takeError();
+
+  // A null module means an error has already been reported. Return an empty
+  // result.
+  if (!Info)
+    return DILineInfoTable();
+
+  // If the user is giving us relative addresses, add the preferred base of the
+  // object to the offset before we do the query. It's what DIContext expects.
+  uint64_t Base = 0;
+  if (Opts.RelativeAddresses) {
+    Base = Info->getModulePreferredBase();
+    ModuleOffset.Address += Base;
+  }
+
+  DILineInfoTable Lines =
+      Info->symbolizeCodeRange(ModuleOffset, Size, Opts.PrintFunctions);
+  for (auto &Line : Lines) {
+    Line.first -= Base;
+    if (Opts.Demangle)
+      Line.second.FunctionName = DemangleName(Line.second.FunctionName, Info);
+  }
+  return Lines;
+}
+
 Expected<DIInliningInfo>
 LLVMSymbolizer::symbolizeInlinedCode(const std::string &ModuleName,
                                      object::SectionedAddress ModuleOffset,
@@ -140,6 +175,85 @@ void LLVMSymbolizer::flush() {
   BinaryForPath.clear();
   ObjectPairForPathArch.clear();
   Modules.clear();
+  ModuleLRU.clear();
+  ModuleLRUPos.clear();
+  BinaryUsers.clear();
+  CacheSize = 0;
+}
+
+void LLVMSymbolizer::cacheModule(const std::string &ModuleName,
+                                 ArrayRef<std::string> Paths,
+                                 uint64_t ExtraSize) {
+  ModuleLRU.push_front({ModuleName, Paths.vec(), ExtraSize});
+  ModuleLRUPos[ModuleName] = ModuleLRU.begin();
+  CacheSize += ExtraSize;
+  for (const std::string &Path : Paths) {
+    std::pair<unsigned, uint64_t> &Users = BinaryUsers[Path];
+    if (Users.first++ == 0) {
+      auto I = BinaryForPath.find(Path);
+      if (I != BinaryForPath.end() && I->second.getBinary())
+        Users.second = I->second.getBinary()->getData().size();
+      CacheSize += Users.second;
+    }
+  }
+
+  // Never evict the module that was just loaded.
+  while (Opts.MaxCacheSize && CacheSize > Opts.MaxCacheSize &&
+         ModuleLRU.size() > 1) {
+    const CachedModule &Victim = ModuleLRU.back();
+    Modules.erase(Victim.Name);
+    CacheSize -= Victim.Size;
+    for (const std::string &Path : Victim.BinaryPaths) {
+      auto I = BinaryUsers.find(Path);
+      if (--I->second.first)
+        continue;
+      CacheSize -= I->second.second;
+      BinaryUsers.erase(I);
+      releaseBinary(Path);
+    }
+    ModuleLRUPos.erase(Victim.Name);
+    ModuleLRU.pop_back();
+    ++NumEvictions;
+  }
+}
+
+void LLVMSymbolizer::releaseBinary(const std::string &Path) {
+  auto BinI = BinaryForPath.find(Path);
+  if (BinI == BinaryForPath.end())
+    return;
+  SmallPtrSet<const ObjectFile *, 4> Objects;
+  if (auto *Obj = dyn_cast_or_null<ObjectFile>(BinI->second.getBinary()))
+    Objects.insert(Obj);
+  for (const auto &P : ObjectForUBPathAndArch)
+    if (P.first.first == Path)
+      Objects.insert(P.second.get());
+
+  for (auto I = ObjectPairForPathArch.begin();
+       I != ObjectPairForPathArch.end();) {
+    if (I->first.first == Path || Objects.count(I->second.first) ||
+        Objects.count(I->second.second))
+      I = ObjectPairForPathArch.erase(I);
+    else
+      ++I;
+  }
+  for (auto I = ObjectForUBPathAndArch.begin();
+       I != ObjectForUBPathAndArch.end();) {
+    if (I->first.first == Path)
+      I = ObjectForUBPathAndArch.erase(I);
+    else
+      ++I;
+  }
+  BinaryForPath.erase(BinI);
+}
+
+std::string LLVMSymbolizer::getPathOfObject(const ObjectFile *Obj) const {
+  for (const auto &P : BinaryForPath)
+    if (P.second.getBinary() == Obj)
+      return P.first;
+  for (const auto &P : ObjectForUBPathAndArch)
+    if (P.second.get() == Obj)
+      return P.first.first;
+  return "";
 }
 
 namespace {
@@ -374,15 +488,14 @@ LLVMSymbolizer::getOrCreateObject(const std::string &Path,
   return errorCodeToError(object_error::arch_not_found);
 }
 
-Expected<SymbolizableModule *>
-LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
-                                      StringRef DWPName) {
-  const auto &I = Modules.find(ModuleName);
-  if (I != Modules.end()) {
-    return I->second.get();
-  }
-  std::string BinaryName = ModuleName;
-  std::string ArchName = Opts.DefaultArch;
+namespace {
+
+// Splits "path/to/binary:arch" into its binary name and architecture.
+void splitModuleName(const std::string &ModuleName,
+                     const std::string &DefaultArch, std::string &BinaryName,
+                     std::string &ArchName) {
+  BinaryName = ModuleName;
+  ArchName = DefaultArch;
   size_t ColonPos = ModuleName.find_last_of(':');
   // Verify that substring after colon form a valid arch name.
   if (ColonPos != std::string::npos) {
@@ -392,6 +505,60 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
       ArchName = ArchStr;
     }
   }
+}
+
+// Returns the index next to the binary at Path, if there is one and it was
+// built from Obj. Stale or unreadable indices are ignored.
+std::unique_ptr<SymbolIndex> loadSymbolIndex(const std::string &Path,
+                                             const ObjectFile &Obj) {
+  auto BufOrErr = MemoryBuffer::getFile(SymbolIndex::getDefaultPath(Path), -1,
+                                        /*RequiresNullTerminator=*/false);
+  if (!BufOrErr)
+    return nullptr;
+  auto IndexOrErr = SymbolIndex::create(std::move(*BufOrErr));
+  if (!IndexOrErr) {
+    consumeError(IndexOrErr.takeError());
+    return nullptr;
+  }
+  if ((*IndexOrErr)->getIdentity() != SymbolIndex::getModuleIdentity(Obj))
+    return nullptr;
+  return std::move(*IndexOrErr);
+}
+
+} // end anonymous namespace
+
+Expected<SymbolizableModule *>
+LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
+                                      StringRef DWPName) {
+  const auto &I = Modules.find(ModuleName);
+  if (I != Modules.end()) {
+    auto LRUPos = ModuleLRUPos.find(ModuleName);
+    if (LRUPos != ModuleLRUPos.end())
+      ModuleLRU.splice(ModuleLRU.begin(), ModuleLRU, LRUPos->second);
+    return I->second.get();
+  }
+  std::string BinaryName, ArchName;
+  splitModuleName(ModuleName, Opts.DefaultArch, BinaryName, ArchName);
+  // An index answers everything without looking for separate debug info.
+  if (Opts.UseSymbolIndex) {
+    auto ObjOrErr = getOrCreateObject(BinaryName, ArchName);
+    if (!ObjOrErr) {
+      Modules.insert(
+          std::make_pair(ModuleName, std::unique_ptr<SymbolizableModule>()));
+      return ObjOrErr.takeError();
+    }
+    if (*ObjOrErr) {
+      if (std::unique_ptr<SymbolIndex> Index =
+              loadSymbolIndex(BinaryName, **ObjOrErr)) {
+        uint64_t IndexSize = Index->getFileSize();
+        auto InsertResult =
+            Modules.insert(std::make_pair(ModuleName, std::move(Index)));
+        SymbolizableModule *Info = InsertResult.first->second.get();
+        cacheModule(ModuleName, BinaryName, IndexSize);
+        return Info;
+      }
+    }
+  }
   auto ObjectsOrErr = getOrCreateObjectPair(BinaryName, ArchName);
   if (!ObjectsOrErr) {
     // Failed to find valid object file.
@@ -435,7 +602,39 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
   assert(InsertResult.second);
   if (auto EC = InfoOrErr.getError())
     return errorCodeToError(EC);
-  return InsertResult.first->second.get();
+  SymbolizableModule *Info = InsertResult.first->second.get();
+  SmallVector<std::string, 2> Paths = {BinaryName};
+  if (Objects.second != Objects.first) {
+    std::string DebugPath = getPathOfObject(Objects.second);
+    if (!DebugPath.empty() && DebugPath != BinaryName)
+      Paths.push_back(DebugPath);
+  }
+  cacheModule(ModuleName, Paths, 0);
+  return Info;
+}
+
+Error LLVMSymbolizer::writeSymbolIndex(const std::string &ModuleName,
+                                       raw_ostream &OS, StringRef DWPName) {
+  std::string BinaryName, ArchName;
+  splitModuleName(ModuleName, Opts.DefaultArch, BinaryName, ArchName);
+  auto ObjectsOrErr = getOrCreateObjectPair(BinaryName, ArchName);
+  if (!ObjectsOrErr)
+    return ObjectsOrErr.takeError();
+  ObjectPair Objects = ObjectsOrErr.get();
+  if (Objects.first->isRelocatableObject())
+    return createStringError(errc::invalid_argument,
+                             "%s: cannot index a relocatable object",
+                             BinaryName.c_str());
+
+  auto InfoOrErr = SymbolizableObjectFile::create(
+      Objects.first,
+      DWARFContext::create(*Objects.second, nullptr,
+                           DWARFContext::defaultErrorHandler, DWPName));
+  if (auto EC = InfoOrErr.getError())
+    return errorCodeToError(EC);
+  SymbolIndexBuilder Builder(SymbolIndex::getModuleIdentity(*Objects.first));
+  InfoOrErr.get()->addToIndex(Builder);
+  return Builder.write(OS);
 }
 
 namespace {
@@ -31,10 +31,12 @@
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/MCValue.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
 #include <cstdint>
@@ -67,6 +69,9 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(RelaxationChecks, "Number of fragments checked for relaxation");
+STATISTIC(RelaxationChecksSkipped,
+          "Number of fragment relaxation checks skipped as up to date");
 STATISTIC(PaddingFragmentsRelaxations,
           "Number of Padding Fragments relaxations");
 STATISTIC(PaddingFragmentsBytes,
@@ -75,6 +80,15 @@ STATISTIC(PaddingFragmentsBytes,
 } // end namespace stats
 } // end anonymous namespace
 
+static cl::opt<bool> IncrementalRelaxation(
+    "mc-incremental-relaxation", cl::Hidden, cl::init(true),
+    cl::desc("Only check a fragment for relaxation again if a fragment it "
+             "depends on has moved"));
+
+static cl::opt<bool> TimeRelaxation(
+    "mc-time-relaxation", cl::Hidden, cl::init(false),
+    cl::desc("Report the time spent in assembler layout and relaxation"));
+
 // FIXME FIXME FIXME: There are number of places in this file where we convert
 // what is a 64-bit assembler value used for computation into a value in the
 // object file, which may truncate it. We should detect that truncation where
@@ -109,6 +123,8 @@ void MCAssembler::reset() {
   IncrementalLinkerCompatible = false;
   ELFHeaderEFlags = 0;
   LOHContainer.reset();
+  RelaxationStates.clear();
+  RelaxationEpoch = 0;
   VersionInfo.Major = 0;
   VersionInfo.SDKVersion = VersionTuple();
 
@@ -782,9 +798,17 @@ void MCAssembler::layout(MCAsmLayout &Layout) {
   }
 
   // Layout until everything fits.
-  while (layoutOnce(Layout))
-    if (getContext().hadError())
-      return;
+  {
+    NamedRegionTimer T("relaxation", "Layout and relaxation", "assembler",
+                       "Assembler", TimeRelaxation);
+    initRelaxationStates();
+    while (layoutOnce(Layout))
+      if (getContext().hadError())
+        break;
+    RelaxationStates.shrink_and_clear();
+  }
+  if (getContext().hadError())
+    return;
 
   DEBUG_WITH_TYPE("mc-dump", {
       errs() << "assembler backend - post-relaxation\n--\n";
@@ -1038,53 +1062,195 @@ bool MCAssembler::relaxCVDefRange(MCAsmLayout &Layout,
   return OldSize != F.getContents().size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
-  // Holds the first fragment which needed relaxing during this layout. It will
-  // remain NULL if none were relaxed.
-  // When a fragment is relaxed, all the fragments following it should get
-  // invalidated because their offset is going to change.
-  MCFragment *FirstRelaxedFragment = nullptr;
+bool MCAssembler::relaxFragment(MCAsmLayout &Layout, MCFragment &F) {
+  switch(F.getKind()) {
+  default:
+    return false;
+  case MCFragment::FT_Relaxable:
+    assert(!getRelaxAll() &&
+           "Did not expect a MCRelaxableFragment in RelaxAll mode");
+    return relaxInstruction(Layout, cast<MCRelaxableFragment>(F));
+  case MCFragment::FT_Dwarf:
+    return relaxDwarfLineAddr(Layout, cast<MCDwarfLineAddrFragment>(F));
+  case MCFragment::FT_DwarfFrame:
+    return relaxDwarfCallFrameFragment(Layout,
+                                       cast<MCDwarfCallFrameFragment>(F));
+  case MCFragment::FT_LEB:
+    return relaxLEB(Layout, cast<MCLEBFragment>(F));
+  case MCFragment::FT_Padding:
+    return relaxPaddingFragment(Layout, cast<MCPaddingFragment>(F));
+  case MCFragment::FT_CVInlineLines:
+    return relaxCVInlineLineTable(Layout, cast<MCCVInlineLineTableFragment>(F));
+  case MCFragment::FT_CVDefRange:
+    return relaxCVDefRange(Layout, cast<MCCVDefRangeFragment>(F));
+  }
+}
+
+namespace {
+
+/// The fragments whose offsets the relaxation of a fragment depends on.
+/// Dependencies are only tracked within a single section.
+struct RelaxationDeps {
+  const MCSection *Section = nullptr;
+  unsigned MaxLayoutOrder = 0;
+  bool Trackable = true;
+
+  void addFragment(const MCFragment &F) {
+    if (!Section)
+      Section = F.getParent();
+    else if (Section != F.getParent())
+      Trackable = false;
+    MaxLayoutOrder = std::max(MaxLayoutOrder, F.getLayoutOrder());
+  }
+
+  void addExpr(const MCExpr &Expr) {
+    switch (Expr.getKind()) {
+    case MCExpr::Constant:
+      break;
+    case MCExpr::SymbolRef: {
+      const MCSymbol &Sym = cast<MCSymbolRefExpr>(Expr).getSymbol();
+      if (Sym.isVariable())
+        addExpr(*Sym.getVariableValue(/*SetUsed=*/false));
+      else if (Sym.isInSection())
+        addFragment(*Sym.getFragment());
+      break;
+    }
+    case MCExpr::Unary:
+      addExpr(*cast<MCUnaryExpr>(Expr).getSubExpr());
+      break;
+    case MCExpr::Binary:
+      addExpr(*cast<MCBinaryExpr>(Expr).getLHS());
+      addExpr(*cast<MCBinaryExpr>(Expr).getRHS());
+      break;
+    case MCExpr::Target:
+      Trackable = false;
+      break;
+    }
+  }
 
-  // Attempt to relax all the fragments in the section.
-  for (MCSection::iterator I = Sec.begin(), IE = Sec.end(); I != IE; ++I) {
-    // Check if this is a fragment that needs relaxation.
-    bool RelaxedFrag = false;
-    switch(I->getKind()) {
+  /// Collect the dependencies of fragment \p F, which was just found not to
+  /// need relaxation.
+  void addFragmentDeps(const MCAsmBackend &Backend, const MCFragment &F) {
+    switch (F.getKind()) {
     default:
+      Trackable = false;
       break;
-    case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
+    case MCFragment::FT_Relaxable: {
+      const auto &RF = cast<MCRelaxableFragment>(F);
+      if (!Backend.mayNeedRelaxation(RF.getInst(), *RF.getSubtargetInfo()))
+        break;
+      // PC-relative fixups depend on the offset of the fragment itself.
+      addFragment(F);
+      for (const MCFixup &Fixup : RF.getFixups())
+        addExpr(*Fixup.getValue());
       break;
+    }
     case MCFragment::FT_Dwarf:
-      RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
+      addExpr(cast<MCDwarfLineAddrFragment>(F).getAddrDelta());
       break;
     case MCFragment::FT_DwarfFrame:
-      RelaxedFrag =
-        relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
+      addExpr(cast<MCDwarfCallFrameFragment>(F).getAddrDelta());
       break;
     case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
+      addExpr(cast<MCLEBFragment>(F).getValue());
       break;
-    case MCFragment::FT_Padding:
-      RelaxedFrag = relaxPaddingFragment(Layout, *cast<MCPaddingFragment>(I));
-      break;
-    case MCFragment::FT_CVInlineLines:
-      RelaxedFrag =
-          relaxCVInlineLineTable(Layout, *cast<MCCVInlineLineTableFragment>(I));
-      break;
-    case MCFragment::FT_CVDefRange:
-      RelaxedFrag = relaxCVDefRange(Layout, *cast<MCCVDefRangeFragment>(I));
+    }
+  }
+};
+
+} // end anonymous namespace
+
+void MCAssembler::initRelaxationStates() {
+  RelaxationStates.clear();
+  RelaxationEpoch = 0;
+  for (MCSection &Sec : *this) {
+    SectionRelaxationState &State = RelaxationStates[&Sec];
+    for (MCFragment &F : Sec) {
+      switch (F.getKind()) {
+      default:
+        break;
+      case MCFragment::FT_Padding:
+        // The backend lays out the fragments following a padding fragment
+        // for every size it considers.
+        State.HasUntrackedInvalidations = true;
+        LLVM_FALLTHROUGH;
+      case MCFragment::FT_Relaxable:
+      case MCFragment::FT_Dwarf:
+      case MCFragment::FT_DwarfFrame:
+      case MCFragment::FT_LEB:
+      case MCFragment::FT_CVInlineLines:
+      case MCFragment::FT_CVDefRange:
+        State.Candidates.emplace_back(&F);
+        break;
+      }
+    }
+  }
+}
+
+bool MCAssembler::isRelaxationCheckStale(const RelaxationCandidate &C) const {
+  if (!C.DepSection)
+    return true;
+  auto It = RelaxationStates.find(C.DepSection);
+  if (It == RelaxationStates.end() || It->second.HasUntrackedInvalidations)
+    return true;
+  // Fragments only move when the layout is invalidated from a fragment at or
+  // before them.
+  for (const auto &Invalidation : reverse(It->second.Invalidations)) {
+    if (Invalidation.first <= C.Epoch)
       break;
+    if (Invalidation.second <= C.MaxDepLayoutOrder)
+      return true;
+  }
+  return false;
+}
+
+bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
+  // Holds the first fragment which needed relaxing during this layout. It will
+  // remain NULL if none were relaxed.
+  // When a fragment is relaxed, all the fragments following it should get
+  // invalidated because their offset is going to change.
+  MCFragment *FirstRelaxedFragment = nullptr;
+
+  // Attempt to relax the fragments in the section which may need it. A
+  // fragment which did not need relaxation the last time it was checked is
+  // skipped if none of the fragments it depends on has moved since, as the
+  // check would give the same result. Fragments whose check cannot depend on
+  // the layout any more are dropped.
+  SectionRelaxationState &State = RelaxationStates[&Sec];
+  std::vector<RelaxationCandidate> &Candidates = State.Candidates;
+  unsigned NumCandidates = 0;
+  for (RelaxationCandidate C : Candidates) {
+    if (IncrementalRelaxation && !isRelaxationCheckStale(C)) {
+      ++stats::RelaxationChecksSkipped;
+      C.Epoch = RelaxationEpoch;
+      Candidates[NumCandidates++] = C;
+      continue;
+    }
+
+    ++stats::RelaxationChecks;
+    if (relaxFragment(Layout, *C.F)) {
+      if (!FirstRelaxedFragment)
+        FirstRelaxedFragment = C.F;
+      C.DepSection = nullptr;
+    } else if (!C.DepSection) {
+      RelaxationDeps Deps;
+      Deps.addFragmentDeps(getBackend(), *C.F);
+      if (Deps.Trackable && !Deps.Section)
+        continue;
+      if (Deps.Trackable) {
+        C.DepSection = Deps.Section;
+        C.MaxDepLayoutOrder = Deps.MaxLayoutOrder;
+      }
     }
-    if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = &*I;
+    C.Epoch = RelaxationEpoch;
+    Candidates[NumCandidates++] = C;
   }
+  Candidates.resize(NumCandidates, RelaxationCandidate(nullptr));
+
   if (FirstRelaxedFragment) {
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
+    State.Invalidations.push_back(std::make_pair(
+        ++RelaxationEpoch, FirstRelaxedFragment->getLayoutOrder()));
     return true;
   }
   return false;
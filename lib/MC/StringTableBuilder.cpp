@@ -13,6 +13,7 @@
 #include "llvm/BinaryFormat/COFF.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
 #include <cstddef>
@@ -115,6 +116,74 @@ tailcall:
   }
 }
 
+// Tables with fewer strings than this are sorted on the calling thread.
+static const size_t MinParallelStrings = 1 << 16;
+
+// The number of buckets strings are distributed into by two characters, each
+// of which may be the end of the string.
+static const size_t NumTailBuckets = 257 * 257;
+
+namespace {
+// A range of strings which share their last Pos characters, to be sorted by
+// multikeySort(Vec, Pos).
+struct SortTask {
+  MutableArrayRef<StringPair *> Vec;
+  int Pos;
+};
+} // end anonymous namespace
+
+// Sort Vec into the same order as multikeySort(Vec, 0), using the
+// llvm::parallel thread pool. Ranges of strings are distributed into buckets
+// by the next two characters from the end, in the order multikeySort would put
+// them, until every range is small enough to be one of many tasks sorted
+// independently.
+static void parallelMultikeySort(MutableArrayRef<StringPair *> Vec) {
+  size_t MaxTaskSize = std::max<size_t>(Vec.size() / 256, 1);
+  std::vector<SortTask> Tasks;
+  std::vector<SortTask> Worklist = {{Vec, 0}};
+  std::vector<StringPair *> Scratch;
+  std::vector<size_t> BucketStart(NumTailBuckets + 1);
+  while (!Worklist.empty()) {
+    SortTask T = Worklist.back();
+    Worklist.pop_back();
+    if (T.Vec.size() <= MaxTaskSize) {
+      Tasks.push_back(T);
+      continue;
+    }
+
+    // Counting sort by bucket. Characters sort in decreasing order, with the
+    // end of the string last, so the bucket of the greatest characters comes
+    // first.
+    auto BucketOf = [&](StringPair *P) {
+      return NumTailBuckets - 1 -
+             ((charTailAt(P, T.Pos) + 1) * 257 + charTailAt(P, T.Pos + 1) + 1);
+    };
+    std::fill(BucketStart.begin(), BucketStart.end(), 0);
+    for (StringPair *P : T.Vec)
+      ++BucketStart[BucketOf(P) + 1];
+    for (size_t B = 1; B <= NumTailBuckets; ++B)
+      BucketStart[B] += BucketStart[B - 1];
+    Scratch.resize(T.Vec.size());
+    for (StringPair *P : T.Vec)
+      Scratch[BucketStart[BucketOf(P)]++] = P;
+    std::copy(Scratch.begin(), Scratch.end(), T.Vec.begin());
+
+    // BucketStart[B] is now the end of bucket B. Strings are unique, so a
+    // bucket of strings which end within the two characters holds at most one
+    // string and needs no sorting.
+    size_t Begin = 0;
+    for (size_t B = 0; B != NumTailBuckets; ++B) {
+      size_t End = BucketStart[B];
+      if (End - Begin > 1)
+        Worklist.push_back({T.Vec.slice(Begin, End - Begin), T.Pos + 2});
+      Begin = End;
+    }
+  }
+
+  parallel::for_each(parallel::par, Tasks.begin(), Tasks.end(),
+                     [](SortTask &T) { multikeySort(T.Vec, T.Pos); });
+}
+
 void StringTableBuilder::finalize() {
   assert(K != DWARF);
   finalizeStringTable(/*Optimize=*/true);
@@ -133,13 +202,32 @@ void StringTableBuilder::finalizeStringTable(bool Optimize) {
     for (StringPair &P : StringIndexMap)
       Strings.push_back(&P);
 
-    multikeySort(Strings, 0);
+    bool Parallel = Strings.size() >= MinParallelStrings;
+    if (Parallel)
+      parallelMultikeySort(Strings);
+    else
+      multikeySort(Strings, 0);
     initSize();
 
-    StringRef Previous;
-    for (StringPair *P : Strings) {
+    // A string can share the bytes of the last string placed in the table if
+    // it is a suffix of it. In the sorted order, that is the case exactly when
+    // it is a suffix of the string right before it.
+    std::vector<uint8_t> IsSuffix(Strings.size());
+    auto ComputeIsSuffix = [&](size_t I) {
+      StringRef Previous = I ? Strings[I - 1]->first.val() : StringRef();
+      IsSuffix[I] = Previous.endswith(Strings[I]->first.val());
+    };
+    if (Parallel)
+      parallel::for_each_n(parallel::par, size_t(0), Strings.size(),
+                           ComputeIsSuffix);
+    else
+      for (size_t I = 0, E = Strings.size(); I != E; ++I)
+        ComputeIsSuffix(I);
+
+    for (size_t I = 0, E = Strings.size(); I != E; ++I) {
+      StringPair *P = Strings[I];
       StringRef S = P->first.val();
-      if (Previous.endswith(S)) {
+      if (IsSuffix[I]) {
         size_t Pos = Size - S.size() - (K != RAW);
         if (!(Pos & (Alignment - 1))) {
           P->second = Pos;
@@ -153,7 +241,6 @@ void StringTableBuilder::finalizeStringTable(bool Optimize) {
       Size += S.size();
       if (K != RAW)
         ++Size;
-      Previous = S;
     }
   }
 
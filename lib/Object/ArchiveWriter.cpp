@@ -14,8 +14,10 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/BinaryFormat/Magic.h"
+#include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Object/Archive.h"
+#include "llvm/Object/IRObjectFile.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/SymbolicFile.h"
 #include "llvm/Support/EndianStream.h"
@@ -23,6 +25,8 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -345,9 +349,30 @@ static void writeSymbolTable(raw_ostream &Out, object::Archive::Kind Kind,
 }
 
 static Expected<std::vector<unsigned>>
-getSymbols(MemoryBufferRef Buf, raw_ostream &SymNames, bool &HasObject) {
+getSymbols(MemoryBufferRef Buf, raw_ostream &SymNames, bool &HasObject,
+           bool UseIRSymtab) {
   std::vector<unsigned> Ret;
 
+  if (UseIRSymtab && identify_magic(Buf.getBuffer()) == file_magic::bitcode) {
+    // Modules that have no symbol table and cannot get one, for instance
+    // because they lack a data layout, are loaded below.
+    Expected<object::IRSymtabFile> FOrErr = object::readIRSymtab(Buf);
+    if (FOrErr) {
+      HasObject = true;
+      for (const irsymtab::Reader::SymbolRef &S :
+           FOrErr->TheReader.symbols()) {
+        // These are the flags of the IRObjectFile symbols that
+        // isArchiveSymbol checks.
+        if (S.isFormatSpecific() || !S.isGlobal() || S.isUndefined())
+          continue;
+        Ret.push_back(SymNames.tell());
+        SymNames << S.getName() << '\0';
+      }
+      return Ret;
+    }
+    consumeError(FOrErr.takeError());
+  }
+
   // In the scenario when LLVMContext is populated SymbolicFile will contain a
   // reference to it, thus SymbolicFile should be destroyed first.
   LLVMContext Context;
@@ -383,10 +408,56 @@ getSymbols(MemoryBufferRef Buf, raw_ostream &SymNames, bool &HasObject) {
   return Ret;
 }
 
+namespace {
+/// The result of getSymbols for one member, with name offsets relative to
+/// the start of Names.
+struct MemberSymbols {
+  std::vector<unsigned> Offsets;
+  std::string Names;
+  bool IsObject = false;
+  std::error_code EC;
+};
+} // namespace
+
+/// Reads the symbols of every member, in parallel if requested. The results
+/// are in member order so that the symbol table does not depend on the
+/// scheduling.
+static std::vector<MemberSymbols>
+getMemberSymbols(ArrayRef<NewArchiveMember> NewMembers,
+                 const ArchiveSymtabOptions &Options) {
+  std::vector<MemberSymbols> Ret(NewMembers.size());
+  auto GetSymbols = [&](size_t I) {
+    MemberSymbols &Syms = Ret[I];
+    raw_string_ostream Names(Syms.Names);
+    Expected<std::vector<unsigned>> OffsetsOrErr =
+        getSymbols(NewMembers[I].Buf->getMemBufferRef(), Names, Syms.IsObject,
+                   Options.UseIRSymtab);
+    Names.flush();
+    if (OffsetsOrErr)
+      Syms.Offsets = std::move(*OffsetsOrErr);
+    else
+      Syms.EC = errorToErrorCode(OffsetsOrErr.takeError());
+  };
+
+  if (Options.NumThreads == 1 || NewMembers.size() < 2) {
+    for (size_t I = 0; I != NewMembers.size(); ++I)
+      GetSymbols(I);
+    return Ret;
+  }
+
+  ThreadPool Pool(Options.NumThreads ? Options.NumThreads
+                                     : heavyweight_hardware_concurrency());
+  for (size_t I = 0; I != NewMembers.size(); ++I)
+    Pool.async(GetSymbols, I);
+  Pool.wait();
+  return Ret;
+}
+
 static Expected<std::vector<MemberData>>
 computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
                   object::Archive::Kind Kind, bool Thin, bool Deterministic,
-                  ArrayRef<NewArchiveMember> NewMembers) {
+                  ArrayRef<NewArchiveMember> NewMembers,
+                  const ArchiveSymtabOptions &SymtabOptions) {
   static char PaddingData[8] = {'\n', '\n', '\n', '\n', '\n', '\n', '\n', '\n'};
 
   // This ignores the symbol table, but we only need the value mod 8 and the
@@ -451,7 +522,11 @@ computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
       Entry.second = Entry.second > 1 ? 1 : 0;
   }
 
-  for (const NewArchiveMember &M : NewMembers) {
+  std::vector<MemberSymbols> MembersSymbols =
+      getMemberSymbols(NewMembers, SymtabOptions);
+
+  for (size_t I = 0; I != NewMembers.size(); ++I) {
+    const NewArchiveMember &M = NewMembers[I];
     std::string Header;
     raw_string_ostream Out(Header);
 
@@ -477,13 +552,17 @@ computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
                       ModTime, Buf.getBufferSize() + MemberPadding);
     Out.flush();
 
-    Expected<std::vector<unsigned>> Symbols =
-        getSymbols(Buf, SymNames, HasObject);
-    if (auto E = Symbols.takeError())
-      return std::move(E);
+    MemberSymbols &Syms = MembersSymbols[I];
+    if (Syms.EC)
+      return errorCodeToError(Syms.EC);
+    std::vector<unsigned> Symbols;
+    for (unsigned Offset : Syms.Offsets)
+      Symbols.push_back(SymNames.tell() + Offset);
+    SymNames << Syms.Names;
+    HasObject |= Syms.IsObject;
 
     Pos += Header.size() + Data.size() + Padding.size();
-    Ret.push_back({std::move(*Symbols), std::move(Header), Data, Padding});
+    Ret.push_back({std::move(Symbols), std::move(Header), Data, Padding});
   }
   // If there are no symbols, emit an empty symbol table, to satisfy Solaris
   // tools, older versions of which expect a symbol table in a non-empty
@@ -522,7 +601,8 @@ std::string computeArchiveRelativePath(StringRef From, StringRef To) {
 Error writeArchive(StringRef ArcName, ArrayRef<NewArchiveMember> NewMembers,
                    bool WriteSymtab, object::Archive::Kind Kind,
                    bool Deterministic, bool Thin,
-                   std::unique_ptr<MemoryBuffer> OldArchiveBuf) {
+                   std::unique_ptr<MemoryBuffer> OldArchiveBuf,
+                   const ArchiveSymtabOptions &SymtabOptions) {
   assert((!Thin || !isBSDLike(Kind)) && "Only the gnu format has a thin mode");
 
   SmallString<0> SymNamesBuf;
@@ -530,8 +610,9 @@ Error writeArchive(StringRef ArcName, ArrayRef<NewArchiveMember> NewMembers,
   SmallString<0> StringTableBuf;
   raw_svector_ostream StringTable(StringTableBuf);
 
-  Expected<std::vector<MemberData>> DataOrErr = computeMemberData(
-      StringTable, SymNames, Kind, Thin, Deterministic, NewMembers);
+  Expected<std::vector<MemberData>> DataOrErr =
+      computeMemberData(StringTable, SymNames, Kind, Thin, Deterministic,
+                        NewMembers, SymtabOptions);
   if (Error E = DataOrErr.takeError())
     return E;
   std::vector<MemberData> &Data = *DataOrErr;
@@ -187,6 +187,33 @@ FunctionSamples::findFunctionSamples(const DILocation *DIL) const {
   return FS;
 }
 
+bool FunctionSamples::decodeContext(
+    StringRef Context,
+    SmallVectorImpl<std::pair<StringRef, LineLocation>> &Callers,
+    StringRef &Leaf) {
+  Callers.clear();
+  SmallVector<StringRef, 8> Frames;
+  Context.split(Frames, " @ ");
+  Leaf = Frames.pop_back_val().trim();
+  if (Leaf.empty())
+    return false;
+
+  // Each caller frame has the form "name:offset[.discriminator]".
+  for (StringRef Frame : Frames) {
+    StringRef CallerName, Loc;
+    std::tie(CallerName, Loc) = Frame.trim().rsplit(':');
+    StringRef OffsetStr, DiscriminatorStr;
+    std::tie(OffsetStr, DiscriminatorStr) = Loc.split('.');
+    uint32_t LineOffset = 0, Discriminator = 0;
+    if (CallerName.empty() || OffsetStr.getAsInteger(10, LineOffset) ||
+        (!DiscriminatorStr.empty() &&
+         DiscriminatorStr.getAsInteger(10, Discriminator)))
+      return false;
+    Callers.emplace_back(CallerName, LineLocation(LineOffset, Discriminator));
+  }
+  return true;
+}
+
 #if !defined(NDEBUG) || defined(LLVM_ENABLE_DUMP)
 LLVM_DUMP_METHOD void FunctionSamples::dump() const { print(dbgs(), 0); }
 #endif
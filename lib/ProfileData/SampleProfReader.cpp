@@ -58,6 +58,59 @@ void SampleProfileReader::dump(raw_ostream &OS) {
     dumpFunctionProfile(I.getKey(), OS);
 }
 
+std::error_code SampleProfileReader::nestContextProfiles() {
+  if (!ProfileIsCS)
+    return sampleprof_error::success;
+
+  // Profiles is modified below, so collect the context keys first. Sort them
+  // to make the result independent of the hash table order.
+  std::vector<std::string> ContextKeys;
+  for (const auto &I : Profiles)
+    if (I.second.hasContext())
+      ContextKeys.push_back(I.getKey());
+  llvm::sort(ContextKeys);
+
+  sampleprof_error Result = sampleprof_error::success;
+  for (const std::string &Key : ContextKeys) {
+    FunctionSamples ContextSamples = std::move(Profiles[Key]);
+    Profiles.erase(Key);
+
+    SmallVector<std::pair<StringRef, LineLocation>, 4> Callers;
+    StringRef Leaf;
+    bool Decoded = FunctionSamples::decodeContext(ContextSamples.getContext(),
+                                                  Callers, Leaf);
+    assert(Decoded && "context was validated when it was read");
+    (void)Decoded;
+    ContextSamples.setContext(StringRef());
+    uint64_t TotalSamples = ContextSamples.getTotalSamples();
+
+    // A caller without a profile of its own would have to be made up with no
+    // head samples, which makes it look never entered. Such a context is
+    // only added to the context-less profile of the function itself.
+    auto CallerIt =
+        Callers.empty() ? Profiles.end() : Profiles.find(Callers.front().first);
+    if (CallerIt == Profiles.end()) {
+      MergeResult(Result, Profiles[Leaf].merge(ContextSamples));
+      continue;
+    }
+
+    // Walk down the inline callsite samples of the outermost caller along
+    // the context. Samples are cumulative, so every frame on the way
+    // accounts for the samples of the context.
+    FunctionSamples *FS = &CallerIt->second;
+    for (unsigned I = 0, E = Callers.size(); I != E; ++I) {
+      MergeResult(Result, FS->addTotalSamples(TotalSamples));
+      StringRef Callee = I + 1 != E ? Callers[I + 1].first : Leaf;
+      FS = &FS->functionSamplesAt(Callers[I].second)[Callee];
+      FS->setName(Callee);
+    }
+    MergeResult(Result, FS->merge(ContextSamples));
+  }
+  ProfileIsCS = false;
+  computeSummary();
+  return Result;
+}
+
 /// Parse \p Input as function head.
 ///
 /// Parse one line of \p Input, and update function name in \p FName,
@@ -221,7 +274,25 @@ std::error_code SampleProfileReaderText::read() {
       }
       Profiles[FName] = FunctionSamples();
       FunctionSamples &FProfile = Profiles[FName];
-      FProfile.setName(FName);
+      // A context-sensitive profile is keyed by its calling context in
+      // brackets, e.g. "[main:3 @ foo:5.1 @ bar]", and holds the samples of
+      // the last function in the context.
+      if (FName.startswith("[") && FName.endswith("]")) {
+        StringRef Context = FName.drop_front().drop_back();
+        SmallVector<std::pair<StringRef, LineLocation>, 4> Callers;
+        StringRef Leaf;
+        if (!FunctionSamples::decodeContext(Context, Callers, Leaf)) {
+          reportError(LineIt.line_number(),
+                      "Expected '[name:NUM[.NUM] @ ... @ name]', found " +
+                          FName);
+          return sampleprof_error::malformed;
+        }
+        FProfile.setName(Leaf);
+        FProfile.setContext(Context);
+        ProfileIsCS = true;
+      } else {
+        FProfile.setName(FName);
+      }
       MergeResult(Result, FProfile.addTotalSamples(NumSamples));
       MergeResult(Result, FProfile.addHeadSamples(NumHeadSamples));
       InlineStack.clear();
@@ -0,0 +1,339 @@
+//===- llvm/Support/SuffixTree.cpp - Tree for substring queries -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the SuffixTree class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/SuffixTree.h"
+#include "llvm/ADT/STLExtras.h"
+
+using namespace llvm;
+
+const unsigned SuffixTreeNode::EmptyIdx;
+const unsigned SuffixTree::EmptyIdx;
+const unsigned SuffixTree::Root;
+
+SuffixTree::SuffixTree(ArrayRef<unsigned> Str, bool OutlinerLeafDescendants)
+    : Str(Str), OutlinerLeafDescendants(OutlinerLeafDescendants) {
+  // A string of length N has N leaves and at most N - 1 internal nodes besides
+  // the root, so the node array never has to grow.
+  Nodes.reserve(2 * Str.size() + 1);
+  EdgeOrder.reserve(2 * Str.size() + 1);
+  insertInternalNode(EmptyIdx, EmptyIdx, EmptyIdx, 0);
+
+  // Keep track of the number of suffixes we have to add of the current
+  // prefix.
+  unsigned SuffixesToAdd = 0;
+
+  // Construct the suffix tree iteratively on each prefix of the string.
+  // PfxEndIdx is the end index of the current prefix.
+  // End is one past the last element in the string.
+  for (unsigned PfxEndIdx = 0, End = Str.size(); PfxEndIdx < End;
+       PfxEndIdx++) {
+    SuffixesToAdd++;
+    LeafEndIdx = PfxEndIdx; // Extend each of the leaves.
+    SuffixesToAdd = extend(PfxEndIdx, SuffixesToAdd);
+  }
+
+  buildChildLists();
+
+  // Set the suffix indices of each leaf.
+  setSuffixIndices();
+}
+
+unsigned SuffixTree::insertLeaf(unsigned Parent, unsigned StartIdx,
+                                unsigned Edge) {
+  assert(StartIdx <= LeafEndIdx && "String can't start after it ends!");
+
+  unsigned N = Nodes.size();
+  Nodes.emplace_back(StartIdx, EmptyIdx, EmptyIdx);
+  EdgeOrder.push_back(NumEdges++);
+  Edges[std::make_pair(Parent, Edge)] = N;
+  return N;
+}
+
+unsigned SuffixTree::insertInternalNode(unsigned Parent, unsigned StartIdx,
+                                        unsigned EndIdx, unsigned Edge) {
+  assert(StartIdx <= EndIdx && "String can't start after it ends!");
+  assert(!(Parent == EmptyIdx && StartIdx != EmptyIdx) &&
+         "Non-root internal nodes must have parents!");
+
+  unsigned N = Nodes.size();
+  Nodes.emplace_back(StartIdx, EndIdx, Root);
+  if (Parent == EmptyIdx) {
+    EdgeOrder.push_back(EmptyIdx);
+    return N;
+  }
+
+  // Internal nodes are only created by splitting an edge, and take the place
+  // of the node at its end.
+  auto It = Edges.find(std::make_pair(Parent, Edge));
+  assert(It != Edges.end() && "Internal nodes must split an existing edge!");
+  EdgeOrder.push_back(EdgeOrder[It->second]);
+  It->second = N;
+  return N;
+}
+
+void SuffixTree::buildChildLists() {
+  // List the children of each node in the order their edges were added.
+  std::vector<std::pair<unsigned, unsigned>> ByOrder(NumEdges);
+  for (const auto &Edge : Edges)
+    ByOrder[EdgeOrder[Edge.second]] = std::make_pair(Edge.first.first,
+                                                     Edge.second);
+  // The edge map is as large as the tree itself; don't keep it around while
+  // the tree is queried.
+  DenseMap<std::pair<unsigned, unsigned>, unsigned>().swap(Edges);
+  std::vector<unsigned>().swap(EdgeOrder);
+  for (const auto &Edge : llvm::reverse(ByOrder)) {
+    SuffixTreeNode &Parent = Nodes[Edge.first];
+    Nodes[Edge.second].NextSibling = Parent.FirstChild;
+    Parent.FirstChild = Edge.second;
+  }
+  std::vector<std::pair<unsigned, unsigned>>().swap(ByOrder);
+
+  // Then reorder them as a per-node child map filled in that order would
+  // iterate over them.
+  for (SuffixTreeNode &Parent : Nodes) {
+    if (Parent.FirstChild == EmptyIdx)
+      continue;
+    DenseMap<unsigned, unsigned> Children;
+    for (unsigned Child = Parent.FirstChild; Child != EmptyIdx;
+         Child = Nodes[Child].NextSibling)
+      Children[Str[Nodes[Child].StartIdx]] = Child;
+    unsigned *Link = &Parent.FirstChild;
+    for (const auto &Child : Children) {
+      *Link = Child.second;
+      Link = &Nodes[Child.second].NextSibling;
+    }
+    *Link = EmptyIdx;
+  }
+}
+
+void SuffixTree::setSuffixIndices() {
+  LeafNodes.reserve(Str.size());
+
+  // Traverse the tree depth-first. The second member is true when all of the
+  // node's children have been visited.
+  std::vector<std::pair<unsigned, bool>> ToVisit;
+  ToVisit.emplace_back(Root, false);
+  while (!ToVisit.empty()) {
+    unsigned CurrIdx = ToVisit.back().first;
+    bool ChildrenVisited = ToVisit.back().second;
+    ToVisit.pop_back();
+    SuffixTreeNode &Curr = Nodes[CurrIdx];
+
+    if (ChildrenVisited) {
+      Curr.RightLeafIdx = LeafNodes.size() - 1;
+      continue;
+    }
+
+    // Is this node a leaf? If it is, give it a suffix index.
+    if (Curr.isLeaf()) {
+      Curr.SuffixIdx = Str.size() - Curr.ConcatLen;
+      Curr.LeftLeafIdx = Curr.RightLeafIdx = LeafNodes.size();
+      LeafNodes.push_back(CurrIdx);
+      continue;
+    }
+
+    Curr.LeftLeafIdx = LeafNodes.size();
+    ToVisit.emplace_back(CurrIdx, true);
+    for (unsigned Child = Curr.FirstChild; Child != EmptyIdx;
+         Child = Nodes[Child].NextSibling) {
+      // Store the concatenation of lengths down from the root.
+      Nodes[Child].ConcatLen = Curr.ConcatLen + nodeSize(Nodes[Child]);
+      ToVisit.emplace_back(Child, false);
+    }
+  }
+}
+
+unsigned SuffixTree::extend(unsigned EndIdx, unsigned SuffixesToAdd) {
+  unsigned NeedsLink = EmptyIdx;
+
+  while (SuffixesToAdd > 0) {
+
+    // Are we waiting to add anything other than just the last character?
+    if (Active.Len == 0) {
+      // If not, then say the active index is the end index.
+      Active.Idx = EndIdx;
+    }
+
+    assert(Active.Idx <= EndIdx && "Start index can't be after end index!");
+
+    // The first character in the current substring we're looking at.
+    unsigned FirstChar = Str[Active.Idx];
+
+    // Have we inserted anything starting with FirstChar at the current node?
+    auto ChildIt = Edges.find(std::make_pair(Active.Node, FirstChar));
+    if (ChildIt == Edges.end()) {
+      // If not, then we can just insert a leaf and move to the next step.
+      insertLeaf(Active.Node, EndIdx, FirstChar);
+
+      // The active node is an internal node, and we visited it, so it must
+      // need a link if it doesn't have one.
+      if (NeedsLink != EmptyIdx) {
+        Nodes[NeedsLink].Link = Active.Node;
+        NeedsLink = EmptyIdx;
+      }
+    } else {
+      // There's a match with FirstChar, so look for the point in the tree to
+      // insert a new node.
+      unsigned NextNode = ChildIt->second;
+
+      unsigned SubstringLen = nodeSize(Nodes[NextNode]);
+
+      // Is the current suffix we're trying to insert longer than the size of
+      // the child we want to move to?
+      if (Active.Len >= SubstringLen) {
+        // If yes, then consume the characters we've seen and move to the next
+        // node.
+        Active.Idx += SubstringLen;
+        Active.Len -= SubstringLen;
+        Active.Node = NextNode;
+        continue;
+      }
+
+      // Otherwise, the suffix we're trying to insert must be contained in the
+      // next node we want to move to.
+      unsigned LastChar = Str[EndIdx];
+
+      // Is the string we're trying to insert a substring of the next node?
+      if (Str[Nodes[NextNode].StartIdx + Active.Len] == LastChar) {
+        // If yes, then we're done for this step. Remember our insertion point
+        // and move to the next end index. At this point, we have an implicit
+        // suffix tree.
+        if (NeedsLink != EmptyIdx && !Nodes[Active.Node].isRoot()) {
+          Nodes[NeedsLink].Link = Active.Node;
+          NeedsLink = EmptyIdx;
+        }
+
+        Active.Len++;
+        break;
+      }
+
+      // The string we're trying to insert isn't a substring of the next node,
+      // but matches up to a point. Split the node.
+      //
+      // For example, say we ended our search at a node n and we're trying to
+      // insert ABD. Then we'll create a new node s for AB, reduce n to just
+      // representing C, and insert a new leaf node l to represent d. This
+      // allows us to ensure that if n was a leaf, it remains a leaf.
+      //
+      //   | ABC  ---split--->  | AB
+      //   n                    s
+      //                     C / \ D
+      //                      n   l
+
+      // The node s from the diagram
+      unsigned NextStartIdx = Nodes[NextNode].StartIdx;
+      unsigned SplitNode =
+          insertInternalNode(Active.Node, NextStartIdx,
+                             NextStartIdx + Active.Len - 1, FirstChar);
+
+      // Insert the new node representing the new substring into the tree as
+      // a child of the split node. This is the node l from the diagram.
+      insertLeaf(SplitNode, EndIdx, LastChar);
+
+      // Make the old node a child of the split node and update its start
+      // index. This is the node n from the diagram.
+      Nodes[NextNode].StartIdx += Active.Len;
+      EdgeOrder[NextNode] = NumEdges++;
+      Edges[std::make_pair(SplitNode, Str[Nodes[NextNode].StartIdx])] =
+          NextNode;
+
+      // SplitNode is an internal node, update the suffix link.
+      if (NeedsLink != EmptyIdx)
+        Nodes[NeedsLink].Link = SplitNode;
+
+      NeedsLink = SplitNode;
+    }
+
+    // We've added something new to the tree, so there's one less suffix to
+    // add.
+    SuffixesToAdd--;
+
+    if (Nodes[Active.Node].isRoot()) {
+      if (Active.Len > 0) {
+        Active.Len--;
+        Active.Idx = EndIdx - SuffixesToAdd + 1;
+      }
+    } else {
+      // Start the next phase at the next smallest suffix.
+      Active.Node = Nodes[Active.Node].Link;
+    }
+  }
+
+  return SuffixesToAdd;
+}
+
+SuffixTree::RepeatedSubstringIterator::RepeatedSubstringIterator(
+    const SuffixTree *ST, unsigned N)
+    : ST(ST), N(N) {
+  // Do we have a non-null node?
+  if (N != EmptyIdx) {
+    // Yes. At the first step, we need to visit all of N's children.
+    // Note: This means that we visit N last.
+    ToVisit.push_back(N);
+    advance();
+  }
+}
+
+void SuffixTree::RepeatedSubstringIterator::advance() {
+  // Clear the current state. If we're at the end of the range, then this
+  // is the state we want to be in.
+  RS = RepeatedSubstring();
+  N = EmptyIdx;
+
+  const std::vector<SuffixTreeNode> &Nodes = ST->Nodes;
+
+  // Continue visiting nodes until we find one which repeats more than once.
+  while (!ToVisit.empty()) {
+    unsigned CurrIdx = ToVisit.back();
+    ToVisit.pop_back();
+    const SuffixTreeNode &Curr = Nodes[CurrIdx];
+
+    // Keep track of the length of the string associated with the node. If
+    // it's too short, we'll quit.
+    unsigned Length = Curr.ConcatLen;
+    bool LongEnough = !Curr.isRoot() && Length >= MinLength;
+
+    // Iterate over each child, saving internal nodes for visiting, and the
+    // suffixes of leaf nodes in the repeated substring. Internal nodes
+    // represent individual strings, which may repeat.
+    for (unsigned Child = Curr.FirstChild; Child != EmptyIdx;
+         Child = Nodes[Child].NextSibling) {
+      if (!Nodes[Child].isLeaf())
+        ToVisit.push_back(Child);
+      else if (LongEnough && !ST->OutlinerLeafDescendants)
+        RS.StartIndices.push_back(Nodes[Child].SuffixIdx);
+    }
+
+    // The root never represents a repeated substring, and neither does a
+    // string that is too short.
+    if (!LongEnough)
+      continue;
+
+    // Every leaf below an internal node is an occurrence of its string.
+    if (ST->OutlinerLeafDescendants)
+      for (unsigned I = Curr.LeftLeafIdx; I <= Curr.RightLeafIdx; ++I)
+        RS.StartIndices.push_back(Nodes[ST->LeafNodes[I]].SuffixIdx);
+
+    // Do we have any repeated substrings?
+    if (RS.StartIndices.size() >= 2) {
+      // Yes. Update the state to reflect this, and then bail out.
+      N = CurrIdx;
+      RS.Length = Length;
+      break;
+    }
+    RS.StartIndices.clear();
+  }
+
+  // At this point, either RS is an empty RepeatedSubstring, or it was set in
+  // the above loop. Similarly, N is either EmptyIdx, or the node associated
+  // with RS.
+}
@@ -47,6 +47,10 @@ public:
 
   void finalizeSchedule() override;
 
+  // Regions are rescheduled in finalizeSchedule() using iterators recorded in
+  // enterRegion(), which would not stay valid across a split region.
+  bool canSplitSchedRegions() const override { return false; }
+
 protected:
   using ScheduleRef = ArrayRef<const SUnit *>;
 
@@ -104,6 +104,10 @@ public:
   void schedule() override;
 
   void finalizeSchedule() override;
+
+  // Regions are rescheduled in finalizeSchedule() using iterators recorded in
+  // schedule(), which would not stay valid across a split region.
+  bool canSplitSchedRegions() const override { return false; }
 };
 
 } // End namespace llvm
@@ -105,6 +105,8 @@ private:
                      MachineFunction &MF) const;
   bool selectCondBranch(MachineInstr &I, MachineRegisterInfo &MRI,
                         MachineFunction &MF) const;
+  bool selectSelect(MachineInstr &I, MachineRegisterInfo &MRI,
+                    MachineFunction &MF) const;
   bool selectTurnIntoCOPY(MachineInstr &I, MachineRegisterInfo &MRI,
                           const unsigned DstReg,
                           const TargetRegisterClass *DstRC,
@@ -380,6 +382,8 @@ bool X86InstructionSelector::select(MachineInstr &I,
     return selectInsert(I, MRI, MF);
   case TargetOpcode::G_BRCOND:
     return selectCondBranch(I, MRI, MF);
+  case TargetOpcode::G_SELECT:
+    return selectSelect(I, MRI, MF);
   case TargetOpcode::G_IMPLICIT_DEF:
   case TargetOpcode::G_PHI:
     return selectImplicitDefOrPHI(I, MRI);
@@ -1427,6 +1431,55 @@ bool X86InstructionSelector::selectCondBranch(MachineInstr &I,
   return true;
 }
 
+bool X86InstructionSelector::selectSelect(MachineInstr &I,
+                                          MachineRegisterInfo &MRI,
+                                          MachineFunction &MF) const {
+  assert((I.getOpcode() == TargetOpcode::G_SELECT) && "unexpected instruction");
+
+  const unsigned DstReg = I.getOperand(0).getReg();
+  const unsigned CondReg = I.getOperand(1).getReg();
+  const unsigned TrueReg = I.getOperand(2).getReg();
+  const unsigned FalseReg = I.getOperand(3).getReg();
+
+  const LLT DstTy = MRI.getType(DstReg);
+  const RegisterBank &DstRB = *RBI.getRegBank(DstReg, MRI, TRI);
+
+  if (DstRB.getID() != X86::GPRRegBankID || !STI.hasCMov())
+    return false;
+
+  unsigned Opcode;
+  switch (DstTy.getSizeInBits()) {
+  case 16:
+    Opcode = X86::CMOV16rr;
+    break;
+  case 32:
+    Opcode = X86::CMOV32rr;
+    break;
+  case 64:
+    Opcode = X86::CMOV64rr;
+    break;
+  default:
+    return false;
+  }
+
+  MachineInstr &TestInst =
+      *BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(X86::TEST8ri))
+           .addReg(CondReg)
+           .addImm(1);
+  MachineInstr &CmovInst =
+      *BuildMI(*I.getParent(), I, I.getDebugLoc(), TII.get(Opcode), DstReg)
+           .addReg(FalseReg)
+           .addReg(TrueReg)
+           .addImm(X86::COND_NE);
+
+  if (!constrainSelectedInstRegOperands(TestInst, TII, TRI, RBI) ||
+      !constrainSelectedInstRegOperands(CmovInst, TII, TRI, RBI))
+    return false;
+
+  I.eraseFromParent();
+  return true;
+}
+
 bool X86InstructionSelector::materializeFP(MachineInstr &I,
                                            MachineRegisterInfo &MRI,
                                            MachineFunction &MF) const {
@@ -142,6 +142,13 @@ void X86LegalizerInfo::setLegalizerInfo32bit() {
       .legalFor({{s8, s8}, {s16, s8}, {s32, s8}})
       .clampScalar(0, s8, s32)
       .clampScalar(1, s8, s8);
+
+    // Selects, which are only selected to CMOV.
+    if (Subtarget.hasCMov())
+      getActionDefinitionsBuilder(G_SELECT)
+          .legalFor({{s16, s1}, {s32, s1}, {p0, s1}})
+          .clampScalar(0, s16, s32)
+          .widenScalarToNextPow2(0);
   }
 
   // Control-flow
@@ -254,6 +261,12 @@ void X86LegalizerInfo::setLegalizerInfo64bit() {
     .clampScalar(0, s8, s64)
     .clampScalar(1, s8, s8);
 
+  // Selects
+  getActionDefinitionsBuilder(G_SELECT)
+      .legalFor({{s16, s1}, {s32, s1}, {s64, s1}, {p0, s1}})
+      .clampScalar(0, s16, s64)
+      .widenScalarToNextPow2(0);
+
   // Merge/Unmerge
   setAction({G_MERGE_VALUES, s128}, Legal);
   setAction({G_UNMERGE_VALUES, 1, s128}, Legal);
@@ -322,6 +335,9 @@ void X86LegalizerInfo::setLegalizerInfoSSE2() {
   setAction({G_FPTRUNC, s32}, Legal);
   setAction({G_FPTRUNC, 1, s64}, Legal);
 
+  // There is no instruction for these, call the C library instead.
+  getActionDefinitionsBuilder({G_FREM, G_FPOW}).libcallFor({s32, s64});
+
   // Constants
   setAction({TargetOpcode::G_FCONSTANT, s64}, Legal);
 
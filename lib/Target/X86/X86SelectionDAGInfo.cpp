@@ -18,11 +18,78 @@
 #include "llvm/CodeGen/SelectionDAG.h"
 #include "llvm/CodeGen/TargetLowering.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/Support/CommandLine.h"
 
 using namespace llvm;
 
 #define DEBUG_TYPE "x86-selectiondag-info"
 
+static cl::opt<bool> RepStrForConstantSizes(
+    "x86-rep-str-constant-sizes", cl::Hidden, cl::init(false),
+    cl::desc("Also lower memcpy and memset of constant sizes above the "
+             "inline threshold to REP MOVSB/STOSB on processors with fast "
+             "strings, not only those with a value profile"));
+
+static cl::opt<unsigned> RepStrMinSize(
+    "x86-rep-str-min-size", cl::Hidden, cl::init(2048),
+    cl::desc("Smallest memcpy or memset lowered to REP MOVSB/STOSB instead "
+             "of a library call, unless REP MOVSB is fast for short sizes"));
+
+static cl::opt<unsigned> RepStrMaxSize(
+    "x86-rep-str-max-size", cl::Hidden, cl::init(1 << 20),
+    cl::desc("Largest memcpy or memset lowered to REP MOVSB/STOSB instead of "
+             "a library call"));
+
+static cl::opt<unsigned> RepStrProfileOutlierPercent(
+    "x86-rep-str-profile-outlier-percent", cl::Hidden, cl::init(10),
+    cl::desc("Percentage of the profiled executions of a memcpy or memset of "
+             "unknown size that may fall outside of the REP MOVSB/STOSB size "
+             "range for it to be lowered to REP MOVSB/STOSB"));
+
+/// Returns true if a fast-strings REP MOVSB (\p IsMovs) or REP STOSB of
+/// \p Size bytes is expected to beat a call to the library function. Very
+/// large sizes are left to the library, which can use non-temporal stores.
+static bool isRepStrProfitable(const X86Subtarget &Subtarget, uint64_t Size,
+                               bool IsMovs) {
+  if (!Subtarget.hasERMSB())
+    return false;
+  uint64_t MinSize = IsMovs && Subtarget.hasFSRM() ? 0 : RepStrMinSize;
+  return Size >= MinSize && Size <= RepStrMaxSize;
+}
+
+/// Returns true if almost all profiled executions of a memcpy or memset have a
+/// size for which REP MOVSB/STOSB is profitable.
+static bool isRepStrProfitable(const X86Subtarget &Subtarget,
+                               const MemOpSizeProfile &Profile, bool IsMovs) {
+  uint64_t Outliers = Profile.TotalCount;
+  for (const auto &Entry : Profile.Sizes)
+    if (isRepStrProfitable(Subtarget, Entry.first, IsMovs))
+      Outliers -= std::min(Entry.second, Outliers);
+  // Executions that were not attributed to a size are counted as outliers.
+  return Outliers * 100 <= Profile.TotalCount * RepStrProfileOutlierPercent;
+}
+
+/// Emit a single REP STOSB instruction storing the byte \p Val.
+static SDValue emitRepstosB(const X86Subtarget &Subtarget, SelectionDAG &DAG,
+                            const SDLoc &dl, SDValue Chain, SDValue Dst,
+                            SDValue Val, SDValue Size) {
+  const bool Use64BitRegs = Subtarget.isTarget64BitLP64();
+  const unsigned CX = Use64BitRegs ? X86::RCX : X86::ECX;
+  const unsigned DI = Use64BitRegs ? X86::RDI : X86::EDI;
+
+  SDValue InFlag;
+  Chain = DAG.getCopyToReg(Chain, dl, X86::AL, Val, InFlag);
+  InFlag = Chain.getValue(1);
+  Chain = DAG.getCopyToReg(Chain, dl, CX, Size, InFlag);
+  InFlag = Chain.getValue(1);
+  Chain = DAG.getCopyToReg(Chain, dl, DI, Dst, InFlag);
+  InFlag = Chain.getValue(1);
+
+  SDVTList Tys = DAG.getVTList(MVT::Other, MVT::Glue);
+  SDValue Ops[] = {Chain, DAG.getValueType(MVT::i8), InFlag};
+  return DAG.getNode(X86ISD::REP_STOS, dl, Tys, Ops);
+}
+
 bool X86SelectionDAGInfo::isBaseRegConflictPossible(
     SelectionDAG &DAG, ArrayRef<MCPhysReg> ClobberSet) const {
   // We cannot use TRI->hasBasePointer() until *after* we select all basic
@@ -51,17 +118,33 @@ SDValue X86SelectionDAGInfo::EmitTargetCodeForMemset(
   const X86Subtarget &Subtarget =
       DAG.getMachineFunction().getSubtarget<X86Subtarget>();
 
-#ifndef NDEBUG
-  // If the base register might conflict with our physical registers, bail out.
   const MCPhysReg ClobberSet[] = {X86::RCX, X86::RAX, X86::RDI,
                                   X86::ECX, X86::EAX, X86::EDI};
-  assert(!isBaseRegConflictPossible(DAG, ClobberSet));
-#endif
 
   // If to a segment-relative address space, use the default lowering.
   if (DstPtrInfo.getAddrSpace() >= 256)
     return SDValue();
 
+  // With fast strings, REP STOSB beats a library call for mid-sized sets
+  // regardless of alignment.
+  if (RepStrForConstantSizes && ConstantSize &&
+      ConstantSize->getZExtValue() > Subtarget.getMaxInlineSizeThreshold() &&
+      isRepStrProfitable(Subtarget, ConstantSize->getZExtValue(),
+                         /*IsMovs=*/false)) {
+    // If the base register might conflict with our physical registers, use
+    // the library call.
+    if (isBaseRegConflictPossible(DAG, ClobberSet))
+      return SDValue();
+    if (ConstantSDNode *ValC = dyn_cast<ConstantSDNode>(Val))
+      Val = DAG.getConstant(ValC->getZExtValue() & 255, dl, MVT::i8);
+    return emitRepstosB(Subtarget, DAG, dl, Chain, Dst, Val,
+                        DAG.getIntPtrConstant(ConstantSize->getZExtValue(),
+                                              dl));
+  }
+
+  // If the base register might conflict with our physical registers, bail out.
+  assert(!isBaseRegConflictPossible(DAG, ClobberSet));
+
   // If not DWORD aligned or size is more than the threshold, call the library.
   // The libc version is likely to be faster for these cases. It can use the
   // address value and run time information about the CPU.
@@ -239,10 +322,14 @@ static SDValue emitConstantSizeRepmov(
     unsigned Align, bool isVolatile, bool AlwaysInline,
     MachinePointerInfo DstPtrInfo, MachinePointerInfo SrcPtrInfo) {
 
-  /// TODO: Revisit next line: big copy with ERMSB on march >= haswell are very
-  /// efficient.
-  if (!AlwaysInline && Size > Subtarget.getMaxInlineSizeThreshold())
-    return SDValue();
+  /// Beyond the inline threshold, only a fast-strings REP MOVSB is expected to
+  /// beat the library call.
+  if (!AlwaysInline && Size > Subtarget.getMaxInlineSizeThreshold()) {
+    if (!RepStrForConstantSizes ||
+        !isRepStrProfitable(Subtarget, Size, /*IsMovs=*/true))
+      return SDValue();
+    return emitRepmovsB(Subtarget, DAG, dl, Chain, Dst, Src, Size);
+  }
 
   /// If we have enhanced repmovs we use it.
   if (Subtarget.hasERMSB())
@@ -316,3 +403,50 @@ SDValue X86SelectionDAGInfo::EmitTargetCodeForMemcpy(
 
   return SDValue();
 }
+
+SDValue X86SelectionDAGInfo::EmitTargetCodeForProfiledMemset(
+    SelectionDAG &DAG, const SDLoc &dl, SDValue Chain, SDValue Dst, SDValue Val,
+    SDValue Size, const MemOpSizeProfile &Profile, unsigned Align,
+    bool isVolatile, MachinePointerInfo DstPtrInfo) const {
+  // If to a segment-relative address space, use the default lowering.
+  if (DstPtrInfo.getAddrSpace() >= 256)
+    return SDValue();
+
+  const MCPhysReg ClobberSet[] = {X86::RCX, X86::RAX, X86::RDI,
+                                  X86::ECX, X86::EAX, X86::EDI};
+  if (isBaseRegConflictPossible(DAG, ClobberSet))
+    return SDValue();
+
+  const X86Subtarget &Subtarget =
+      DAG.getMachineFunction().getSubtarget<X86Subtarget>();
+  if (!isRepStrProfitable(Subtarget, Profile, /*IsMovs=*/false))
+    return SDValue();
+
+  MVT CountVT = Subtarget.isTarget64BitLP64() ? MVT::i64 : MVT::i32;
+  return emitRepstosB(Subtarget, DAG, dl, Chain, Dst, Val,
+                      DAG.getZExtOrTrunc(Size, dl, CountVT));
+}
+
+SDValue X86SelectionDAGInfo::EmitTargetCodeForProfiledMemcpy(
+    SelectionDAG &DAG, const SDLoc &dl, SDValue Chain, SDValue Dst, SDValue Src,
+    SDValue Size, const MemOpSizeProfile &Profile, unsigned Align,
+    bool isVolatile, MachinePointerInfo DstPtrInfo,
+    MachinePointerInfo SrcPtrInfo) const {
+  // If to a segment-relative address space, use the default lowering.
+  if (DstPtrInfo.getAddrSpace() >= 256 || SrcPtrInfo.getAddrSpace() >= 256)
+    return SDValue();
+
+  const MCPhysReg ClobberSet[] = {X86::RCX, X86::RSI, X86::RDI,
+                                  X86::ECX, X86::ESI, X86::EDI};
+  if (isBaseRegConflictPossible(DAG, ClobberSet))
+    return SDValue();
+
+  const X86Subtarget &Subtarget =
+      DAG.getMachineFunction().getSubtarget<X86Subtarget>();
+  if (!isRepStrProfitable(Subtarget, Profile, /*IsMovs=*/true))
+    return SDValue();
+
+  MVT CountVT = Subtarget.isTarget64BitLP64() ? MVT::i64 : MVT::i32;
+  return emitRepmovs(Subtarget, DAG, dl, Chain, Dst, Src,
+                     DAG.getZExtOrTrunc(Size, dl, CountVT), MVT::i8);
+}
@@ -42,6 +42,18 @@ public:
                                   bool AlwaysInline,
                                   MachinePointerInfo DstPtrInfo,
                                   MachinePointerInfo SrcPtrInfo) const override;
+
+  SDValue EmitTargetCodeForProfiledMemset(
+      SelectionDAG &DAG, const SDLoc &dl, SDValue Chain, SDValue Dst,
+      SDValue Src, SDValue Size, const MemOpSizeProfile &Profile,
+      unsigned Align, bool isVolatile,
+      MachinePointerInfo DstPtrInfo) const override;
+
+  SDValue EmitTargetCodeForProfiledMemcpy(
+      SelectionDAG &DAG, const SDLoc &dl, SDValue Chain, SDValue Dst,
+      SDValue Src, SDValue Size, const MemOpSizeProfile &Profile,
+      unsigned Align, bool isVolatile, MachinePointerInfo DstPtrInfo,
+      MachinePointerInfo SrcPtrInfo) const override;
 };
 
 }
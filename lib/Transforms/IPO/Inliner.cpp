@@ -81,6 +81,8 @@ STATISTIC(NumMergedAllocas, "Number of allocas merged together");
 // to inline a function A into B, we analyze the callers of B in order to see
 // if those would be more profitable and blocked inline steps.
 STATISTIC(NumCallerCallersAnalyzed, "Number of caller-callers analyzed");
+STATISTIC(NumCallerCallersCached,
+          "Number of caller-caller inline costs reused from the cache");
 
 /// Flag to disable manual alloca merging.
 ///
@@ -298,6 +300,13 @@ static InlineResult InlineCallIfPossible(
   return IR; // success
 }
 
+/// Inline costs of the call sites to a candidate's caller, as computed by
+/// shouldBeDeferred. Every candidate in the same caller asks for the costs of
+/// the same outer call sites, so they are remembered here. The entries are
+/// only valid as long as the IR is unchanged: the cache must be cleared
+/// whenever a call site is inlined or deleted.
+using CallerCallerCostCacheTy = DenseMap<Instruction *, InlineCost>;
+
 /// Return true if inlining of CS can block the caller from being
 /// inlined which is proved to be more beneficial. \p IC is the
 /// estimated inline cost associated with callsite \p CS.
@@ -306,7 +315,8 @@ static InlineResult InlineCallIfPossible(
 static bool
 shouldBeDeferred(Function *Caller, CallSite CS, InlineCost IC,
                  int &TotalSecondaryCost,
-                 function_ref<InlineCost(CallSite CS)> GetInlineCost) {
+                 function_ref<InlineCost(CallSite CS)> GetInlineCost,
+                 CallerCallerCostCacheTy &CallerCallerCosts) {
   // For now we only handle local or inline functions.
   if (!Caller->hasLocalLinkage() && !Caller->hasLinkOnceODRLinkage())
     return false;
@@ -355,8 +365,16 @@ shouldBeDeferred(Function *Caller, CallSite CS, InlineCost IC,
       continue;
     }
 
-    InlineCost IC2 = GetInlineCost(CS2);
-    ++NumCallerCallersAnalyzed;
+    auto CacheIt = CallerCallerCosts.find(CS2.getInstruction());
+    if (CacheIt == CallerCallerCosts.end()) {
+      CacheIt =
+          CallerCallerCosts.insert({CS2.getInstruction(), GetInlineCost(CS2)})
+              .first;
+      ++NumCallerCallersAnalyzed;
+    } else {
+      ++NumCallerCallersCached;
+    }
+    InlineCost IC2 = CacheIt->second;
     if (!IC2) {
       ApplyLastCallBonus = false;
       continue;
@@ -417,7 +435,8 @@ static std::string inlineCostStr(const InlineCost &IC) {
 /// using that cost, so we won't do so from this function.
 static Optional<InlineCost>
 shouldInline(CallSite CS, function_ref<InlineCost(CallSite CS)> GetInlineCost,
-             OptimizationRemarkEmitter &ORE) {
+             OptimizationRemarkEmitter &ORE,
+             CallerCallerCostCacheTy &CallerCallerCosts) {
   using namespace ore;
 
   InlineCost IC = GetInlineCost(CS);
@@ -455,7 +474,8 @@ shouldInline(CallSite CS, function_ref<InlineCost(CallSite CS)> GetInlineCost,
   }
 
   int TotalSecondaryCost = 0;
-  if (shouldBeDeferred(Caller, CS, IC, TotalSecondaryCost, GetInlineCost)) {
+  if (shouldBeDeferred(Caller, CS, IC, TotalSecondaryCost, GetInlineCost,
+                       CallerCallerCosts)) {
     LLVM_DEBUG(dbgs() << "    NOT Inlining: " << *CS.getInstruction()
                       << " Cost = " << IC.getCost()
                       << ", outer Cost = " << TotalSecondaryCost << '\n');
@@ -604,6 +624,7 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
 
   InlinedArrayAllocasTy InlinedArrayAllocas;
   InlineFunctionInfo InlineInfo(&CG, &GetAssumptionCache, PSI);
+  CallerCallerCostCacheTy CallerCallerCosts;
 
   // Now that we have all of the call sites, loop over them and inline them if
   // it looks profitable to do so.
@@ -648,7 +669,8 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
       // just become a regular analysis dependency.
       OptimizationRemarkEmitter ORE(Caller);
 
-      Optional<InlineCost> OIC = shouldInline(CS, GetInlineCost, ORE);
+      Optional<InlineCost> OIC =
+          shouldInline(CS, GetInlineCost, ORE, CallerCallerCosts);
       // If the policy determines that we should inline this function,
       // delete the call instead.
       if (!OIC.hasValue()) {
@@ -745,6 +767,10 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
       }
       --CSi;
 
+      // Deleting or inlining the call changed the IR, so costs computed
+      // before may no longer hold.
+      CallerCallerCosts.clear();
+
       Changed = true;
       LocalChange = true;
     }
@@ -1017,6 +1043,7 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
     // We bail out as soon as the caller has to change so we can update the
     // call graph and prepare the context of that new caller.
     bool DidInline = false;
+    CallerCallerCostCacheTy CallerCallerCosts;
     for (; i < (int)Calls.size() && Calls[i].first.getCaller() == &F; ++i) {
       int InlineHistoryID;
       CallSite CS;
@@ -1043,7 +1070,8 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
         continue;
       }
 
-      Optional<InlineCost> OIC = shouldInline(CS, GetInlineCost, ORE);
+      Optional<InlineCost> OIC =
+          shouldInline(CS, GetInlineCost, ORE, CallerCallerCosts);
       // Check whether we want to inline this callsite.
       if (!OIC.hasValue()) {
         setInlineRemark(CS, "deferred");
@@ -1082,6 +1110,7 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
       }
       DidInline = true;
       InlinedCallees.insert(&Callee);
+      CallerCallerCosts.clear();
 
       ++NumInlined;
 
@@ -119,6 +119,7 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/Utils/FunctionComparator.h"
@@ -137,6 +138,10 @@ STATISTIC(NumFunctionsMerged, "Number of functions merged");
 STATISTIC(NumThunksWritten, "Number of thunks generated");
 STATISTIC(NumAliasesWritten, "Number of aliases generated");
 STATISTIC(NumDoubleWeak, "Number of new functions created");
+STATISTIC(NumFunctionComparisons,
+          "Number of full function comparisons performed");
+STATISTIC(NumHashBuckets,
+          "Number of groups of functions sharing a structural hash");
 
 static cl::opt<unsigned> NumFunctionsForSanityCheck(
     "mergefunc-sanity",
@@ -165,6 +170,16 @@ static cl::opt<bool>
                       cl::desc("Preserve debug info in thunk when mergefunc "
                                "transformations are made."));
 
+// Under option -mergefunc-parallel-hash the initial structural hashes of all
+// functions in the module are computed using the llvm::parallel thread pool.
+// Hashing only reads the IR, and the resulting order of candidates is the same
+// as with sequential hashing.
+static cl::opt<bool>
+    MergeFunctionsParallelHash("mergefunc-parallel-hash", cl::Hidden,
+                               cl::init(false),
+                               cl::desc("Compute function hashes for "
+                                        "mergefunc in parallel."));
+
 static cl::opt<bool>
     MergeFunctionsAliases("mergefunc-use-aliases", cl::Hidden,
                           cl::init(false),
@@ -219,6 +234,7 @@ private:
       // Order first by hashes, then full function comparison.
       if (LHS.getHash() != RHS.getHash())
         return LHS.getHash() < RHS.getHash();
+      ++NumFunctionComparisons;
       FunctionComparator FCmp(LHS.getFunc(), RHS.getFunc(), GlobalNumbers);
       return FCmp.compare() == -1;
     }
@@ -397,19 +413,33 @@ bool MergeFunctions::runOnModule(Module &M) {
     HashedFuncs;
   for (Function &Func : M) {
     if (isEligibleForMerging(Func)) {
-      HashedFuncs.push_back({FunctionComparator::functionHash(Func), &Func});
+      HashedFuncs.push_back({0, &Func});
     }
   }
 
+  auto HashFunc = [&](size_t I) {
+    HashedFuncs[I].first =
+        FunctionComparator::functionHash(*HashedFuncs[I].second);
+  };
+  if (MergeFunctionsParallelHash)
+    parallel::for_each_n(parallel::par, size_t(0), HashedFuncs.size(),
+                         HashFunc);
+  else
+    parallel::for_each_n(parallel::seq, size_t(0), HashedFuncs.size(),
+                         HashFunc);
+
   llvm::stable_sort(HashedFuncs, less_first());
 
   auto S = HashedFuncs.begin();
   for (auto I = HashedFuncs.begin(), IE = HashedFuncs.end(); I != IE; ++I) {
     // If the hash value matches the previous value or the next one, we must
     // consider merging it. Otherwise it is dropped and never considered again.
-    if ((I != S && std::prev(I)->first == I->first) ||
-        (std::next(I) != IE && std::next(I)->first == I->first) ) {
+    bool SameAsPrev = I != S && std::prev(I)->first == I->first;
+    bool SameAsNext = std::next(I) != IE && std::next(I)->first == I->first;
+    if (SameAsPrev || SameAsNext) {
       Deferred.push_back(WeakTrackingVH(I->second));
+      if (!SameAsPrev)
+        ++NumHashBuckets;
     }
   }
 
@@ -1567,6 +1567,14 @@ bool SampleProfileLoader::doInitialization(Module &M) {
   Reader->collectFuncsToUse(M);
   ProfileIsValid = (Reader->read() == sampleprof_error::success);
 
+  // Context-sensitive profiles are applied by nesting them into the inline
+  // callsite samples of their outermost caller: the early inliner then
+  // inlines along hot contexts and annotates each inlined copy with the
+  // samples of its own context.
+  if (ProfileIsValid && Reader->profileIsCS())
+    ProfileIsValid =
+        (Reader->nestContextProfiles() == sampleprof_error::success);
+
   if (!RemappingFilename.empty()) {
     // Apply profile remappings to the loaded profile data if requested.
     // For now, we only support remapping symbols encoded using the Itanium
@@ -894,20 +894,61 @@ public:
 
 } // end anonymous namespace
 
-// A function hash is calculated by considering only the number of arguments and
-// whether a function is varargs, the order of basic blocks (given by the
-// successors of each basic block in depth first order), and the order of
-// opcodes of each instruction within each of these basic blocks. This mirrors
-// the strategy compare() uses to compare functions by walking the BBs in depth
-// first order and comparing each instruction in sequence. Because this hash
-// does not look at the operands, it is insensitive to things such as the
-// target of calls and the constants used in the function, which makes it useful
-// when possibly merging functions which are the same modulo constants and call
-// targets.
+// Hash the parts of a type that cmpTypes() always looks at, without recursing
+// into element types. Pointers in address space 0 compare equal to integers of
+// pointer width, so they have to hash like those integers. This must not
+// inspect anything cmpTypes() ignores, and must not create new types, as
+// functionHash may be called from several threads at once.
+static uint64_t hashTypeShallow(Type *Ty, const DataLayout &DL) {
+  PointerType *PTy = dyn_cast<PointerType>(Ty);
+  if (PTy && PTy->getAddressSpace() == 0)
+    return hash_combine(Type::IntegerTyID, DL.getPointerSizeInBits(0));
+
+  switch (Ty->getTypeID()) {
+  case Type::IntegerTyID:
+    return hash_combine(Type::IntegerTyID,
+                        cast<IntegerType>(Ty)->getBitWidth());
+  case Type::PointerTyID:
+    return hash_combine(Type::PointerTyID, PTy->getAddressSpace());
+  case Type::StructTyID: {
+    StructType *STy = cast<StructType>(Ty);
+    return hash_combine(Type::StructTyID, STy->getNumElements(),
+                        STy->isPacked());
+  }
+  case Type::FunctionTyID: {
+    FunctionType *FTy = cast<FunctionType>(Ty);
+    return hash_combine(Type::FunctionTyID, FTy->getNumParams(),
+                        FTy->isVarArg());
+  }
+  case Type::ArrayTyID:
+  case Type::VectorTyID:
+    return hash_combine(Ty->getTypeID(),
+                        cast<SequentialType>(Ty)->getNumElements());
+  default:
+    return hash_value(Ty->getTypeID());
+  }
+}
+
+// A function hash is calculated by considering only the signature of the
+// function (calling convention, number of arguments, whether it is varargs and
+// the shape of the return and argument types), the order of basic blocks (given
+// by the successors of each basic block in depth first order), and the
+// opcode, operand count, result type shape and flags of each instruction within
+// each of these basic blocks. This mirrors the strategy compare() uses to
+// compare functions by walking the BBs in depth first order and comparing each
+// instruction in sequence. Because this hash does not look at the operands, it
+// is insensitive to things such as the target of calls and the constants used
+// in the function, which makes it useful when possibly merging functions which
+// are the same modulo constants and call targets.
 FunctionComparator::FunctionHash FunctionComparator::functionHash(Function &F) {
+  const DataLayout &DL = F.getParent()->getDataLayout();
   HashAccumulator64 H;
   H.add(F.isVarArg());
   H.add(F.arg_size());
+  H.add(F.getCallingConv());
+  H.add(hashTypeShallow(F.getReturnType(), DL));
+  for (const Argument &Arg : F.args())
+    H.add(hashTypeShallow(Arg.getType(), DL));
 
   SmallVector<const BasicBlock *, 8> BBs;
   SmallPtrSet<const BasicBlock *, 16> VisitedBBs;
@@ -923,6 +964,16 @@ FunctionComparator::FunctionHash FunctionComparator::functionHash(Function &F) {
     H.add(45798);
     for (auto &Inst : *BB) {
       H.add(Inst.getOpcode());
+      // GEPs are compared by their accumulated offset when it is constant, so
+      // their operand lists and result types may differ between equal
+      // functions.
+      if (isa<GetElementPtrInst>(Inst))
+        continue;
+      H.add(Inst.getNumOperands());
+      H.add(hashTypeShallow(Inst.getType(), DL));
+      H.add(Inst.getRawSubclassOptionalData());
+      if (const CmpInst *CI = dyn_cast<CmpInst>(&Inst))
+        H.add(CI->getPredicate());
     }
     const Instruction *Term = BB->getTerminator();
     for (unsigned i = 0, e = Term->getNumSuccessors(); i != e; ++i) {
@@ -167,6 +167,8 @@ static const char *const LLVMLoopVectorizeFollowupEpilogue =
 
 STATISTIC(LoopsVectorized, "Number of loops vectorized");
 STATISTIC(LoopsAnalyzed, "Number of loops analyzed for vectorization");
+STATISTIC(LoopsCostBudgetExhausted,
+          "Number of loops where the cost model budget was exhausted");
 
 /// Loops with a known constant trip count below this number are vectorized only
 /// if no scalar iteration overheads are incurred.
@@ -249,6 +251,15 @@ static cl::opt<bool> EnableCondStoresVectorization(
     "enable-cond-stores-vec", cl::init(true), cl::Hidden,
     cl::desc("Enable if predication of stores during vectorization."));
 
+/// Limits the number of instructions the cost model may evaluate per function.
+/// Every candidate VF costs the whole loop body again, which adds up on
+/// functions with many large loops. Once the budget is exhausted, wider VFs
+/// are no longer considered and the best VF found so far is used.
+static cl::opt<unsigned> CostModelBudget(
+    "vectorizer-cost-budget", cl::init(1000000), cl::Hidden,
+    cl::desc("Maximum number of instructions the loop vectorizer cost model "
+             "may evaluate per function."));
+
 static cl::opt<unsigned> MaxNestedScalarReductionIC(
     "max-nested-scalar-reduction-interleave", cl::init(2), cl::Hidden,
     cl::desc("The maximum interleave count to use when interleaving a scalar "
@@ -909,6 +920,13 @@ public:
   /// Collect values we want to ignore in the cost model.
   void collectValuesToIgnore();
 
+  /// Limit the number of instructions expectedCost may evaluate before
+  /// selectVectorizationFactor stops considering wider VFs.
+  void setInstructionBudget(unsigned Budget) { InstructionBudget = Budget; }
+
+  /// \return The number of instructions expectedCost has evaluated.
+  unsigned getNumInstructionsCosted() const { return NumInstructionsCosted; }
+
   /// \returns The smallest bitwidth each instruction can be represented with.
   /// The vector equivalents of these instructions should be truncated to this
   /// type.
@@ -1315,6 +1333,13 @@ private:
 
   DecisionList WideningDecisions;
 
+  /// Number of instructions expectedCost may evaluate, see
+  /// setInstructionBudget.
+  unsigned InstructionBudget = std::numeric_limits<unsigned>::max();
+
+  /// Number of instructions expectedCost has evaluated so far.
+  unsigned NumInstructionsCosted = 0;
+
 public:
   /// The loop that we evaluate.
   Loop *TheLoop;
@@ -4850,6 +4875,17 @@ LoopVectorizationCostModel::selectVectorizationFactor(unsigned MaxVF) {
   }
 
   for (unsigned i = 2; i <= MaxVF; i *= 2) {
+    if (NumInstructionsCosted >= InstructionBudget) {
+      LLVM_DEBUG(dbgs() << "LV: Cost model budget exhausted, not considering "
+                        << "vector loops of width " << i << " and wider.\n");
+      ORE->emit(createMissedAnalysis("CostModelBudgetExhausted")
+                << "compile-time budget exhausted, vectorization factors of "
+                << ore::NV("VectorizationFactor", i)
+                << " and wider were not considered");
+      ++LoopsCostBudgetExhausted;
+      break;
+    }
+
     // Notice that the vector loop needs to be executed less times, so
     // we need to divide the cost of the vector loops by the width of
     // the vector elements.
@@ -5433,6 +5469,7 @@ LoopVectorizationCostModel::expectedCost(unsigned VF) {
         continue;
 
       VectorizationCostTy C = getInstructionCost(&I, VF);
+      ++NumInstructionsCosted;
 
       // Check if we should override the cost.
       if (ForceTargetInstructionCost.getNumOccurrences() > 0)
@@ -7368,6 +7405,9 @@ bool LoopVectorizePass::processLoop(Loop *L) {
   LoopVectorizationCostModel CM(L, PSE, LI, &LVL, *TTI, TLI, DB, AC, ORE, F,
                                 &Hints, IAI);
   CM.collectValuesToIgnore();
+  CM.setInstructionBudget(CostModelBudget > CostModelBudgetUsed
+                              ? CostModelBudget - CostModelBudgetUsed
+                              : 0);
 
   // Use the planner for vectorization.
   LoopVectorizationPlanner LVP(L, LI, TLI, TTI, &LVL, CM);
@@ -7387,6 +7427,7 @@ bool LoopVectorizePass::processLoop(Loop *L) {
     // Select the interleave count.
     IC = CM.selectInterleaveCount(OptForSize, VF.Width, VF.Cost);
   }
+  CostModelBudgetUsed += CM.getNumInstructionsCosted();
 
   // Identify the diagnostic messages that should be produced.
   std::pair<StringRef, std::string> VecDiagMsg, IntDiagMsg;
@@ -7555,6 +7596,7 @@ bool LoopVectorizePass::runImpl(
   DB = &DB_;
   ORE = &ORE_;
   PSI = PSI_;
+  CostModelBudgetUsed = 0;
 
   // Don't attempt if
   // 1. the target claims to have no vector registers, and
@@ -104,6 +104,11 @@ using namespace slpvectorizer;
 #define DEBUG_TYPE "SLP"
 
 STATISTIC(NumVectorInstructions, "Number of vector instructions generated");
+STATISTIC(NumTreesBuilt, "Number of SLP trees built");
+STATISTIC(NumTreeInstructionsVisited,
+          "Number of scalar instructions visited while building SLP trees");
+STATISTIC(NumTreeBudgetExhausted,
+          "Number of functions where the SLP tree budget was exhausted");
 
 static cl::opt<int>
     SLPCostThreshold("slp-threshold", cl::init(0), cl::Hidden,
@@ -131,6 +136,15 @@ static cl::opt<int>
 ScheduleRegionSizeBudget("slp-schedule-budget", cl::init(100000), cl::Hidden,
     cl::desc("Limit the size of the SLP scheduling region per block"));
 
+/// Limits the total number of scalars buildTree may visit in a function, to
+/// bound compile time on functions with huge numbers of seeds. Once the budget
+/// is exhausted, trees are no longer extended and the function is skipped.
+/// Like the scheduling budget, this is far above what real code needs.
+static cl::opt<unsigned> TreeBudget(
+    "slp-tree-budget", cl::init(1000000), cl::Hidden,
+    cl::desc("Limit the number of scalars visited while building SLP trees "
+             "per function"));
+
 static cl::opt<int> MinVectorRegSizeOption(
     "slp-min-reg-size", cl::init(128), cl::Hidden,
     cl::desc("Attempt to vectorize for this register size in bits"));
@@ -610,6 +624,10 @@ public:
 
   OptimizationRemarkEmitter *getORE() { return ORE; }
 
+  /// \returns True if building trees has visited more scalars than allowed by
+  /// -slp-tree-budget in this function.
+  bool isTreeBudgetExhausted() const { return TreeBudgetUsed >= TreeBudget; }
+
   /// This structure holds any data we need about the edges being traversed
   /// during buildTree_rec(). We keep track of:
   /// (i) the user TreeEntry index, and
@@ -1799,6 +1817,9 @@ private:
   unsigned MaxVecRegSize; // This is set by TTI or overridden by cl::opt.
   unsigned MinVecRegSize; // Set by cl::opt (default: 128).
 
+  /// Number of scalars visited by buildTree_rec in this function.
+  unsigned TreeBudgetUsed = 0;
+
   /// Instruction builder to construct the vectorized tree.
   IRBuilder<> Builder;
 
@@ -1903,6 +1924,7 @@ void BoUpSLP::buildTree(ArrayRef<Value *> Roots,
   UserIgnoreList = UserIgnoreLst;
   if (!allSameType(Roots))
     return;
+  ++NumTreesBuilt;
   buildTree_rec(Roots, 0, EdgeInfo());
 
   // Collect the values that we need to extract from the tree.
@@ -1975,6 +1997,14 @@ void BoUpSLP::buildTree_rec(ArrayRef<Value *> VL, unsigned Depth,
     return;
   }
 
+  if (isTreeBudgetExhausted()) {
+    LLVM_DEBUG(dbgs() << "SLP: Gathering due to exhausted tree budget.\n");
+    newTreeEntry(VL, false, UserTreeIdx);
+    return;
+  }
+  TreeBudgetUsed += VL.size();
+  NumTreeInstructionsVisited += VL.size();
+
   // Don't handle vectors.
   if (S.OpValue->getType()->isVectorTy()) {
     LLVM_DEBUG(dbgs() << "SLP: Gathering due to vector type.\n");
@@ -4995,6 +5025,11 @@ bool SLPVectorizerPass::runImpl(Function &F, ScalarEvolution *SE_,
 
   // Scan the blocks in the function in post order.
   for (auto BB : post_order(&F.getEntryBlock())) {
+    // Stop looking for new seeds once tree building has used up its budget;
+    // every further tree would only consist of gathers.
+    if (R.isTreeBudgetExhausted())
+      break;
+
     collectSeedInstructions(BB);
 
     // Vectorize trees that end at stores.
@@ -5017,6 +5052,19 @@ bool SLPVectorizerPass::runImpl(Function &F, ScalarEvolution *SE_,
     }
   }
 
+  if (R.isTreeBudgetExhausted()) {
+    LLVM_DEBUG(dbgs() << "SLP: Tree budget exhausted in " << F.getName()
+                      << ".\n");
+    ++NumTreeBudgetExhausted;
+    ORE_->emit([&]() {
+      return OptimizationRemarkMissed(SV_NAME, "TreeBudgetExhausted",
+                                      F.getSubprogram(), &F.getEntryBlock())
+             << "SLP vectorization stopped early: the tree budget of "
+             << ore::NV("TreeBudget", TreeBudget.getValue())
+             << " scalars is exhausted";
+    });
+  }
+
   if (Changed) {
     R.optimizeGatherSequence();
     LLVM_DEBUG(dbgs() << "SLP: vectorized \"" << F.getName() << "\"\n");
@@ -0,0 +1,79 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -enable-ext-tsp-block-placement \
+; RUN:   -ext-tsp-block-placement-report -o /dev/null 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -enable-ext-tsp-block-placement \
+; RUN:   | FileCheck %s --check-prefix=LAYOUT
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu \
+; RUN:   | FileCheck %s --check-prefix=DEFAULT
+
+; Only functions with profile data are laid out with Ext-TSP, and the chosen
+; layout never scores lower than the chain-based one.
+; CHECK: ext-tsp: hot_loop: score {{[0-9]+\.[0-9]+}} -> {{[0-9]+\.[0-9]+}}, taken branches {{[0-9]+\.[0-9]+}} -> {{[0-9]+\.[0-9]+}}
+; CHECK-NOT: ext-tsp: no_profile
+
+; The entry block stays first. The chain-based layout places the cold block
+; between the entry and the loop, Ext-TSP moves it out of the way of the hot
+; path, after the return.
+; LAYOUT-LABEL: hot_loop:
+; LAYOUT-NEXT: .cfi_startproc
+; LAYOUT: # %bb.0: # %entry
+; LAYOUT: # %loop
+; LAYOUT: # %fast
+; LAYOUT: # %latch
+; LAYOUT: # %exit
+; LAYOUT: retq
+; LAYOUT: # %slow
+; LAYOUT-LABEL: no_profile:
+
+; DEFAULT-LABEL: hot_loop:
+; DEFAULT: # %bb.0: # %entry
+; DEFAULT: # %slow
+; DEFAULT: # %loop
+; DEFAULT: # %fast
+; DEFAULT: # %latch
+; DEFAULT: # %exit
+; DEFAULT-LABEL: no_profile:
+
+declare void @cold()
+declare void @hot(i32)
+
+define void @hot_loop(i32 %n, i1 %c) !prof !0 {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %rare = icmp eq i32 %i, 1000
+  br i1 %rare, label %slow, label %fast, !prof !1
+
+slow:
+  call void @cold()
+  br label %latch
+
+fast:
+  call void @hot(i32 %i)
+  br label %latch
+
+latch:
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !2
+
+exit:
+  ret void
+}
+
+define void @no_profile(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  call void @cold()
+  br label %b
+
+b:
+  ret void
+}
+
+!0 = !{!"function_entry_count", i64 100}
+!1 = !{!"branch_weights", i32 1, i32 1000}
+!2 = !{!"branch_weights", i32 1, i32 1000}
@@ -0,0 +1,23 @@
+; RUN: llc -mtriple=x86_64-unknown-unknown -combiner-profile < %s -o /dev/null 2>&1 | FileCheck %s
+
+; Both functions are folded by the generic combines: the adds and the shifts
+; of constants are reassociated into a single node. Check that the profile
+; records at least one hit for each of them.
+
+; CHECK: DAG combiner profile
+; CHECK: ---Wall Time---    Attempts        Hits  Combine
+; CHECK-DAG: {{^ +[0-9.]+ \( *[0-9.]+%\) +[1-9][0-9]* +[1-9][0-9]* +}}visit add{{$}}
+; CHECK-DAG: {{^ +[0-9.]+ \( *[0-9.]+%\) +[1-9][0-9]* +[1-9][0-9]* +}}visit shl{{$}}
+; CHECK: Possible combine cycles:
+
+define i32 @add_add(i32 %a) {
+  %x = add i32 %a, 1
+  %y = add i32 %x, 2
+  ret i32 %y
+}
+
+define i32 @shl_shl(i32 %a) {
+  %x = shl i32 %a, 1
+  %y = shl i32 %x, 2
+  ret i32 %y
+}
@@ -0,0 +1,60 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -split-machine-functions \
+; RUN:   | FileCheck %s --check-prefixes=CHECK,SHARED
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -split-machine-functions \
+; RUN:   -function-sections | FileCheck %s --check-prefixes=CHECK,UNIQUE
+
+; The never executed block is emitted in the cold section, in a frame
+; description of its own.
+; CHECK-LABEL: foo:
+; CHECK: .cfi_startproc
+; CHECK: callq hot
+; CHECK: .Lfunc_end0:
+; CHECK-NEXT: .cfi_endproc
+; SHARED: .section .text.split.,"ax",@progbits
+; UNIQUE: .section .text.split.foo,"ax",@progbits
+; CHECK: .type foo.cold,@function
+; CHECK-NEXT: foo.cold:
+; CHECK-NEXT: .cfi_startproc
+; CHECK: .cfi_def_cfa_offset 16
+; CHECK: callq cold
+; CHECK: .Lfunc_cold_end0:
+; CHECK-NEXT: .size foo, .Lfunc_end0-foo
+; CHECK-NEXT: .size foo.cold, .Lfunc_cold_end0-foo.cold
+; CHECK-NEXT: .cfi_endproc
+
+; Functions without profile data are not split.
+; CHECK-LABEL: no_profile:
+; CHECK-NOT: .text.split
+; CHECK: .size no_profile
+
+declare void @hot()
+declare void @cold()
+
+define void @foo(i1 %c) !prof !0 {
+entry:
+  br i1 %c, label %if.cold, label %if.hot, !prof !1
+
+if.hot:
+  call void @hot()
+  ret void
+
+if.cold:
+  call void @cold()
+  ret void
+}
+
+define void @no_profile(i1 %c) {
+entry:
+  br i1 %c, label %if.cold, label %if.hot
+
+if.hot:
+  call void @hot()
+  ret void
+
+if.cold:
+  call void @cold()
+  ret void
+}
+
+!0 = !{!"function_entry_count", i64 1000}
+!1 = !{!"branch_weights", i32 1, i32 100000}
@@ -0,0 +1,114 @@
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mattr=-ermsb | FileCheck %s --check-prefixes=CHECK,NOERMSB,LIBCALL
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mattr=+ermsb | FileCheck %s --check-prefixes=CHECK,ERMSB,LIBCALL
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mattr=+ermsb,+fsrm | FileCheck %s --check-prefixes=CHECK,FSRM,LIBCALL
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mcpu=icelake-server | FileCheck %s --check-prefixes=CHECK,FSRM,LIBCALL
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mattr=-ermsb -x86-rep-str-constant-sizes \
+; RUN:   | FileCheck %s --check-prefixes=CHECK,NOERMSB,LIBCALL
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mattr=+ermsb -x86-rep-str-constant-sizes \
+; RUN:   | FileCheck %s --check-prefixes=CHECK,ERMSB,CONST-ERMSB
+; RUN: llc < %s -mtriple=x86_64-linux-gnu -mattr=+ermsb,+fsrm -x86-rep-str-constant-sizes \
+; RUN:   | FileCheck %s --check-prefixes=CHECK,FSRM,CONST-FSRM
+
+; Constant sizes beyond the inline threshold are left to the library, unless
+; -x86-rep-str-constant-sizes is given. Then they use REP MOVSB/STOSB on
+; processors with fast strings, unless the size is short and REP MOVSB is not
+; fast for short sizes, or the size is very large.
+
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8* nocapture, i8* nocapture readonly, i64, i1)
+declare void @llvm.memset.p0i8.i64(i8* nocapture, i8, i64, i1)
+
+define void @copy_1024(i8* %d, i8* %s) nounwind {
+; CHECK-LABEL: copy_1024:
+; LIBCALL:         memcpy
+; CONST-ERMSB:     memcpy
+; CONST-FSRM-NOT:  memcpy
+; CONST-FSRM:      rep;movsb
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %d, i8* %s, i64 1024, i1 false)
+  ret void
+}
+
+define void @copy_4096(i8* %d, i8* %s) nounwind {
+; CHECK-LABEL: copy_4096:
+; LIBCALL:         memcpy
+; CONST-ERMSB-NOT: memcpy
+; CONST-ERMSB:     rep;movsb
+; CONST-FSRM-NOT:  memcpy
+; CONST-FSRM:      rep;movsb
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %d, i8* %s, i64 4096, i1 false)
+  ret void
+}
+
+define void @copy_4m(i8* %d, i8* %s) nounwind {
+; CHECK-LABEL: copy_4m:
+; CHECK-NOT:   rep
+; CHECK:       memcpy
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %d, i8* %s, i64 4194304, i1 false)
+  ret void
+}
+
+define void @set_4096(i8* %d, i8 %v) nounwind {
+; CHECK-LABEL: set_4096:
+; LIBCALL:         memset
+; CONST-ERMSB-NOT: memset
+; CONST-ERMSB:     rep;stosb
+; CONST-FSRM-NOT:  memset
+; CONST-FSRM:      rep;stosb
+  call void @llvm.memset.p0i8.i64(i8* %d, i8 %v, i64 4096, i1 false)
+  ret void
+}
+
+; Sizes that are not constant use the value profile, as left behind on the
+; fallback path by PGOMemOPSizeOpt.
+
+define void @copy_profiled_large(i8* %d, i8* %s, i64 %n) nounwind {
+; CHECK-LABEL: copy_profiled_large:
+; NOERMSB:     memcpy
+; ERMSB-NOT:   memcpy
+; ERMSB:       rep;movsb
+; FSRM-NOT:    memcpy
+; FSRM:        rep;movsb
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %d, i8* %s, i64 %n, i1 false), !prof !0
+  ret void
+}
+
+define void @copy_profiled_small(i8* %d, i8* %s, i64 %n) nounwind {
+; CHECK-LABEL: copy_profiled_small:
+; NOERMSB:     memcpy
+; ERMSB:       memcpy
+; FSRM-NOT:    memcpy
+; FSRM:        rep;movsb
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %d, i8* %s, i64 %n, i1 false), !prof !1
+  ret void
+}
+
+; Too many of the profiled copies are larger than the REP MOVSB limit.
+define void @copy_profiled_huge(i8* %d, i8* %s, i64 %n) nounwind {
+; CHECK-LABEL: copy_profiled_huge:
+; CHECK-NOT:   rep
+; CHECK:       memcpy
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %d, i8* %s, i64 %n, i1 false), !prof !2
+  ret void
+}
+
+define void @copy_unprofiled(i8* %d, i8* %s, i64 %n) nounwind {
+; CHECK-LABEL: copy_unprofiled:
+; CHECK-NOT:   rep
+; CHECK:       memcpy
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %d, i8* %s, i64 %n, i1 false)
+  ret void
+}
+
+define void @set_profiled_large(i8* %d, i64 %n) nounwind {
+; CHECK-LABEL: set_profiled_large:
+; NOERMSB:     memset
+; ERMSB-NOT:   memset
+; ERMSB:       rep;stosb
+; FSRM-NOT:    memset
+; FSRM:        rep;stosb
+  call void @llvm.memset.p0i8.i64(i8* %d, i8 0, i64 %n, i1 false), !prof !0
+  ret void
+}
+
+!0 = !{!"VP", i32 1, i64 1000, i64 4096, i64 600, i64 8192, i64 395}
+!1 = !{!"VP", i32 1, i64 1000, i64 8, i64 700, i64 64, i64 300}
+!2 = !{!"VP", i32 1, i64 1000, i64 4096, i64 700, i64 16777216, i64 300}
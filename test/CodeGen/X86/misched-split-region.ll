@@ -0,0 +1,83 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched -verify-machineinstrs -verify-misched \
+; RUN:   -misched-max-region-instrs=8 -debug-only=machine-scheduler -stats -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched \
+; RUN:   -misched-max-region-instrs=0 -debug-only=machine-scheduler -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=NOSPLIT
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched \
+; RUN:   -debug-only=machine-scheduler -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=NOSPLIT
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -enable-misched \
+; RUN:   -misched-topdown -misched-max-region-instrs=8 -verify-machineinstrs \
+; RUN:   -verify-misched -o - | FileCheck %s --check-prefix=ASM
+; REQUIRES: asserts
+
+; A long straight-line region is scheduled in parts of at most 8 instructions,
+; each with its own DAG and pressure tracking. The part boundaries are not
+; scheduling boundaries, so scheduling the part below must not invalidate the
+; end of the part above it.
+
+; CHECK: Splitting scheduling region of {{[0-9]+}} instructions into {{[3-9]}} parts
+; CHECK-NOT: RegionInstrs: {{(9|[1-9][0-9]+)$}}
+; CHECK: RegionInstrs: {{[1-8]$}}
+; CHECK-NOT: RegionInstrs: {{(9|[1-9][0-9]+)$}}
+; CHECK-DAG: machine-scheduler - Number of scheduling regions split
+; CHECK-DAG: machine-scheduler - Number of parts split regions were split into
+
+; NOSPLIT-NOT: Splitting scheduling region
+; NOSPLIT: RegionInstrs: {{[1-9][0-9]+$}}
+
+; ASM-LABEL: sum_products:
+; ASM: retq
+
+define i32 @sum_products(i32* %a, i32* %b) nounwind {
+entry:
+  %pa0 = getelementptr inbounds i32, i32* %a, i64 0
+  %pb0 = getelementptr inbounds i32, i32* %b, i64 0
+  %va0 = load i32, i32* %pa0
+  %vb0 = load i32, i32* %pb0
+  %m0 = mul i32 %va0, %vb0
+  %pa1 = getelementptr inbounds i32, i32* %a, i64 1
+  %pb1 = getelementptr inbounds i32, i32* %b, i64 1
+  %va1 = load i32, i32* %pa1
+  %vb1 = load i32, i32* %pb1
+  %m1 = mul i32 %va1, %vb1
+  %s1 = add i32 %m0, %m1
+  %pa2 = getelementptr inbounds i32, i32* %a, i64 2
+  %pb2 = getelementptr inbounds i32, i32* %b, i64 2
+  %va2 = load i32, i32* %pa2
+  %vb2 = load i32, i32* %pb2
+  %m2 = mul i32 %va2, %vb2
+  %s2 = add i32 %s1, %m2
+  %pa3 = getelementptr inbounds i32, i32* %a, i64 3
+  %pb3 = getelementptr inbounds i32, i32* %b, i64 3
+  %va3 = load i32, i32* %pa3
+  %vb3 = load i32, i32* %pb3
+  %m3 = mul i32 %va3, %vb3
+  %s3 = add i32 %s2, %m3
+  %pa4 = getelementptr inbounds i32, i32* %a, i64 4
+  %pb4 = getelementptr inbounds i32, i32* %b, i64 4
+  %va4 = load i32, i32* %pa4
+  %vb4 = load i32, i32* %pb4
+  %m4 = mul i32 %va4, %vb4
+  %s4 = add i32 %s3, %m4
+  %pa5 = getelementptr inbounds i32, i32* %a, i64 5
+  %pb5 = getelementptr inbounds i32, i32* %b, i64 5
+  %va5 = load i32, i32* %pa5
+  %vb5 = load i32, i32* %pb5
+  %m5 = mul i32 %va5, %vb5
+  %s5 = add i32 %s4, %m5
+  %pa6 = getelementptr inbounds i32, i32* %a, i64 6
+  %pb6 = getelementptr inbounds i32, i32* %b, i64 6
+  %va6 = load i32, i32* %pa6
+  %vb6 = load i32, i32* %pb6
+  %m6 = mul i32 %va6, %vb6
+  %s6 = add i32 %s5, %m6
+  %pa7 = getelementptr inbounds i32, i32* %a, i64 7
+  %pb7 = getelementptr inbounds i32, i32* %b, i64 7
+  %va7 = load i32, i32* %pa7
+  %vb7 = load i32, i32* %pb7
+  %m7 = mul i32 %va7, %vb7
+  %s7 = add i32 %s6, %m7
+  ret i32 %s7
+}
@@ -0,0 +1,51 @@
+; RUN: llc -mtriple=i386-unknown-unknown -regalloc=greedy -regalloc-eviction-log=%t.log < %s -o /dev/null
+; RUN: FileCheck %s --check-prefix=LOG < %t.log
+; RUN: llc -mtriple=i386-unknown-unknown -regalloc=greedy -regalloc-advisor=default < %s -o /dev/null
+; RUN: not llc -mtriple=i386-unknown-unknown -regalloc=greedy -regalloc-advisor=bogus < %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=ERR
+
+; Six values are live across a division, which needs EAX and EDX, so the
+; allocator has to consider evicting live ranges. Each decision is logged
+; with the function, both live ranges and the verdict in the last column.
+
+; LOG: function{{[[:space:]]}}virtreg{{[[:space:]]}}weight{{[[:space:]]}}size{{[[:space:]]}}evictee
+; LOG: {{^}}divide{{[[:space:]]%[0-9]+([[:space:]][^[:space:]]+){2}[[:space:]]%[0-9]+([[:space:]][^[:space:]]+){5}[[:space:]]}}1{{$}}
+; ERR: unknown register allocation advisor 'bogus'
+
+define i32 @divide(i32* %p, i32 %n) {
+entry:
+  %a.addr = getelementptr inbounds i32, i32* %p, i32 1
+  %b.addr = getelementptr inbounds i32, i32* %p, i32 2
+  %c.addr = getelementptr inbounds i32, i32* %p, i32 3
+  %d.addr = getelementptr inbounds i32, i32* %p, i32 4
+  %e.addr = getelementptr inbounds i32, i32* %p, i32 5
+  %f.addr = getelementptr inbounds i32, i32* %p, i32 6
+  %a = load volatile i32, i32* %a.addr
+  %b = load volatile i32, i32* %b.addr
+  %c = load volatile i32, i32* %c.addr
+  %d = load volatile i32, i32* %d.addr
+  %e = load volatile i32, i32* %e.addr
+  %f = load volatile i32, i32* %f.addr
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ %n, %entry ], [ %acc.next, %loop ]
+  %q1 = sdiv i32 %acc, %a
+  %q2 = sdiv i32 %q1, %b
+  %q3 = sdiv i32 %q2, %c
+  %s1 = add i32 %q3, %d
+  %s2 = add i32 %s1, %e
+  %acc.next = xor i32 %s2, %f
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %r1 = add i32 %acc.next, %a
+  %r2 = add i32 %r1, %b
+  %r3 = add i32 %r2, %c
+  %r4 = add i32 %r3, %d
+  %r5 = add i32 %r4, %e
+  %r6 = add i32 %r5, %f
+  ret i32 %r6
+}
@@ -0,0 +1,190 @@
+# RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.o -stats 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=STATS
+# RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.full.o \
+# RUN:   -mc-incremental-relaxation=false
+# RUN: cmp %t.o %t.full.o
+# RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o /dev/null \
+# RUN:   -mc-time-relaxation 2>&1 | FileCheck %s --check-prefix=TIME
+# REQUIRES: asserts
+
+# Relaxation only checks fragments again when a fragment they depend on has
+# moved, which must not change the result.
+
+# Each jne below skips over the ones after it, so relaxing one jne can push the
+# ones before it out of range. This takes several layout passes, while the
+# branches in the prologue and in .text.other never need to be checked again.
+
+# STATS: assembler - Number of fragments checked for relaxation
+# STATS: {{[1-9][0-9]*}} assembler - Number of fragment relaxation checks skipped as up to date
+# STATS: assembler - Number of assembler layout and relaxation steps
+
+# TIME: Assembler
+# TIME: Layout and relaxation
+
+	.file	1 "relax.c"
+	.text
+	.globl	f
+	.type	f,@function
+f:
+	.loc	1 1 0
+.Lprologue:
+	jmp	.Lp0
+	nop
+.Lp0:
+	jmp	.Lp1
+	nop
+.Lp1:
+	jmp	.Lp2
+	nop
+.Lp2:
+	jmp	.Lp3
+	nop
+.Lp3:
+	jmp	.Lp4
+	nop
+.Lp4:
+	jmp	.Lp5
+	nop
+.Lp5:
+	jmp	.Lp6
+	nop
+.Lp6:
+	jmp	.Lp7
+	nop
+.Lp7:
+	.p2align	4
+	.loc	1 2 0
+	jne	.Lt0
+	.fill	3, 1, 0x90
+	.loc	1 3 0
+	jne	.Lt1
+	.fill	3, 1, 0x90
+	.loc	1 4 0
+	jne	.Lt2
+	.fill	3, 1, 0x90
+	.loc	1 5 0
+	jne	.Lt3
+	.fill	3, 1, 0x90
+	.loc	1 6 0
+	jne	.Lt4
+	.fill	3, 1, 0x90
+	.loc	1 7 0
+	jne	.Lt5
+	.fill	3, 1, 0x90
+	.loc	1 8 0
+	jne	.Lt6
+	.fill	3, 1, 0x90
+	.loc	1 9 0
+	jne	.Lt7
+	.fill	3, 1, 0x90
+	.loc	1 10 0
+	jne	.Lt8
+	.fill	3, 1, 0x90
+	.loc	1 11 0
+	jne	.Lt9
+	.fill	3, 1, 0x90
+	.loc	1 12 0
+	jne	.Lt10
+	.fill	3, 1, 0x90
+	.loc	1 13 0
+	jne	.Lt11
+	.fill	3, 1, 0x90
+	.loc	1 14 0
+	jne	.Lt12
+	.fill	3, 1, 0x90
+	.loc	1 15 0
+	jne	.Lt13
+	.fill	3, 1, 0x90
+	.loc	1 16 0
+	jne	.Lt14
+	.fill	3, 1, 0x90
+	.loc	1 17 0
+	jne	.Lt15
+	.fill	3, 1, 0x90
+	.loc	1 18 0
+	jne	.Lt16
+	.fill	3, 1, 0x90
+	.loc	1 19 0
+	jne	.Lt17
+	.fill	3, 1, 0x90
+	.loc	1 20 0
+	jne	.Lt18
+	.fill	3, 1, 0x90
+	.loc	1 21 0
+	jne	.Lt19
+	.fill	3, 1, 0x90
+	.loc	1 22 0
+	jne	.Lt20
+	.fill	3, 1, 0x90
+	.loc	1 23 0
+	jne	.Lt21
+	.fill	3, 1, 0x90
+	.loc	1 24 0
+	jne	.Lt22
+	.fill	3, 1, 0x90
+	.loc	1 25 0
+	jne	.Lt23
+	.fill	3, 1, 0x90
+.Lt23:
+	jmp	.Lprologue
+.Lt22:
+	jmp	.Lprologue
+.Lt21:
+	jmp	.Lprologue
+.Lt20:
+	jmp	.Lprologue
+.Lt19:
+	jmp	.Lprologue
+.Lt18:
+	jmp	.Lprologue
+.Lt17:
+	jmp	.Lprologue
+.Lt16:
+	jmp	.Lprologue
+.Lt15:
+	jmp	.Lprologue
+.Lt14:
+	jmp	.Lprologue
+.Lt13:
+	jmp	.Lprologue
+.Lt12:
+	jmp	.Lprologue
+.Lt11:
+	jmp	.Lprologue
+.Lt10:
+	jmp	.Lprologue
+.Lt9:
+	jmp	.Lprologue
+.Lt8:
+	jmp	.Lprologue
+.Lt7:
+	jmp	.Lprologue
+.Lt6:
+	jmp	.Lprologue
+.Lt5:
+	jmp	.Lprologue
+.Lt4:
+	jmp	.Lprologue
+.Lt3:
+	jmp	.Lprologue
+.Lt2:
+	jmp	.Lprologue
+.Lt1:
+	jmp	.Lprologue
+.Lt0:
+	jmp	.Lprologue
+	.loc	1 100 0
+	retq
+.Lend:
+	.size	f, .Lend-f
+
+	.section	.text.other,"ax",@progbits
+g:
+	jmp	.Lg
+	nop
+.Lg:
+	retq
+
+	.section	.rodata,"a",@progbits
+	.uleb128	.Lend-.Lprologue
+	.uleb128	.Lt0-.Lt1
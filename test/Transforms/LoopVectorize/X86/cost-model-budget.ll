@@ -0,0 +1,32 @@
+; RUN: opt < %s -loop-vectorize -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7-avx -S | FileCheck %s --check-prefix=DEFAULT
+; RUN: opt < %s -loop-vectorize -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7-avx -vectorizer-cost-budget=0 -pass-remarks-analysis=loop-vectorize -S 2>&1 | FileCheck %s --check-prefix=BUDGET
+
+; Once the cost model budget is exhausted no vectorization factor other than
+; the scalar one is costed, so the loop is not vectorized.
+
+; DEFAULT-LABEL: @add(
+; DEFAULT: add nsw <{{[0-9]+}} x i32>
+
+; BUDGET: remark: <unknown>:0:0: loop not vectorized: compile-time budget exhausted, vectorization factors of 2 and wider were not considered
+; BUDGET-LABEL: @add(
+; BUDGET-NOT: x i32>
+; BUDGET: ret void
+
+define void @add(i32* noalias %dst, i32* noalias %src, i64 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %p = getelementptr inbounds i32, i32* %src, i64 %i
+  %v = load i32, i32* %p, align 4
+  %r = add nsw i32 %v, 42
+  %q = getelementptr inbounds i32, i32* %dst, i64 %i
+  store i32 %r, i32* %q, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
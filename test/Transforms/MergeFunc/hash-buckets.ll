@@ -0,0 +1,81 @@
+; RUN: opt -S -mergefunc < %s | FileCheck %s
+; RUN: opt -S -mergefunc -mergefunc-parallel-hash < %s | FileCheck %s
+; RUN: opt -disable-output -mergefunc -stats < %s 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=STATS
+; REQUIRES: asserts
+
+; All functions below have the same sequence of opcodes. Only the two equal
+; ones share a structural hash, so they are the only ones compared in full.
+
+; STATS: 1 mergefunc - Number of functions merged
+; STATS: 1 mergefunc - Number of groups of functions sharing a structural hash
+
+; CHECK-LABEL: define i32 @add_a(i32 %x, i32 %y)
+; CHECK-NEXT: %sum = add i32 %x, %y
+define i32 @add_a(i32 %x, i32 %y) {
+  %sum = add i32 %x, %y
+  %sum2 = add i32 %sum, %y
+  %sum3 = add i32 %sum2, %x
+  ret i32 %sum3
+}
+
+define i32 @add_b(i32 %x, i32 %y) {
+  %sum = add i32 %x, %y
+  %sum2 = add i32 %sum, %y
+  %sum3 = add i32 %sum2, %x
+  ret i32 %sum3
+}
+
+; Different types.
+; CHECK-LABEL: define i64 @add_i64(i64 %x, i64 %y)
+; CHECK-NEXT: %sum = add i64 %x, %y
+define i64 @add_i64(i64 %x, i64 %y) {
+  %sum = add i64 %x, %y
+  %sum2 = add i64 %sum, %y
+  %sum3 = add i64 %sum2, %x
+  ret i64 %sum3
+}
+
+; Different flags.
+; CHECK-LABEL: define i32 @add_nsw(i32 %x, i32 %y)
+; CHECK-NEXT: %sum = add nsw i32 %x, %y
+define i32 @add_nsw(i32 %x, i32 %y) {
+  %sum = add nsw i32 %x, %y
+  %sum2 = add i32 %sum, %y
+  %sum3 = add i32 %sum2, %x
+  ret i32 %sum3
+}
+
+; Different calling conventions.
+; CHECK-LABEL: define fastcc i32 @add_fastcc(i32 %x, i32 %y)
+; CHECK-NEXT: %sum = add i32 %x, %y
+define fastcc i32 @add_fastcc(i32 %x, i32 %y) {
+  %sum = add i32 %x, %y
+  %sum2 = add i32 %sum, %y
+  %sum3 = add i32 %sum2, %x
+  ret i32 %sum3
+}
+
+; Different compare predicates.
+; CHECK-LABEL: define i1 @cmp_eq(i32 %x, i32 %y)
+; CHECK-NEXT: %sum = add i32 %x, %y
+define i1 @cmp_eq(i32 %x, i32 %y) {
+  %sum = add i32 %x, %y
+  %sum2 = add i32 %sum, %y
+  %c = icmp eq i32 %sum2, %x
+  ret i1 %c
+}
+
+; CHECK-LABEL: define i1 @cmp_ne(i32 %x, i32 %y)
+; CHECK-NEXT: %sum = add i32 %x, %y
+define i1 @cmp_ne(i32 %x, i32 %y) {
+  %sum = add i32 %x, %y
+  %sum2 = add i32 %sum, %y
+  %c = icmp ne i32 %sum2, %x
+  ret i1 %c
+}
+
+; The thunk replacing @add_b is emitted after the other functions.
+; CHECK-LABEL: define i32 @add_b(
+; CHECK-NEXT: tail call i32 @add_a(
+; CHECK-NEXT: ret i32
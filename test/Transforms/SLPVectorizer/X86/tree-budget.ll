@@ -0,0 +1,44 @@
+; RUN: opt -S -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7-avx -slp-vectorizer < %s | FileCheck %s --check-prefix=DEFAULT
+; RUN: opt -S -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7-avx -slp-vectorizer -slp-tree-budget=2 -pass-remarks-missed=slp-vectorizer < %s 2>&1 | FileCheck %s --check-prefix=BUDGET
+
+; With a tiny tree budget the store tree below is cut off after its root and
+; nothing is vectorized.
+
+; DEFAULT-LABEL: @add4(
+; DEFAULT: add <4 x i32>
+; DEFAULT: store <4 x i32>
+
+; BUDGET: remark: <unknown>:0:0: SLP vectorization stopped early: the tree budget of 2 scalars is exhausted
+; BUDGET-LABEL: @add4(
+; BUDGET-NOT: <4 x i32>
+; BUDGET: ret void
+
+define void @add4(i32* noalias %dst, i32* noalias %a, i32* noalias %b) {
+entry:
+  %a1 = getelementptr inbounds i32, i32* %a, i64 1
+  %a2 = getelementptr inbounds i32, i32* %a, i64 2
+  %a3 = getelementptr inbounds i32, i32* %a, i64 3
+  %b1 = getelementptr inbounds i32, i32* %b, i64 1
+  %b2 = getelementptr inbounds i32, i32* %b, i64 2
+  %b3 = getelementptr inbounds i32, i32* %b, i64 3
+  %d1 = getelementptr inbounds i32, i32* %dst, i64 1
+  %d2 = getelementptr inbounds i32, i32* %dst, i64 2
+  %d3 = getelementptr inbounds i32, i32* %dst, i64 3
+  %la0 = load i32, i32* %a, align 4
+  %la1 = load i32, i32* %a1, align 4
+  %la2 = load i32, i32* %a2, align 4
+  %la3 = load i32, i32* %a3, align 4
+  %lb0 = load i32, i32* %b, align 4
+  %lb1 = load i32, i32* %b1, align 4
+  %lb2 = load i32, i32* %b2, align 4
+  %lb3 = load i32, i32* %b3, align 4
+  %s0 = add i32 %la0, %lb0
+  %s1 = add i32 %la1, %lb1
+  %s2 = add i32 %la2, %lb2
+  %s3 = add i32 %la3, %lb3
+  store i32 %s0, i32* %dst, align 4
+  store i32 %s1, i32* %d1, align 4
+  store i32 %s2, i32* %d2, align 4
+  store i32 %s3, i32* %d3, align 4
+  ret void
+}
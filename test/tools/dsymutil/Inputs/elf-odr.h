@@ -0,0 +1,4 @@
+struct Point {
+  int X, Y;
+  int sum() const { return X + Y; }
+};
@@ -0,0 +1,27 @@
+/* The elf-odr.elf-x86_64 binary is linked from elf-odr1.cpp and elf-odr2.cpp
+   with GNU tools, with dead code and data stripping:
+
+      for FILE in elf-odr1.cpp elf-odr2.cpp; do
+         g++ -gdwarf-4 -O0 -ffunction-sections -fdata-sections \
+             -fno-asynchronous-unwind-tables -fno-pie -c $FILE
+      done
+      ld -static -e _start --gc-sections elf-odr1.o elf-odr2.o \
+         -o elf-odr.elf-x86_64
+
+   Both units describe Point, and the debug info of unused1, unused2 and
+   UnusedGlobal is still in the binary.  */
+
+#include "elf-odr.h"
+
+int Global = 1;
+int UnusedGlobal = 2;
+
+int getX(Point P) { return P.X; }
+int unused1(Point P) { return P.sum(); }
+int getY(Point P);
+
+extern "C" void _start() {
+  Point P = {Global, 2};
+  getX(P);
+  getY(P);
+}
@@ -0,0 +1,6 @@
+/* See elf-odr1.cpp for how this is built.  */
+
+#include "elf-odr.h"
+
+int getY(Point P) { return P.Y; }
+int unused2(Point P) { return P.sum() + 1; }
@@ -0,0 +1,17 @@
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@global = global i32 0
+@internal = internal global i32 0
+@llvm.used = appending global [1 x i8*] [i8* bitcast (i32* @internal to i8*)], section "llvm.metadata"
+
+define void @func() {
+  call void @undefined()
+  ret void
+}
+
+define linkonce_odr void @linkonce() {
+  ret void
+}
+
+declare void @undefined()
@@ -0,0 +1,4 @@
+int f(int x) {
+  return x + 1; } int g(int x) { return x * 3;
+}
+int h(void) { return 5; }
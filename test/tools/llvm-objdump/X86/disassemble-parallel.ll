@@ -0,0 +1,64 @@
+; Check that disassembling functions on several threads prints exactly what
+; disassembling them on one thread does, including the source lines of
+; functions that start on the line the previous one ended on.
+
+; REQUIRES: shell
+; RUN: sed -e "s,SRC_COMPDIR,%p/Inputs,g" %s > %t.ll
+; RUN: llc -o %t.o -filetype=obj -mtriple=x86_64-pc-linux %t.ll
+; RUN: llvm-objdump -d -l %t.o > %t.lines
+; RUN: llvm-objdump -d -l --num-threads=4 %t.o > %t.lines.par
+; RUN: cmp %t.lines %t.lines.par
+; RUN: FileCheck --check-prefix=LINES %s < %t.lines.par
+; RUN: llvm-objdump -d -S %t.o > %t.source
+; RUN: llvm-objdump -d -S --num-threads=0 %t.o > %t.source.par
+; RUN: cmp %t.source %t.source.par
+; RUN: FileCheck --check-prefix=SOURCE --strict-whitespace %s < %t.source.par
+
+; LINES:      f:
+; LINES-NEXT: ; {{.*}}disassemble-parallel.c:2
+; LINES-NEXT: leal
+; LINES:      g:
+; LINES-NEXT: leal
+; LINES-NEXT: ; {{.*}}disassemble-parallel.c:3
+; LINES:      h:
+; LINES-NEXT: ; {{.*}}disassemble-parallel.c:4
+
+; SOURCE:      f:
+; SOURCE-NEXT: ;   return x + 1; } int g(int x) { return x * 3;
+; SOURCE:      g:
+; SOURCE-NEXT: leal
+; SOURCE-NEXT: ; }
+; SOURCE:      h:
+; SOURCE-NEXT: ; int h(void) { return 5; }
+
+define i32 @f(i32 %x) !dbg !7 {
+  %r = add i32 %x, 1, !dbg !10
+  ret i32 %r, !dbg !10
+}
+
+define i32 @g(i32 %x) !dbg !11 {
+  %r = mul i32 %x, 3, !dbg !12
+  ret i32 %r, !dbg !13
+}
+
+define i32 @h() !dbg !14 {
+  ret i32 5, !dbg !15
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: true, runtimeVersion: 0, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "disassemble-parallel.c", directory: "SRC_COMPDIR")
+!2 = !{}
+!3 = !{i32 2, !"Dwarf Version", i32 4}
+!4 = !{i32 2, !"Debug Info Version", i32 3}
+!5 = !DISubroutineType(types: !6)
+!6 = !{null}
+!7 = distinct !DISubprogram(name: "f", scope: !1, file: !1, line: 1, type: !5, scopeLine: 1, spFlags: DISPFlagDefinition | DISPFlagOptimized, unit: !0, retainedNodes: !2)
+!10 = !DILocation(line: 2, column: 12, scope: !7)
+!11 = distinct !DISubprogram(name: "g", scope: !1, file: !1, line: 2, type: !5, scopeLine: 2, spFlags: DISPFlagDefinition | DISPFlagOptimized, unit: !0, retainedNodes: !2)
+!12 = !DILocation(line: 2, column: 41, scope: !11)
+!13 = !DILocation(line: 3, column: 1, scope: !11)
+!14 = distinct !DISubprogram(name: "h", scope: !1, file: !1, line: 4, type: !5, scopeLine: 4, spFlags: DISPFlagDefinition | DISPFlagOptimized, unit: !0, retainedNodes: !2)
+!15 = !DILocation(line: 4, column: 15, scope: !14)
@@ -62,6 +62,22 @@ void CompileUnit::markEverythingAsKept() {
   }
 }
 
+void CompileUnit::markPendingCanonicalDIEs() {
+  if (!hasODR())
+    return;
+
+  unsigned Idx = 0;
+  for (const auto &I : Info) {
+    auto DIE = OrigUnit.getDIEAtIndex(Idx++);
+    // These are the conditions under which cloneDIE makes a DIE canonical.
+    if (I.Keep && !I.Incomplete && I.Ctxt &&
+        DIE.getTag() != dwarf::DW_TAG_namespace &&
+        I.Ctxt != getInfo(I.ParentIdx).Ctxt &&
+        !I.Ctxt->getCanonicalDIEOffset())
+      I.Ctxt->setHasPendingCanonicalDIE();
+  }
+}
+
 uint64_t CompileUnit::computeNextUnitOffset() {
   NextUnitOffset = StartOffset;
   if (NewUnit) {
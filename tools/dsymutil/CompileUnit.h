@@ -152,6 +152,11 @@ public:
   /// reconstructed accelerator tables.
   void markEverythingAsKept();
 
+  /// Record in their DeclContext that the kept DIEs of this unit will become
+  /// canonical when it is cloned, so that the next units of the same object
+  /// refer to them instead of keeping their own copy.
+  void markPendingCanonicalDIEs();
+
   /// Compute the end offset for this unit. Must be called after the CU's DIEs
   /// have been cloned.  \returns the next unit offset (which is also the
   /// current debug_info section size).
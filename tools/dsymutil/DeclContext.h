@@ -75,14 +75,16 @@ class DeclContext {
 public:
   using Map = DenseSet<DeclContext *, DeclMapInfo>;
 
-  DeclContext() : DefinedInClangModule(0), Parent(*this) {}
+  DeclContext()
+      : DefinedInClangModule(0), HasPendingCanonicalDIE(0), Parent(*this) {}
 
   DeclContext(unsigned Hash, uint32_t Line, uint32_t ByteSize, uint16_t Tag,
               StringRef Name, StringRef File, const DeclContext &Parent,
               DWARFDie LastSeenDIE = DWARFDie(), unsigned CUId = 0)
       : QualifiedNameHash(Hash), Line(Line), ByteSize(ByteSize), Tag(Tag),
-        DefinedInClangModule(0), Name(Name), File(File), Parent(Parent),
-        LastSeenDIE(LastSeenDIE), LastSeenCompileUnitID(CUId) {}
+        DefinedInClangModule(0), HasPendingCanonicalDIE(0), Name(Name),
+        File(File), Parent(Parent), LastSeenDIE(LastSeenDIE),
+        LastSeenCompileUnitID(CUId) {}
 
   uint32_t getQualifiedNameHash() const { return QualifiedNameHash; }
 
@@ -91,6 +93,12 @@ public:
   uint32_t getCanonicalDIEOffset() const { return CanonicalDIEOffset; }
   void setCanonicalDIEOffset(uint32_t Offset) { CanonicalDIEOffset = Offset; }
 
+  /// Is a DIE for this context kept by a unit that has not been cloned yet?
+  /// The units of an object are cloned in order, so that DIE will become the
+  /// canonical one before the next units are cloned.
+  bool hasPendingCanonicalDIE() const { return HasPendingCanonicalDIE; }
+  void setHasPendingCanonicalDIE() { HasPendingCanonicalDIE = 1; }
+
   bool isDefinedInClangModule() const { return DefinedInClangModule; }
   void setDefinedInClangModule(bool Val) { DefinedInClangModule = Val; }
 
@@ -105,6 +113,7 @@ private:
   uint32_t ByteSize = 0;
   uint16_t Tag = dwarf::DW_TAG_compile_unit;
   unsigned DefinedInClangModule : 1;
+  unsigned HasPendingCanonicalDIE : 1;
   StringRef Name;
   StringRef File;
   const DeclContext &Parent;
@@ -73,6 +73,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -86,6 +87,7 @@
 #include "llvm/Target/TargetOptions.h"
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cinttypes>
 #include <climits>
 #include <cstdint>
@@ -530,7 +532,16 @@ bool DwarfLinker::RelocationManager::findValidRelocs(
 /// linked binary.
 /// \returns whether there are any valid relocations in the debug info.
 bool DwarfLinker::RelocationManager::findValidRelocsInDebugInfo(
-    const object::ObjectFile &Obj, const DebugMapObject &DMO) {
+    const object::ObjectFile &Obj, const DebugMapObject &DMO,
+    DWARFContext *Dwarf) {
+  // The debug info of a linked ELF binary has no relocations left, look at
+  // the addresses it contains instead.
+  if (Obj.isELF() && !Obj.isRelocatableObject()) {
+    if (Dwarf)
+      findValidAddressesInLinkedDebugInfo(*Dwarf, DMO);
+    return !ValidRelocs.empty();
+  }
+
   // Find the debug_info section.
   for (const object::SectionRef &Section : Obj.sections()) {
     StringRef SectionName;
@@ -607,6 +618,83 @@ getAttributeOffsets(const DWARFAbbreviationDeclaration *Abbrev, unsigned Idx,
   return std::make_pair(Offset, End);
 }
 
+/// Walk the DIEs of the linked binary described by \p Dwarf and record the
+/// addresses of functions, labels and variables that are debug map entries as
+/// if they were relocations. The linker leaves the address of the code and
+/// data it discarded at 0 (or at a tombstone value), which doesn't match any
+/// symbol, so the DIEs describing them are dropped. The DIEs are visited in
+/// ascending offset order, so ValidRelocs doesn't need to be sorted.
+void DwarfLinker::RelocationManager::findValidAddressesInLinkedDebugInfo(
+    DWARFContext &Dwarf, const DebugMapObject &DMO) {
+  for (const auto &CU : Dwarf.compile_units()) {
+    DataExtractor Data = CU->getDebugInfoExtractor();
+    uint8_t AddrSize = CU->getAddressByteSize();
+
+    for (unsigned I = 0, E = CU->getNumDIEs(); I != E; ++I) {
+      DWARFDie DIE = CU->getDIEAtIndex(I);
+      const auto *Abbrev = DIE.getAbbreviationDeclarationPtr();
+      if (!Abbrev)
+        continue;
+
+      dwarf::Attribute Attr;
+      switch (DIE.getTag()) {
+      case dwarf::DW_TAG_subprogram:
+      case dwarf::DW_TAG_label:
+        Attr = dwarf::DW_AT_low_pc;
+        break;
+      case dwarf::DW_TAG_variable:
+        Attr = dwarf::DW_AT_location;
+        break;
+      default:
+        continue;
+      }
+
+      Optional<uint32_t> AttrIdx = Abbrev->findAttributeIndex(Attr);
+      if (!AttrIdx)
+        continue;
+
+      uint32_t Offset = DIE.getOffset() + getULEB128Size(Abbrev->getCode());
+      uint32_t AttrOffset, AttrEndOffset;
+      std::tie(AttrOffset, AttrEndOffset) =
+          getAttributeOffsets(Abbrev, *AttrIdx, Offset, *CU);
+
+      // Low PCs are plain addresses. Locations are expressions, only the
+      // ones starting with a DW_OP_addr refer to a symbol.
+      uint32_t AddrOffset = AttrOffset;
+      switch (Abbrev->getFormByIndex(*AttrIdx)) {
+      case dwarf::DW_FORM_addr:
+        break;
+      case dwarf::DW_FORM_exprloc:
+      case dwarf::DW_FORM_block:
+        Data.getULEB128(&AddrOffset);
+        break;
+      case dwarf::DW_FORM_block1:
+        AddrOffset += 1;
+        break;
+      case dwarf::DW_FORM_block2:
+        AddrOffset += 2;
+        break;
+      case dwarf::DW_FORM_block4:
+        AddrOffset += 4;
+        break;
+      default:
+        continue;
+      }
+      if (Attr == dwarf::DW_AT_location &&
+          (AddrOffset >= AttrEndOffset ||
+           Data.getU8(&AddrOffset) != dwarf::DW_OP_addr))
+        continue;
+      if (AddrOffset + AddrSize > AttrEndOffset)
+        continue;
+
+      uint32_t ValueOffset = AddrOffset;
+      uint64_t Address = Data.getUnsigned(&ValueOffset, AddrSize);
+      if (const auto *Mapping = DMO.lookupObjectAddress(Address))
+        ValidRelocs.emplace_back(AddrOffset, AddrSize, 0, Mapping);
+    }
+  }
+}
+
 /// Check if a variable describing DIE should be kept.
 /// \returns updated TraversalFlags.
 unsigned DwarfLinker::shouldKeepVariableDIE(RelocationManager &RelocMgr,
@@ -811,7 +899,9 @@ void DwarfLinker::keepDIEAndDependencies(
       if (AttrSpec.Form != dwarf::DW_FORM_ref_addr && (UseODR || IsModuleRef) &&
           Info.Ctxt &&
           Info.Ctxt != ReferencedCU->getInfo(Info.ParentIdx).Ctxt &&
-          Info.Ctxt->getCanonicalDIEOffset() && isODRAttribute(AttrSpec.Attr))
+          (Info.Ctxt->getCanonicalDIEOffset() ||
+           (UseODR && Info.Ctxt->hasPendingCanonicalDIE())) &&
+          isODRAttribute(AttrSpec.Attr))
         continue;
 
       // Keep a module forward declaration if there is no definition.
@@ -2528,10 +2618,51 @@ static Error copySwiftInterfaces(
   return Error::success();
 }
 
+/// Print the size of the debug info of each object and of its contribution
+/// to the linked debug info, largest contribution first, and the time it took
+/// to link them.
+static void printStatistics(const DebugMap &Map,
+                            ArrayRef<std::pair<uint64_t, uint64_t>> Sizes,
+                            std::chrono::duration<double> LinkTime) {
+  std::vector<std::pair<StringRef, std::pair<uint64_t, uint64_t>>> Sorted;
+  uint64_t TotalInput = 0, TotalOutput = 0;
+  unsigned I = 0;
+  for (const auto &Obj : Map.objects()) {
+    Sorted.emplace_back(Obj->getObjectFilename(), Sizes[I++]);
+    TotalInput += Sorted.back().second.first;
+    TotalOutput += Sorted.back().second.second;
+  }
+  llvm::stable_sort(Sorted, [](const decltype(Sorted)::value_type &LHS,
+                               const decltype(Sorted)::value_type &RHS) {
+    return LHS.second.second > RHS.second.second;
+  });
+
+  auto PrintRow = [](StringRef Name, uint64_t Input, uint64_t Output) {
+    double Change =
+        Input ? (double(Output) - double(Input)) * 100 / double(Input) : 0;
+    outs() << formatv("{0,-50} {1,12} {2,12} {3,8:f2}%\n", Name, Input, Output,
+                      Change);
+  };
+  std::string Separator(88, '-');
+  outs() << ".debug_info section size (in bytes)\n" << Separator << '\n';
+  outs() << formatv("{0,-50} {1,12} {2,12} {3,9}\n", "Filename", "Input",
+                    "Output", "Change");
+  outs() << Separator << '\n';
+  for (const auto &Entry : Sorted)
+    PrintRow(Entry.first, Entry.second.first, Entry.second.second);
+  outs() << Separator << '\n';
+  PrintRow("Total", TotalInput, TotalOutput);
+  outs() << Separator << '\n';
+  outs() << formatv("Linked {0} object(s) in {1:f3}s\n", Sorted.size(),
+                    LinkTime.count());
+}
+
 bool DwarfLinker::link(const DebugMap &Map) {
   if (!createStreamer(Map.getTriple(), OutFile))
     return false;
 
+  auto StartTime = std::chrono::steady_clock::now();
+
   // Size of the DIEs (and headers) generated for the linked output.
   OutputDebugInfoSize = 0;
   // A unique ID that identifies each compile unit.
@@ -2543,6 +2674,9 @@ bool DwarfLinker::link(const DebugMap &Map) {
   unsigned NumObjects = Map.getNumberOfObjects();
   std::vector<LinkContext> ObjectContexts;
   ObjectContexts.reserve(NumObjects);
+  // The size of the .debug_info of each object and of its contribution to the
+  // linked .debug_info, for --statistics.
+  std::vector<std::pair<uint64_t, uint64_t>> DebugInfoSizes(NumObjects);
   for (const auto &Obj : Map.objects()) {
     ObjectContexts.emplace_back(Map, *this, *Obj.get());
     LinkContext &LC = ObjectContexts.back();
@@ -2568,8 +2702,10 @@ bool DwarfLinker::link(const DebugMap &Map) {
   // would affect the decision. However, as they're built with the same
   // compiler and flags, it is safe to assume that they will follow the
   // decision made here.
+  // ELF consumers don't read the Apple tables.
   if (Options.TheAccelTableKind == AccelTableKind::Default) {
-    if (AtLeastOneDwarfAccelTable && !AtLeastOneAppleAccelTable)
+    if ((AtLeastOneDwarfAccelTable && !AtLeastOneAppleAccelTable) ||
+        Map.getTriple().isOSBinFormatELF())
       Options.TheAccelTableKind = AccelTableKind::Dwarf;
     else
       Options.TheAccelTableKind = AccelTableKind::Apple;
@@ -2626,7 +2762,8 @@ bool DwarfLinker::link(const DebugMap &Map) {
 
     if (LLVM_LIKELY(!Options.Update) &&
         !LinkContext.RelocMgr.findValidRelocsInDebugInfo(
-            *LinkContext.ObjectFile, LinkContext.DMO)) {
+            *LinkContext.ObjectFile, LinkContext.DMO,
+            LinkContext.DwarfContext.get())) {
       if (Options.Verbose)
         outs() << "No valid relocations found. Skipping.\n";
 
@@ -2742,17 +2879,29 @@ bool DwarfLinker::link(const DebugMap &Map) {
         CurrentUnit->markEverythingAsKept();
       Streamer->copyInvariantDebugSection(*LinkContext.ObjectFile);
     } else {
-      for (auto &CurrentUnit : LinkContext.CompileUnits)
+      // The units of a linked ELF binary carry the same types in each of
+      // them. Mach-O objects keep the existing per-unit behavior.
+      bool IsLinkedELF = LinkContext.ObjectFile->isELF() &&
+                         !LinkContext.ObjectFile->isRelocatableObject();
+      for (auto &CurrentUnit : LinkContext.CompileUnits) {
         lookForDIEsToKeep(LinkContext.RelocMgr, LinkContext.Ranges,
                           LinkContext.CompileUnits,
                           CurrentUnit->getOrigUnit().getUnitDIE(),
                           LinkContext.DMO, *CurrentUnit, 0);
+        if (IsLinkedELF)
+          CurrentUnit->markPendingCanonicalDIEs();
+      }
     }
 
     // The calls to applyValidRelocs inside cloneDIE will walk the reloc
     // array again (in the same way findValidRelocsInDebugInfo() did). We
     // need to reset the NextValidReloc index to the beginning.
     LinkContext.RelocMgr.resetValidRelocs();
+    if (LLVM_UNLIKELY(Options.Statistics)) {
+      for (const auto &CU : LinkContext.DwarfContext->compile_units())
+        DebugInfoSizes[i].first += CU->getNextUnitOffset() - CU->getOffset();
+      DebugInfoSizes[i].second = OutputDebugInfoSize;
+    }
     if (LinkContext.RelocMgr.hasValidRelocs() || LLVM_UNLIKELY(Options.Update))
       DIECloner(*this, LinkContext.RelocMgr, DIEAlloc, LinkContext.CompileUnits,
                 Options)
@@ -2765,6 +2914,10 @@ bool DwarfLinker::link(const DebugMap &Map) {
           LinkContext.DMO, LinkContext.Ranges, *LinkContext.DwarfContext,
           LinkContext.CompileUnits[0]->getOrigUnit().getAddressByteSize());
 
+    if (LLVM_UNLIKELY(Options.Statistics))
+      DebugInfoSizes[i].second =
+          OutputDebugInfoSize - DebugInfoSizes[i].second;
+
     // Clean-up before starting working on the next object.
     endDebugObject(LinkContext);
   };
@@ -2832,6 +2985,10 @@ bool DwarfLinker::link(const DebugMap &Map) {
     pool.wait();
   }
 
+  if (Options.Statistics)
+    printStatistics(Map, DebugInfoSizes,
+                    std::chrono::steady_clock::now() - StartTime);
+
   if (Options.NoOutput)
     return true;
 
@@ -121,7 +121,8 @@ private:
     ///
     /// @{
     bool findValidRelocsInDebugInfo(const object::ObjectFile &Obj,
-                                    const DebugMapObject &DMO);
+                                    const DebugMapObject &DMO,
+                                    DWARFContext *Dwarf);
 
     bool findValidRelocs(const object::SectionRef &Section,
                          const object::ObjectFile &Obj,
@@ -130,6 +131,9 @@ private:
     void findValidRelocsMachO(const object::SectionRef &Section,
                               const object::MachOObjectFile &Obj,
                               const DebugMapObject &DMO);
+
+    void findValidAddressesInLinkedDebugInfo(DWARFContext &Dwarf,
+                                             const DebugMapObject &DMO);
     /// @}
 
     bool hasValidRelocation(uint32_t StartOffset, uint32_t EndOffset,
@@ -57,19 +57,29 @@ bool DwarfStreamer::init(Triple TheTriple) {
   if (!MRI)
     return error(Twine("no register info for target ") + TripleName, Context);
 
-  MAI.reset(TheTarget->createMCAsmInfo(*MRI, TripleName));
+  // The linked debug info is never relocated: its references to other debug
+  // sections are plain offsets, like on Darwin. The target machine applies
+  // this to the asm info shared by the MC layer and the AsmPrinter.
+  MCTargetOptions MCOptions = InitMCTargetOptionsFromFlags();
+  MCOptions.DwarfNoRelocationsAcrossSections = true;
+  TargetOptions TOptions;
+  TOptions.MCOptions = MCOptions;
+  TM.reset(TheTarget->createTargetMachine(TripleName, "", "", TOptions, None));
+  if (!TM)
+    return error("no target machine for target " + TripleName, Context);
+
+  MAI = TM->getMCAsmInfo();
   if (!MAI)
     return error("no asm info for target " + TripleName, Context);
 
   MOFI.reset(new MCObjectFileInfo);
-  MC.reset(new MCContext(MAI.get(), MRI.get(), MOFI.get()));
+  MC.reset(new MCContext(MAI, MRI.get(), MOFI.get()));
   MOFI->InitMCObjectFileInfo(TheTriple, /*PIC*/ false, *MC);
 
   MSTI.reset(TheTarget->createMCSubtargetInfo(TripleName, "", ""));
   if (!MSTI)
     return error("no subtarget info for target " + TripleName, Context);
 
-  MCTargetOptions MCOptions = InitMCTargetOptionsFromFlags();
   MAB = TheTarget->createMCAsmBackend(*MSTI, *MRI, MCOptions);
   if (!MAB)
     return error("no asm backend for target " + TripleName, Context);
@@ -106,11 +116,6 @@ bool DwarfStreamer::init(Triple TheTriple) {
     return error("no object streamer for target " + TripleName, Context);
 
   // Finally create the AsmPrinter we'll use to emit the DIEs.
-  TM.reset(TheTarget->createTargetMachine(TripleName, "", "", TargetOptions(),
-                                          None));
-  if (!TM)
-    return error("no target machine for target " + TripleName, Context);
-
   Asm.reset(TheTarget->createAsmPrinter(*TM, std::unique_ptr<MCStreamer>(MS)));
   if (!Asm)
     return error("no asm printer for target " + TripleName, Context);
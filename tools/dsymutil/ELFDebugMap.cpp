@@ -0,0 +1,96 @@
+//===- tools/dsymutil/ELFDebugMap.cpp - Debug maps for ELF binaries -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// ELF linkers copy the debug info of their inputs into the output instead of
+// leaving a debug map behind, so the debug map of a linked ELF binary has a
+// single object: the binary itself. Its symbols are the defined functions and
+// variables of the symbol table, at the same address in the "object" and in
+// the binary. DIEs describing code or data that the linker discarded have no
+// symbol at their address and are dropped by the DwarfLinker.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DebugMap.h"
+#include "dsymutil.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace llvm {
+namespace dsymutil {
+
+using namespace llvm::object;
+
+bool isELFBinary(StringRef InputFile) {
+  file_magic Magic;
+  if (identify_magic(InputFile, Magic))
+    return false;
+  return Magic == file_magic::elf_executable ||
+         Magic == file_magic::elf_shared_object;
+}
+
+ErrorOr<std::vector<std::unique_ptr<DebugMap>>>
+parseELFDebugMap(StringRef InputFile, bool Verbose) {
+  Expected<OwningBinary<ObjectFile>> ObjOrErr =
+      ObjectFile::createObjectFile(InputFile);
+  if (!ObjOrErr)
+    return errorToErrorCode(ObjOrErr.takeError());
+
+  const auto *Obj = dyn_cast<ELFObjectFileBase>(ObjOrErr->getBinary());
+  if (!Obj)
+    return make_error_code(object_error::invalid_file_type);
+
+  auto Map = llvm::make_unique<DebugMap>(Obj->makeTriple(), InputFile);
+  DebugMapObject &DMO =
+      Map->addDebugMapObject(InputFile, sys::TimePoint<std::chrono::seconds>());
+
+  for (const ELFSymbolRef &Sym : Obj->symbols()) {
+    Expected<SymbolRef::Type> TypeOrErr = Sym.getType();
+    if (!TypeOrErr) {
+      consumeError(TypeOrErr.takeError());
+      continue;
+    }
+    if (*TypeOrErr != SymbolRef::ST_Function && *TypeOrErr != SymbolRef::ST_Data)
+      continue;
+    if (Sym.getFlags() & SymbolRef::SF_Undefined)
+      continue;
+
+    Expected<StringRef> NameOrErr = Sym.getName();
+    Expected<uint64_t> AddrOrErr = Sym.getAddress();
+    if (!NameOrErr || !AddrOrErr) {
+      consumeError(NameOrErr.takeError());
+      consumeError(AddrOrErr.takeError());
+      continue;
+    }
+    if (NameOrErr->empty() || !*AddrOrErr)
+      continue;
+
+    // Like in the STABS debug maps, only functions have a size: it is used to
+    // compute the ranges of the line tables and of the call frame info.
+    uint64_t Address = *AddrOrErr;
+    uint32_t Size = *TypeOrErr == SymbolRef::ST_Function ? Sym.getSize() : 0;
+
+    // Local symbols of different translation units can share a name, but
+    // the linker only ever looks them up by address.
+    if (!DMO.addSymbol(*NameOrErr, Address, Address, Size))
+      DMO.addSymbol((*NameOrErr + "@0x" + Twine::utohexstr(Address)).str(),
+                    Address, Address, Size);
+  }
+
+  if (Verbose && DMO.empty())
+    WithColor::warning() << InputFile << ": no symbols to link\n";
+
+  std::vector<std::unique_ptr<DebugMap>> Result;
+  Result.push_back(std::move(Map));
+  return std::move(Result);
+}
+
+} // namespace dsymutil
+} // namespace llvm
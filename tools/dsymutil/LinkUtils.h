@@ -50,6 +50,9 @@ struct LinkOptions {
   /// Do not check swiftmodule timestamp
   bool NoTimestamp = false;
 
+  /// Print the size of the debug info before and after the link
+  bool Statistics = false;
+
   /// Number of threads.
   unsigned Threads = 1;
 
@@ -161,6 +161,12 @@ static opt<bool> InputIsYAMLDebugMap(
 static opt<bool> Verify("verify", desc("Verify the linked DWARF debug info."),
                         cat(DsymCategory));
 
+static opt<bool> Statistics(
+    "statistics",
+    desc("Print the size of the debug info of each object file and of its\n"
+         "contribution to the linked debug info, and the time the link took."),
+    init(false), cat(DsymCategory));
+
 static opt<std::string>
     Toolchain("toolchain", desc("Embed toolchain information in dSYM bundle."),
               cat(DsymCategory));
@@ -264,7 +270,7 @@ static bool verify(llvm::StringRef OutputFile, llvm::StringRef Arch) {
   }
 
   Binary &Binary = *BinOrErr.get().getBinary();
-  if (auto *Obj = dyn_cast<MachOObjectFile>(&Binary)) {
+  if (auto *Obj = dyn_cast<ObjectFile>(&Binary)) {
     raw_ostream &os = Verbose ? errs() : nulls();
     os << "Verifying DWARF for architecture: " << Arch << "\n";
     std::unique_ptr<DWARFContext> DICtx = DWARFContext::create(*Obj);
@@ -290,7 +296,8 @@ struct OutputLocation {
 };
 }
 
-static Expected<OutputLocation> getOutputFileName(llvm::StringRef InputFile) {
+static Expected<OutputLocation> getOutputFileName(llvm::StringRef InputFile,
+                                                  bool IsELF) {
   if (OutputFileOpt == "-")
     return OutputLocation(OutputFileOpt);
 
@@ -298,6 +305,14 @@ static Expected<OutputLocation> getOutputFileName(llvm::StringRef InputFile) {
   if (OutputFileOpt.empty() && (Update || !SymbolMap.empty()))
     return OutputLocation(InputFile);
 
+  // The debug info of an ELF binary goes to a separate debug file next to it,
+  // as there are no bundles outside of Darwin.
+  if (IsELF) {
+    if (OutputFileOpt.empty())
+      return OutputLocation((InputFile + ".debug").str());
+    return OutputLocation(OutputFileOpt);
+  }
+
   // If a flat dSYM has been requested, things are pretty simple.
   if (FlatOut) {
     if (OutputFileOpt.empty()) {
@@ -344,6 +359,7 @@ static Expected<LinkOptions> getOptions() {
   Options.Minimize = Minimize;
   Options.Update = Update;
   Options.NoTimestamp = NoTimestamp;
+  Options.Statistics = Statistics;
   Options.PrependPath = OsoPrependPath;
   Options.TheAccelTableKind = AcceleratorTable;
 
@@ -499,9 +515,13 @@ int main(int argc, char **argv) {
       continue;
     }
 
+    // Linked ELF binaries have no debug map, they link their own debug info.
+    bool IsELF = !InputIsYAMLDebugMap && !OptionsOrErr->Update &&
+                 isELFBinary(InputFile);
     auto DebugMapPtrsOrErr =
-        parseDebugMap(InputFile, ArchFlags, OsoPrependPath, PaperTrailWarnings,
-                      Verbose, InputIsYAMLDebugMap);
+        IsELF ? parseELFDebugMap(InputFile, Verbose)
+              : parseDebugMap(InputFile, ArchFlags, OsoPrependPath,
+                              PaperTrailWarnings, Verbose, InputIsYAMLDebugMap);
 
     if (auto EC = DebugMapPtrsOrErr.getError()) {
       WithColor::error() << "cannot parse the debug map for '" << InputFile
@@ -558,7 +578,7 @@ int main(int argc, char **argv) {
       std::shared_ptr<raw_fd_ostream> OS;
 
       Expected<OutputLocation> OutputLocationOrErr =
-          getOutputFileName(InputFile);
+          getOutputFileName(InputFile, IsELF);
       if (!OutputLocationOrErr) {
         WithColor::error() << toString(OutputLocationOrErr.takeError());
         return 1;
@@ -612,7 +632,8 @@ int main(int argc, char **argv) {
       return 1;
 
     if (NeedsTempFiles) {
-      Expected<OutputLocation> OutputLocationOrErr = getOutputFileName(InputFile);
+      Expected<OutputLocation> OutputLocationOrErr =
+          getOutputFileName(InputFile, IsELF);
       if (!OutputLocationOrErr) {
         WithColor::error() << toString(OutputLocationOrErr.takeError());
         return 1;
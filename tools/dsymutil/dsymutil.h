@@ -39,6 +39,15 @@ parseDebugMap(StringRef InputFile, ArrayRef<std::string> Archs,
               StringRef PrependPath, bool PaperTrailWarnings, bool Verbose,
               bool InputIsYAML);
 
+/// \returns true if \p InputFile is a linked ELF executable or shared object.
+bool isELFBinary(StringRef InputFile);
+
+/// Build the debug map of the linked ELF binary \p InputFile. As the linker
+/// already copied the debug info of its inputs, the map has a single object,
+/// the binary itself, whose symbols map to their own address.
+ErrorOr<std::vector<std::unique_ptr<DebugMap>>>
+parseELFDebugMap(StringRef InputFile, bool Verbose);
+
 /// Dump the symbol table
 bool dumpStab(StringRef InputFile, ArrayRef<std::string> Archs,
               StringRef PrependPath = "");
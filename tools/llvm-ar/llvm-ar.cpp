@@ -75,7 +75,12 @@ OPTIONS:
     =gnu                -   gnu
     =darwin             -   darwin
     =bsd                -   bsd
+  --num-threads=<n>     - Number of threads to read the members with
+                          for the symbol table, or 0 for one per hardware
+                          thread (default = 1)
   --plugin=<string>     - Ignored for compatibility
+  --use-irsymtab        - Read the symbols of bitcode members from their
+                          embedded symbol table when it is up to date
   --help                - Display available options
   --version             - Display the version of this program
 
@@ -182,6 +187,9 @@ static bool Deterministic = true;    ///< 'D' and 'U' modifiers
 static bool Thin = false;            ///< 'T' modifier
 static bool AddLibrary = false;      ///< 'L' modifier
 
+// How to read the symbols of the members.
+static ArchiveSymtabOptions SymtabOptions;
+
 // Relative Positional Argument (for insert/move). This variable holds
 // the name of the archive member to which the 'a', 'b' or 'i' modifier
 // refers. Only one of 'a', 'b' or 'i' can be specified so we only need
@@ -852,7 +860,8 @@ static void performWriteOperation(ArchiveOperation Operation,
 
   Error E =
       writeArchive(ArchiveName, NewMembersP ? *NewMembersP : NewMembers, Symtab,
-                   Kind, Deterministic, Thin, std::move(OldArchiveBuf));
+                   Kind, Deterministic, Thin, std::move(OldArchiveBuf),
+                   SymtabOptions);
   failIfError(std::move(E), ArchiveName);
 }
 
@@ -1063,6 +1072,11 @@ static int ar_main(int argc, char **argv) {
           fail(std::string("Invalid format ") + match);
       } else if (MatchFlagWithArg("plugin")) {
         // Ignored.
+      } else if (MatchFlagWithArg("num-threads")) {
+        if (StringRef(match).getAsInteger(10, SymtabOptions.NumThreads))
+          fail(std::string("Invalid number of threads ") + match);
+      } else if (Arg == "use-irsymtab") {
+        SymtabOptions.UseIRSymtab = true;
       } else {
         Options += Argv[i] + 1;
       }
@@ -5,6 +5,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugLoc.h"
 #include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/ThreadPool.h"
 
 #define DEBUG_TYPE "dwarfdump"
 using namespace llvm;
@@ -68,6 +69,12 @@ struct GlobalStats {
   uint64_t InlineFunctionSize = 0;
 };
 
+/// The statistics collected from one compile unit.
+struct UnitStats {
+  StringMap<PerFunctionStats> FnStatMap;
+  GlobalStats Global;
+};
+
 /// Extract the low pc from a Die.
 static uint64_t getLowPC(DWARFDie Die) {
   auto RangesOrError = Die.getAddressRanges();
@@ -296,6 +303,65 @@ static void collectStatsRecursive(DWARFDie Die, std::string FnPrefix,
   }
 }
 
+/// Adds the statistics of \p From to \p To.
+static void mergeStats(PerFunctionStats &To, const PerFunctionStats &From) {
+  To.NumFnInlined += From.NumFnInlined;
+  To.NumAbstractOrigins += From.NumAbstractOrigins;
+  To.TotalVarWithLoc += From.TotalVarWithLoc;
+  To.ConstantMembers += From.ConstantMembers;
+  for (const auto &Var : From.VarsInFunction)
+    To.VarsInFunction.insert(Var.getKey());
+  To.IsFunction |= From.IsFunction;
+  To.HasPCAddresses |= From.HasPCAddresses;
+  To.HasSourceLocation |= From.HasSourceLocation;
+  To.NumParams += From.NumParams;
+  To.NumParamSourceLocations += From.NumParamSourceLocations;
+  To.NumParamTypes += From.NumParamTypes;
+  To.NumParamLocations += From.NumParamLocations;
+  To.NumVars += From.NumVars;
+  To.NumVarSourceLocations += From.NumVarSourceLocations;
+  To.NumVarTypes += From.NumVarTypes;
+  To.NumVarLocations += From.NumVarLocations;
+}
+
+static void mergeStats(GlobalStats &To, const GlobalStats &From) {
+  To.ScopeBytesCovered += From.ScopeBytesCovered;
+  To.ScopeBytesFromFirstDefinition += From.ScopeBytesFromFirstDefinition;
+  To.CallSiteEntries += From.CallSiteEntries;
+  To.FunctionSize += From.FunctionSize;
+  To.InlineFunctionSize += From.InlineFunctionSize;
+}
+
+/// Collect the metrics of each compile unit of \p DICtx on \p NumThreads
+/// threads, and merge them. The merged metrics are sums, so they do not
+/// depend on the order in which the units are done.
+static void collectStatsInParallel(DWARFContext &DICtx, unsigned NumThreads,
+                                   StringMap<PerFunctionStats> &FnStatMap,
+                                   GlobalStats &GlobalStats) {
+  std::vector<DWARFUnit *> Units;
+  for (const auto &CU : DICtx.compile_units())
+    Units.push_back(CU.get());
+
+  ThreadPool Pool(NumThreads);
+  std::vector<UnitStats> Stats(Units.size());
+  for (unsigned I = 0, E = Units.size(); I != E; ++I) {
+    UnitStats *S = &Stats[I];
+    DWARFUnit *U = Units[I];
+    Pool.async([S, U] {
+      if (DWARFDie CUDie = U->getUnitDIE(false))
+        collectStatsRecursive(CUDie, "/", "g", 0, 0, 0, S->FnStatMap,
+                              S->Global);
+    });
+  }
+  Pool.wait();
+
+  for (const UnitStats &S : Stats) {
+    for (const auto &Entry : S.FnStatMap)
+      mergeStats(FnStatMap[Entry.getKey()], Entry.getValue());
+    mergeStats(GlobalStats, S.Global);
+  }
+}
+
 /// Print machine-readable output.
 /// The machine-readable format is single-line JSON output.
 /// \{
@@ -318,13 +384,18 @@ static void printDatum(raw_ostream &OS, const char *Key, uint64_t Value) {
 /// useful, only the delta between compiling the same program with different
 /// compilers is.
 bool collectStatsForObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
-                               Twine Filename, raw_ostream &OS) {
+                               Twine Filename, raw_ostream &OS,
+                               unsigned NumThreads) {
   StringRef FormatName = Obj.getFileFormatName();
   GlobalStats GlobalStats;
   StringMap<PerFunctionStats> Statistics;
-  for (const auto &CU : static_cast<DWARFContext *>(&DICtx)->compile_units())
-    if (DWARFDie CUDie = CU->getUnitDIE(false))
-      collectStatsRecursive(CUDie, "/", "g", 0, 0, 0, Statistics, GlobalStats);
+  if (NumThreads > 1)
+    collectStatsInParallel(DICtx, NumThreads, Statistics, GlobalStats);
+  else
+    for (const auto &CU : static_cast<DWARFContext *>(&DICtx)->compile_units())
+      if (DWARFDie CUDie = CU->getUnitDIE(false))
+        collectStatsRecursive(CUDie, "/", "g", 0, 0, 0, Statistics,
+                              GlobalStats);
 
   /// The version number should be increased every time the algorithm is changed
   /// (including bug fixes). New metrics may be added without increasing the
@@ -26,6 +26,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
@@ -211,6 +212,12 @@ static opt<bool> Verify("verify", desc("Verify the DWARF debug info."),
                         cat(DwarfDumpCategory));
 static opt<bool> Quiet("quiet", desc("Use with -verify to not emit to STDOUT."),
                        cat(DwarfDumpCategory));
+static opt<unsigned>
+    NumThreads("num-threads",
+               desc("Number of threads to verify or collect statistics on "
+                    "units with, or 0 for one per hardware thread "
+                    "(default = 1)"),
+               init(1), value_desc("N"), cat(DwarfDumpCategory));
 static opt<bool> DumpUUID("uuid", desc("Show the UUID for each architecture."),
                           cat(DwarfDumpCategory));
 static alias DumpUUIDAlias("u", desc("Alias for -uuid."), aliasopt(DumpUUID));
@@ -407,7 +414,17 @@ static bool lookup(ObjectFile &Obj, DWARFContext &DICtx, uint64_t Address,
 }
 
 bool collectStatsForObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
-                               Twine Filename, raw_ostream &OS);
+                               Twine Filename, raw_ostream &OS,
+                               unsigned NumThreads);
+
+static unsigned getNumThreads() {
+  return NumThreads ? NumThreads : heavyweight_hardware_concurrency();
+}
+
+static bool collectStats(ObjectFile &Obj, DWARFContext &DICtx, Twine Filename,
+                         raw_ostream &OS) {
+  return collectStatsForObjectFile(Obj, DICtx, Filename, OS, getNumThreads());
+}
 
 static bool dumpObjectFile(ObjectFile &Obj, DWARFContext &DICtx, Twine Filename,
                            raw_ostream &OS) {
@@ -450,7 +467,7 @@ static bool verifyObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
   raw_ostream &stream = Quiet ? nulls() : OS;
   stream << "Verifying " << Filename.str() << ":\tfile format "
   << Obj.getFileFormatName() << "\n";
-  bool Result = DICtx.verify(stream, getDumpOpts());
+  bool Result = DICtx.verify(stream, getDumpOpts(), getNumThreads());
   if (Result)
     stream << "No errors.\n";
   else
@@ -638,7 +655,7 @@ int main(int argc, char **argv) {
       return 1;
   } else if (Statistics)
     for (auto Object : Objects)
-      handleFile(Object, collectStatsForObjectFile, OutputFile.os());
+      handleFile(Object, collectStats, OutputFile.os());
   else
     for (auto Object : Objects)
       handleFile(Object, dumpObjectFile, OutputFile.os());
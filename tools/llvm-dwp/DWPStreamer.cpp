@@ -0,0 +1,133 @@
+#include "DWPStreamer.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCSectionELF.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+using namespace llvm;
+
+DWPStreamer::~DWPStreamer() {
+  for (Section &S : Sections) {
+    S.OS.reset();
+    sys::fs::remove(S.Path);
+  }
+}
+
+void DWPStreamer::ChangeSection(MCSection *Sec, const MCExpr *Subsection) {
+  assert(!Subsection && "unsupported by the DWP streamer");
+  auto P = SectionIndex.insert(std::make_pair(Sec, Sections.size()));
+  if (P.second) {
+    Sections.emplace_back();
+    Section &S = Sections.back();
+    S.Sec = cast<MCSectionELF>(Sec);
+    int FD;
+    if (std::error_code EC = sys::fs::createTemporaryFile(
+            "llvm-dwp", S.Sec->getSectionName().substr(1), FD, S.Path))
+      return getContext().reportError(
+          SMLoc(), "cannot create a temporary file: " + EC.message());
+    S.OS = llvm::make_unique<raw_fd_ostream>(FD, /*shouldClose=*/true);
+  }
+  CurSection = &Sections[P.first->second];
+}
+
+void DWPStreamer::EmitBytes(StringRef Data) {
+  CurSection->OS->write(Data.data(), Data.size());
+  CurSection->Size += Data.size();
+}
+
+void DWPStreamer::writeSectionContents(Section &S) {
+  S.OS->close();
+  if (S.OS->has_error())
+    return getContext().reportError(
+        SMLoc(), "cannot write " + S.Path + ": " + S.OS->error().message());
+
+  // Copy the section in slices, so that it is never mapped as a whole.
+  const uint64_t SliceSize = 16 << 20;
+  for (uint64_t Offset = 0; Offset < S.Size; Offset += SliceSize) {
+    auto BufOrErr = MemoryBuffer::getFileSlice(
+        S.Path, std::min(SliceSize, S.Size - Offset), Offset);
+    if (!BufOrErr)
+      return getContext().reportError(
+          SMLoc(), "cannot read " + S.Path + ": " + BufOrErr.getError().message());
+    OS << (*BufOrErr)->getBuffer();
+  }
+}
+
+void DWPStreamer::FinishImpl() {
+  // The section names, starting with the empty name of the null section.
+  std::string SectionNames(1, '\0');
+  std::vector<uint32_t> NameOffsets;
+  for (const Section &S : Sections) {
+    NameOffsets.push_back(SectionNames.size());
+    SectionNames += S.Sec->getSectionName();
+    SectionNames += '\0';
+  }
+  uint32_t ShStrTabName = SectionNames.size();
+  SectionNames += ".shstrtab";
+  SectionNames += '\0';
+
+  uint64_t Offset = sizeof(ELF::Elf64_Ehdr);
+  for (const Section &S : Sections)
+    Offset += S.Size;
+  uint64_t ShStrTabOffset = Offset;
+  uint64_t SectionHeadersOffset =
+      alignTo(ShStrTabOffset + SectionNames.size(), 8);
+
+  support::endian::Writer W(OS, support::little);
+
+  // The file header.
+  OS << ELF::ElfMagic;
+  W.write<uint8_t>(ELF::ELFCLASS64);
+  W.write<uint8_t>(ELF::ELFDATA2LSB);
+  W.write<uint8_t>(ELF::EV_CURRENT);
+  W.write<uint8_t>(ELF::ELFOSABI_NONE);
+  W.write<uint8_t>(0); // e_ident[EI_ABIVERSION]
+  OS.write_zeros(ELF::EI_NIDENT - ELF::EI_PAD);
+  W.write<uint16_t>(ELF::ET_REL);
+  W.write<uint16_t>(ELF::EM_X86_64);
+  W.write<uint32_t>(ELF::EV_CURRENT);
+  W.write<uint64_t>(0); // e_entry
+  W.write<uint64_t>(0); // e_phoff
+  W.write<uint64_t>(SectionHeadersOffset);
+  W.write<uint32_t>(0); // e_flags
+  W.write<uint16_t>(sizeof(ELF::Elf64_Ehdr));
+  W.write<uint16_t>(0); // e_phentsize
+  W.write<uint16_t>(0); // e_phnum
+  W.write<uint16_t>(sizeof(ELF::Elf64_Shdr));
+  W.write<uint16_t>(Sections.size() + 2);
+  W.write<uint16_t>(Sections.size() + 1);
+
+  // The section contents.
+  for (Section &S : Sections)
+    writeSectionContents(S);
+  OS << SectionNames;
+  OS.write_zeros(SectionHeadersOffset - ShStrTabOffset - SectionNames.size());
+
+  // The section headers.
+  auto WriteSectionHeader = [&](uint32_t Name, uint32_t Type, uint64_t Flags,
+                                uint64_t Offset, uint64_t Size,
+                                uint64_t EntrySize) {
+    W.write<uint32_t>(Name);
+    W.write<uint32_t>(Type);
+    W.write<uint64_t>(Flags);
+    W.write<uint64_t>(0); // sh_addr
+    W.write<uint64_t>(Offset);
+    W.write<uint64_t>(Size);
+    W.write<uint32_t>(0); // sh_link
+    W.write<uint32_t>(0); // sh_info
+    W.write<uint64_t>(Type == ELF::SHT_NULL ? 0 : 1); // sh_addralign
+    W.write<uint64_t>(EntrySize);
+  };
+  WriteSectionHeader(0, ELF::SHT_NULL, 0, 0, 0, 0);
+  Offset = sizeof(ELF::Elf64_Ehdr);
+  for (size_t I = 0; I != Sections.size(); ++I) {
+    const MCSectionELF &Sec = *Sections[I].Sec;
+    WriteSectionHeader(NameOffsets[I], Sec.getType(), Sec.getFlags(), Offset,
+                       Sections[I].Size, Sec.getEntrySize());
+    Offset += Sections[I].Size;
+  }
+  WriteSectionHeader(ShStrTabName, ELF::SHT_STRTAB, 0, ShStrTabOffset,
+                     SectionNames.size(), 0);
+}
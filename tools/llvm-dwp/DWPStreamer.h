@@ -0,0 +1,61 @@
+#ifndef TOOLS_LLVM_DWP_DWPSTREAMER
+#define TOOLS_LLVM_DWP_DWPSTREAMER
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/MC/MCStreamer.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <vector>
+
+namespace llvm {
+class MCSectionELF;
+
+/// A streamer that writes the sections of a package to temporary files as
+/// they are emitted, instead of keeping them in memory until the end like an
+/// object streamer does. Finish() writes the x86_64 ELF package to \p OS.
+///
+/// Only the raw bytes that llvm-dwp emits are supported: no symbols, no
+/// fixups and no alignment.
+class DWPStreamer : public MCStreamer {
+  struct Section {
+    MCSectionELF *Sec;
+    SmallString<128> Path;
+    std::unique_ptr<raw_fd_ostream> OS;
+    uint64_t Size = 0;
+  };
+
+  raw_ostream &OS;
+  std::vector<Section> Sections;
+  DenseMap<const MCSection *, unsigned> SectionIndex;
+  Section *CurSection = nullptr;
+
+  void writeSectionContents(Section &S);
+
+public:
+  DWPStreamer(MCContext &Context, raw_ostream &OS)
+      : MCStreamer(Context), OS(OS) {}
+  ~DWPStreamer() override;
+
+  void ChangeSection(MCSection *Section, const MCExpr *Subsection) override;
+  void EmitBytes(StringRef Data) override;
+  void FinishImpl() override;
+
+  bool EmitSymbolAttribute(MCSymbol *Symbol,
+                           MCSymbolAttr Attribute) override {
+    llvm_unreachable("unsupported by the DWP streamer");
+  }
+  void EmitCommonSymbol(MCSymbol *Symbol, uint64_t Size,
+                        unsigned ByteAlignment) override {
+    llvm_unreachable("unsupported by the DWP streamer");
+  }
+  void EmitZerofill(MCSection *Section, MCSymbol *Symbol = nullptr,
+                    uint64_t Size = 0, unsigned ByteAlignment = 0,
+                    SMLoc Loc = SMLoc()) override {
+    llvm_unreachable("unsupported by the DWP streamer");
+  }
+};
+}
+
+#endif
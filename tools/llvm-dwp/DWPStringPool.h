@@ -4,6 +4,8 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/MC/MCSection.h"
 #include "llvm/MC/MCStreamer.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/StringSaver.h"
 #include <cassert>
 
 namespace llvm {
@@ -34,21 +36,27 @@ class DWPStringPool {
   MCSection *Sec;
   DenseMap<const char *, uint32_t, CStrDenseMapInfo> Pool;
   uint32_t Offset = 0;
+  BumpPtrAllocator Alloc;
+  StringSaver Saver;
 
 public:
-  DWPStringPool(MCStreamer &Out, MCSection *Sec) : Out(Out), Sec(Sec) {}
+  DWPStringPool(MCStreamer &Out, MCSection *Sec)
+      : Out(Out), Sec(Sec), Saver(Alloc) {}
 
   uint32_t getOffset(const char *Str, unsigned Length) {
     assert(strlen(Str) + 1 == Length && "Ensure length hint is correct");
 
-    auto Pair = Pool.insert(std::make_pair(Str, Offset));
-    if (Pair.second) {
-      Out.SwitchSection(Sec);
-      Out.EmitBytes(StringRef(Str, Length));
-      Offset += Length;
-    }
+    auto It = Pool.find(Str);
+    if (It != Pool.end())
+      return It->second;
 
-    return Pair.first->second;
+    // The input that Str points into is released once written.
+    Pool.insert(
+        std::make_pair(Saver.save(StringRef(Str, Length - 1)).data(), Offset));
+    Out.SwitchSection(Sec);
+    Out.EmitBytes(StringRef(Str, Length));
+    Offset += Length;
+    return Offset - Length;
   }
 };
 }
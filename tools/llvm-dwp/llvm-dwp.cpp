@@ -11,10 +11,12 @@
 //
 //===----------------------------------------------------------------------===//
 #include "DWPError.h"
+#include "DWPStreamer.h"
 #include "DWPStringPool.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFFormValue.h"
 #include "llvm/DebugInfo/DWARF/DWARFUnitIndex.h"
@@ -33,15 +35,22 @@
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#ifdef LLVM_ON_UNIX
+#include <sys/resource.h>
+#endif
 
 using namespace llvm;
 using namespace llvm::object;
@@ -61,6 +70,23 @@ static cl::opt<std::string> OutputFilename(cl::Required, "o",
                                            cl::value_desc("filename"),
                                            cl::cat(DwpCategory));
 
+static cl::opt<bool>
+    Stream("stream",
+           cl::desc("Write the sections to temporary files as they are "
+                    "produced instead of building the package in memory"),
+           cl::cat(DwpCategory));
+
+static cl::opt<unsigned> NumThreads(
+    "num-threads",
+    cl::desc("Number of threads to read the input files with, or 0 for one "
+             "per hardware thread (default = 1)"),
+    cl::init(1), cl::cat(DwpCategory));
+
+static cl::opt<bool>
+    PrintStatistics("statistics",
+                    cl::desc("Print the peak memory usage and the wall time"),
+                    cl::cat(DwpCategory));
+
 static void writeStringsAndOffsets(MCStreamer &Out, DWPStringPool &Strings,
                                    MCSection *StrOffsetSection,
                                    StringRef CurStrSection,
@@ -393,32 +419,12 @@ static Error handleSection(
     const StringMap<std::pair<MCSection *, DWARFSectionKind>> &KnownSections,
     const MCSection *StrSection, const MCSection *StrOffsetSection,
     const MCSection *TypesSection, const MCSection *CUIndexSection,
-    const MCSection *TUIndexSection, const SectionRef &Section, MCStreamer &Out,
-    std::deque<SmallString<32>> &UncompressedSections,
-    uint32_t (&ContributionOffsets)[8], UnitIndexEntry &CurEntry,
-    StringRef &CurStrSection, StringRef &CurStrOffsetSection,
-    std::vector<StringRef> &CurTypesSection, StringRef &InfoSection,
-    StringRef &AbbrevSection, StringRef &CurCUIndexSection,
-    StringRef &CurTUIndexSection) {
-  if (Section.isBSS())
-    return Error::success();
-
-  if (Section.isVirtual())
-    return Error::success();
-
-  StringRef Name;
-  if (std::error_code Err = Section.getName(Name))
-    return errorCodeToError(Err);
-
-  StringRef Contents;
-  if (auto Err = Section.getContents(Contents))
-    return errorCodeToError(Err);
-
-  if (auto Err = handleCompressedSection(UncompressedSections, Name, Contents))
-    return Err;
-
-  Name = Name.substr(Name.find_first_not_of("._"));
-
+    const MCSection *TUIndexSection, StringRef Name, StringRef Contents,
+    MCStreamer &Out, uint32_t (&ContributionOffsets)[8],
+    UnitIndexEntry &CurEntry, StringRef &CurStrSection,
+    StringRef &CurStrOffsetSection, std::vector<StringRef> &CurTypesSection,
+    StringRef &InfoSection, StringRef &AbbrevSection,
+    StringRef &CurCUIndexSection, StringRef &CurTUIndexSection) {
   auto SectionPair = KnownSections.find(Name);
   if (SectionPair == KnownSections.end())
     return Error::success();
@@ -500,6 +506,106 @@ getDWOFilenames(StringRef ExecFilename) {
   return std::move(DWOPaths);
 }
 
+namespace {
+/// An input file, with its sections decompressed.
+struct DWOInput {
+  OwningBinary<object::ObjectFile> Obj;
+  std::deque<SmallString<32>> UncompressedSections;
+  /// The names, without their leading "." or "__", and contents of the
+  /// sections, in file order.
+  std::vector<std::pair<StringRef, StringRef>> Sections;
+};
+} // namespace
+
+static Expected<std::unique_ptr<DWOInput>> loadInput(StringRef Input) {
+  auto ErrOrObj = object::ObjectFile::createObjectFile(Input);
+  if (!ErrOrObj)
+    return ErrOrObj.takeError();
+
+  auto Result = llvm::make_unique<DWOInput>();
+  Result->Obj = std::move(*ErrOrObj);
+  for (const auto &Section : Result->Obj.getBinary()->sections()) {
+    if (Section.isBSS() || Section.isVirtual())
+      continue;
+
+    StringRef Name;
+    if (std::error_code Err = Section.getName(Name))
+      return errorCodeToError(Err);
+
+    StringRef Contents;
+    if (auto Err = Section.getContents(Contents))
+      return errorCodeToError(Err);
+
+    if (auto Err = handleCompressedSection(Result->UncompressedSections, Name,
+                                           Contents))
+      return std::move(Err);
+
+    Name = Name.substr(Name.find_first_not_of("._"));
+    Result->Sections.emplace_back(Name, Contents);
+  }
+  return std::move(Result);
+}
+
+/// Loads the inputs in order. With more than one thread, the next inputs are
+/// loaded in the background while the current one is written, but no more
+/// than one per thread, so that memory use does not grow with the number of
+/// inputs.
+class InputLoader {
+  ArrayRef<std::string> Inputs;
+  std::unique_ptr<ThreadPool> Pool;
+  size_t Window = 0;
+  size_t NextToLoad = 0;
+  /// The loaded inputs, or the error messages when they failed to load.
+  std::vector<std::unique_ptr<DWOInput>> Loaded;
+  std::vector<std::string> Errors;
+  std::deque<std::shared_future<void>> Pending;
+
+  void loadNext() {
+    size_t I = NextToLoad++;
+    auto Load = [this, I] {
+      auto InputOrErr = loadInput(Inputs[I]);
+      if (InputOrErr)
+        Loaded[I] = std::move(*InputOrErr);
+      else
+        Errors[I] = toString(InputOrErr.takeError());
+    };
+    if (Pool)
+      Pending.push_back(Pool->async(Load));
+    else
+      Load();
+  }
+
+public:
+  InputLoader(ArrayRef<std::string> Inputs, unsigned NumThreads)
+      : Inputs(Inputs), Loaded(Inputs.size()), Errors(Inputs.size()) {
+    if (NumThreads != 1) {
+      unsigned ThreadCount =
+          NumThreads ? NumThreads : heavyweight_hardware_concurrency();
+      Pool = llvm::make_unique<ThreadPool>(ThreadCount);
+      Window = ThreadCount;
+    }
+  }
+
+  ~InputLoader() {
+    if (Pool)
+      Pool->wait();
+  }
+
+  /// Returns input \p I, which must be the one after the previous call's.
+  /// Ownership passes to the caller, who can release it once written.
+  Expected<std::unique_ptr<DWOInput>> get(size_t I) {
+    while (NextToLoad < std::min(I + 1 + Window, Inputs.size()))
+      loadNext();
+    if (Pool) {
+      Pending.front().wait();
+      Pending.pop_front();
+    }
+    if (!Errors[I].empty())
+      return make_error<StringError>(Errors[I], inconvertibleErrorCode());
+    return std::move(Loaded[I]);
+  }
+};
+
 static Error write(MCStreamer &Out, ArrayRef<std::string> Inputs) {
   const auto &MCOFI = *Out.getContext().getObjectFileInfo();
   MCSection *const StrSection = MCOFI.getDwarfStrDWOSection();
@@ -525,18 +631,17 @@ static Error write(MCStreamer &Out, ArrayRef<std::string> Inputs) {
 
   DWPStringPool Strings(Out, StrSection);
 
-  SmallVector<OwningBinary<object::ObjectFile>, 128> Objects;
-  Objects.reserve(Inputs.size());
+  // Every input is released once written: the string pool and the index
+  // entries keep copies of what they need.
+  InputLoader Loader(Inputs, NumThreads);
 
-  std::deque<SmallString<32>> UncompressedSections;
-
-  for (const auto &Input : Inputs) {
-    auto ErrOrObj = object::ObjectFile::createObjectFile(Input);
-    if (!ErrOrObj)
-      return ErrOrObj.takeError();
-
-    auto &Obj = *ErrOrObj->getBinary();
-    Objects.push_back(std::move(*ErrOrObj));
+  for (size_t InputIdx = 0; InputIdx != Inputs.size(); ++InputIdx) {
+    const std::string &Input = Inputs[InputIdx];
+    auto InputOrErr = Loader.get(InputIdx);
+    if (!InputOrErr)
+      return InputOrErr.takeError();
+    std::unique_ptr<DWOInput> CurInput = std::move(*InputOrErr);
+    const auto &Obj = *CurInput->Obj.getBinary();
 
     UnitIndexEntry CurEntry = {};
 
@@ -548,13 +653,13 @@ static Error write(MCStreamer &Out, ArrayRef<std::string> Inputs) {
     StringRef CurCUIndexSection;
     StringRef CurTUIndexSection;
 
-    for (const auto &Section : Obj.sections())
+    for (const auto &Section : CurInput->Sections)
       if (auto Err = handleSection(
               KnownSections, StrSection, StrOffsetSection, TypesSection,
-              CUIndexSection, TUIndexSection, Section, Out,
-              UncompressedSections, ContributionOffsets, CurEntry,
-              CurStrSection, CurStrOffsetSection, CurTypesSection, InfoSection,
-              AbbrevSection, CurCUIndexSection, CurTUIndexSection))
+              CUIndexSection, TUIndexSection, Section.first, Section.second,
+              Out, ContributionOffsets, CurEntry, CurStrSection,
+              CurStrOffsetSection, CurTypesSection, InfoSection, AbbrevSection,
+              CurCUIndexSection, CurTUIndexSection))
         return Err;
 
     if (InfoSection.empty())
@@ -641,6 +746,21 @@ static Error write(MCStreamer &Out, ArrayRef<std::string> Inputs) {
   return Error::success();
 }
 
+/// Returns the peak resident set size of the process in bytes, or 0 if it is
+/// not known.
+static uint64_t getPeakRSS() {
+#ifdef LLVM_ON_UNIX
+  struct rusage RU;
+  if (::getrusage(RUSAGE_SELF, &RU) == 0)
+#ifdef __APPLE__
+    return RU.ru_maxrss;
+#else
+    return RU.ru_maxrss * 1024;
+#endif
+#endif
+  return 0;
+}
+
 static int error(const Twine &Error, const Twine &Context) {
   errs() << Twine("while processing ") + Context + ":\n";
   errs() << Twine("error: ") + Error + "\n";
@@ -652,6 +772,8 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "merge split dwarf (.dwo) files\n");
 
+  auto StartTime = std::chrono::steady_clock::now();
+
   llvm::InitializeAllTargetInfos();
   llvm::InitializeAllTargetMCs();
   llvm::InitializeAllTargets();
@@ -688,7 +810,8 @@ int main(int argc, char **argv) {
     return error("no subtarget info for target " + TripleName, Context);
 
   MCTargetOptions Options;
-  auto MAB = TheTarget->createMCAsmBackend(*MSTI, *MRI, Options);
+  std::unique_ptr<MCAsmBackend> MAB(
+      TheTarget->createMCAsmBackend(*MSTI, *MRI, Options));
   if (!MAB)
     return error("no asm backend for target " + TripleName, Context);
 
@@ -696,7 +819,8 @@ int main(int argc, char **argv) {
   if (!MII)
     return error("no instr info info for target " + TripleName, Context);
 
-  MCCodeEmitter *MCE = TheTarget->createMCCodeEmitter(*MII, *MRI, MC);
+  std::unique_ptr<MCCodeEmitter> MCE(
+      TheTarget->createMCCodeEmitter(*MII, *MRI, MC));
   if (!MCE)
     return error("no code emitter for target " + TripleName, Context);
 
@@ -715,11 +839,16 @@ int main(int argc, char **argv) {
   }
 
   MCTargetOptions MCOptions = InitMCTargetOptionsFromFlags();
-  std::unique_ptr<MCStreamer> MS(TheTarget->createMCObjectStreamer(
-      TheTriple, MC, std::unique_ptr<MCAsmBackend>(MAB),
-      MAB->createObjectWriter(*OS), std::unique_ptr<MCCodeEmitter>(MCE), *MSTI,
-      MCOptions.MCRelaxAll, MCOptions.MCIncrementalLinkerCompatible,
-      /*DWARFMustBeAtTheEnd*/ false));
+  std::unique_ptr<MCStreamer> MS;
+  if (Stream) {
+    MS = llvm::make_unique<DWPStreamer>(MC, *OS);
+  } else {
+    std::unique_ptr<MCObjectWriter> OW = MAB->createObjectWriter(*OS);
+    MS.reset(TheTarget->createMCObjectStreamer(
+        TheTriple, MC, std::move(MAB), std::move(OW), std::move(MCE), *MSTI,
+        MCOptions.MCRelaxAll, MCOptions.MCIncrementalLinkerCompatible,
+        /*DWARFMustBeAtTheEnd*/ false));
+  }
   if (!MS)
     return error("no object streamer for target " + TripleName, Context);
 
@@ -742,5 +871,12 @@ int main(int argc, char **argv) {
 
   MS->Finish();
   OutFile.keep();
+
+  if (PrintStatistics) {
+    std::chrono::duration<double> WallTime =
+        std::chrono::steady_clock::now() - StartTime;
+    errs() << format("Peak RSS: %.1f MiB\n", getPeakRSS() / 1048576.0)
+           << format("Wall time: %.3fs\n", WallTime.count());
+  }
   return 0;
 }
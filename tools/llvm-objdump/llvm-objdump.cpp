@@ -18,6 +18,7 @@
 #include "llvm-objdump.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/Triple.h"
@@ -58,11 +59,14 @@
 #include "llvm/Support/StringSaver.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <mutex>
 #include <system_error>
 #include <unordered_map>
 #include <utility>
@@ -216,6 +220,12 @@ cl::opt<bool> NoShowRawInsn("no-show-raw-insn",
 cl::opt<bool> NoLeadingAddr("no-leading-addr",
                                    cl::desc("Print no leading address"));
 
+static cl::opt<unsigned> NumThreads(
+    "num-threads",
+    cl::desc("Number of threads to disassemble functions with, or 0 for one "
+             "per hardware thread (default = 1)"),
+    cl::init(1));
+
 static cl::opt<bool> RawClangAST(
     "raw-clang-ast",
     cl::desc("Dump the raw binary contents of the clang AST section"));
@@ -478,34 +488,82 @@ static bool getHidden(RelocationRef RelRef) {
 }
 
 namespace {
-class SourcePrinter {
-protected:
-  DILineInfo OldLineInfo;
-  const ObjectFile *Obj = nullptr;
-  std::unique_ptr<symbolize::LLVMSymbolizer> Symbolizer;
+/// The source files read for --source. They are shared by the source printers
+/// of all disassembly threads.
+class SourceFileCache {
+  std::mutex Mutex;
   // File name to file contents of source
   std::unordered_map<std::string, std::unique_ptr<MemoryBuffer>> SourceCache;
   // Mark the line endings of the cached source
   std::unordered_map<std::string, std::vector<StringRef>> LineCache;
 
-private:
   bool cacheSource(const DILineInfo& LineInfoFile);
 
+public:
+  /// Returns the text of the line \p LineInfo refers to, or None if it cannot
+  /// be read.
+  Optional<StringRef> getLine(const DILineInfo &LineInfo);
+};
+
+class SourcePrinter {
+protected:
+  DILineInfo OldLineInfo;
+  const ObjectFile *Obj = nullptr;
+  std::unique_ptr<symbolize::LLVMSymbolizer> Symbolizer;
+  std::shared_ptr<SourceFileCache> Sources;
+  // Line table rows of the function being disassembled, sorted by address.
+  Optional<DILineInfoTable> FunctionLines;
+  // The lines compared with the initial OldLineInfo, before any was printed.
+  SmallSet<uint32_t, 2> InitialLines;
+  bool PrintedLine = false;
+
 public:
   SourcePrinter() = default;
-  SourcePrinter(const ObjectFile *Obj, StringRef DefaultArch) : Obj(Obj) {
+  SourcePrinter(const ObjectFile *Obj, StringRef DefaultArch)
+      : Obj(Obj), Sources(std::make_shared<SourceFileCache>()) {
     symbolize::LLVMSymbolizer::Options SymbolizerOpts(
         DILineInfoSpecifier::FunctionNameKind::None, true, false, false,
         DefaultArch);
     Symbolizer.reset(new symbolize::LLVMSymbolizer(SymbolizerOpts));
   }
+  /// Creates a printer for a function disassembled on another thread. It
+  /// prints from the rows of \p Lines and shares \p Parent's source files.
+  SourcePrinter(const SourcePrinter &Parent, DILineInfoTable Lines)
+      : Obj(Parent.Obj), Sources(Parent.Sources),
+        FunctionLines(std::move(Lines)) {}
   virtual ~SourcePrinter() = default;
   virtual void printSourceLine(raw_ostream &OS,
                                object::SectionedAddress Address,
                                StringRef Delimiter = "; ");
+
+  /// Looks up the line table rows of [Address, Address + Size) at once.
+  DILineInfoTable lookUpLines(object::SectionedAddress Address,
+                              uint64_t Size);
+  /// Prints the lines of the next function from the rows of \p Lines instead
+  /// of symbolizing each instruction.
+  void setFunctionLines(DILineInfoTable Lines) {
+    FunctionLines = std::move(Lines);
+  }
+
+  /// Returns true if the output of this printer would have been different had
+  /// it started out in the state \p Prev is in.
+  bool dependsOnLineState(const SourcePrinter &Prev) const {
+    return InitialLines.count(Prev.OldLineInfo.Line);
+  }
+  /// Starts over in the state \p Prev is in.
+  void resetLineState(const SourcePrinter &Prev) {
+    OldLineInfo = Prev.OldLineInfo;
+    InitialLines.clear();
+    PrintedLine = false;
+  }
+  /// Continues in the state \p Next ended up in.
+  void takeLineState(const SourcePrinter &Next) {
+    if (Next.PrintedLine)
+      OldLineInfo = Next.OldLineInfo;
+  }
 };
 
-bool SourcePrinter::cacheSource(const DILineInfo &LineInfo) {
+bool SourceFileCache::cacheSource(const DILineInfo &LineInfo) {
   std::unique_ptr<MemoryBuffer> Buffer;
   if (LineInfo.Source) {
     Buffer = MemoryBuffer::getMemBuffer(*LineInfo.Source);
@@ -531,38 +589,75 @@ bool SourcePrinter::cacheSource(const DILineInfo &LineInfo) {
   return true;
 }
 
+Optional<StringRef> SourceFileCache::getLine(const DILineInfo &LineInfo) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  if (SourceCache.find(LineInfo.FileName) == SourceCache.end())
+    if (!cacheSource(LineInfo))
+      return None;
+  // The lines of a file never change once cached, so the result stays valid
+  // after the lock is released.
+  const std::vector<StringRef> &Lines = LineCache[LineInfo.FileName];
+  if (LineInfo.Line > Lines.size())
+    return None;
+  // Vector begins at 0, line numbers are non-zero
+  return Lines[LineInfo.Line - 1];
+}
+
+DILineInfoTable SourcePrinter::lookUpLines(object::SectionedAddress Address,
+                                           uint64_t Size) {
+  if (!Symbolizer)
+    return DILineInfoTable();
+  auto ExpectedLines =
+      Symbolizer->symbolizeCodeRange(Obj->getFileName(), Address, Size);
+  if (!ExpectedLines) {
+    consumeError(ExpectedLines.takeError());
+    return DILineInfoTable();
+  }
+  return std::move(*ExpectedLines);
+}
+
 void SourcePrinter::printSourceLine(raw_ostream &OS,
                                     object::SectionedAddress Address,
                                     StringRef Delimiter) {
-  if (!Symbolizer)
-    return;
-  DILineInfo LineInfo = DILineInfo();
-  auto ExpectedLineInfo =
-      Symbolizer->symbolizeCode(Obj->getFileName(), Address);
-  if (!ExpectedLineInfo)
-    consumeError(ExpectedLineInfo.takeError());
-  else
-    LineInfo = *ExpectedLineInfo;
+  DILineInfo Symbolized;
+  const DILineInfo *LineInfo = &Symbolized;
+  if (FunctionLines) {
+    // The last row at or before the address describes it.
+    auto Row = llvm::upper_bound(
+        *FunctionLines, Address.Address,
+        [](uint64_t Address, const std::pair<uint64_t, DILineInfo> &Row) {
+          return Address < Row.first;
+        });
+    if (Row != FunctionLines->begin())
+      LineInfo = &std::prev(Row)->second;
+  } else {
+    if (!Symbolizer)
+      return;
+    auto ExpectedLineInfo =
+        Symbolizer->symbolizeCode(Obj->getFileName(), Address);
+    if (!ExpectedLineInfo)
+      consumeError(ExpectedLineInfo.takeError());
+    else
+      Symbolized = *ExpectedLineInfo;
+  }
 
-  if ((LineInfo.FileName == "<invalid>") || OldLineInfo.Line == LineInfo.Line ||
-      LineInfo.Line == 0)
+  if ((LineInfo->FileName == "<invalid>") || LineInfo->Line == 0)
+    return;
+  if (!PrintedLine)
+    InitialLines.insert(LineInfo->Line);
+  if (OldLineInfo.Line == LineInfo->Line)
     return;
 
   if (PrintLines)
-    OS << Delimiter << LineInfo.FileName << ":" << LineInfo.Line << "\n";
+    OS << Delimiter << LineInfo->FileName << ":" << LineInfo->Line << "\n";
   if (PrintSource) {
-    if (SourceCache.find(LineInfo.FileName) == SourceCache.end())
-      if (!cacheSource(LineInfo))
-        return;
-    auto LineBuffer = LineCache.find(LineInfo.FileName);
-    if (LineBuffer != LineCache.end()) {
-      if (LineInfo.Line > LineBuffer->second.size())
-        return;
-      // Vector begins at 0, line numbers are non-zero
-      OS << Delimiter << LineBuffer->second[LineInfo.Line - 1] << '\n';
-    }
+    Optional<StringRef> Line = Sources->getLine(*LineInfo);
+    if (!Line)
+      return;
+    OS << Delimiter << *Line << '\n';
   }
-  OldLineInfo = LineInfo;
+  OldLineInfo = *LineInfo;
+  PrintedLine = true;
 }
 
 static bool isArmElf(const ObjectFile *Obj) {
@@ -575,14 +670,14 @@ static bool isArmElf(const ObjectFile *Obj) {
 }
 
 static void printRelocation(const RelocationRef &Rel, uint64_t Address,
-                            uint8_t AddrSize) {
+                            uint8_t AddrSize, raw_ostream &OS) {
   StringRef Fmt =
       AddrSize > 4 ? "\t\t%016" PRIx64 ":  " : "\t\t\t%08" PRIx64 ":  ";
   SmallString<16> Name;
   SmallString<32> Val;
   Rel.getTypeName(Name);
   error(getRelocationValueString(Rel, Val));
-  outs() << format(Fmt.data(), Address) << Name << "\t" << Val << "\n";
+  OS << format(Fmt.data(), Address) << Name << "\t" << Val << "\n";
 }
 
 class PrettyPrinter {
@@ -667,7 +762,7 @@ public:
     auto PrintReloc = [&]() -> void {
       while ((RelCur != RelEnd) && (RelCur->getOffset() <= Address.Address)) {
         if (RelCur->getOffset() == Address.Address) {
-          printRelocation(*RelCur, Address.Address, 4);
+          printRelocation(*RelCur, Address.Address, 4, OS);
           return;
         }
         ++RelCur;
@@ -920,30 +1015,31 @@ static bool shouldAdjustVA(const SectionRef &Section) {
 static uint64_t
 dumpARMELFData(uint64_t SectionAddr, uint64_t Index, uint64_t End,
                const ObjectFile *Obj, ArrayRef<uint8_t> Bytes,
-               const std::vector<uint64_t> &TextMappingSymsAddr) {
+               const std::vector<uint64_t> &TextMappingSymsAddr,
+               raw_ostream &OS) {
   support::endianness Endian =
       Obj->isLittleEndian() ? support::little : support::big;
   while (Index < End) {
-    outs() << format("%8" PRIx64 ":", SectionAddr + Index);
-    outs() << "\t";
+    OS << format("%8" PRIx64 ":", SectionAddr + Index);
+    OS << "\t";
     if (Index + 4 <= End) {
-      dumpBytes(Bytes.slice(Index, 4), outs());
-      outs() << "\t.word\t"
+      dumpBytes(Bytes.slice(Index, 4), OS);
+      OS << "\t.word\t"
              << format_hex(
                     support::endian::read32(Bytes.data() + Index, Endian), 10);
       Index += 4;
     } else if (Index + 2 <= End) {
-      dumpBytes(Bytes.slice(Index, 2), outs());
-      outs() << "\t\t.short\t"
+      dumpBytes(Bytes.slice(Index, 2), OS);
+      OS << "\t\t.short\t"
              << format_hex(
                     support::endian::read16(Bytes.data() + Index, Endian), 6);
       Index += 2;
     } else {
-      dumpBytes(Bytes.slice(Index, 1), outs());
-      outs() << "\t\t.byte\t" << format_hex(Bytes[0], 4);
+      dumpBytes(Bytes.slice(Index, 1), OS);
+      OS << "\t\t.byte\t" << format_hex(Bytes[0], 4);
       ++Index;
     }
-    outs() << "\n";
+    OS << "\n";
     if (std::binary_search(TextMappingSymsAddr.begin(),
                            TextMappingSymsAddr.end(), Index))
       break;
@@ -952,7 +1048,7 @@ dumpARMELFData(uint64_t SectionAddr, uint64_t Index, uint64_t End,
 }
 
 static void dumpELFData(uint64_t SectionAddr, uint64_t Index, uint64_t End,
-                        ArrayRef<uint8_t> Bytes) {
+                        ArrayRef<uint8_t> Bytes, raw_ostream &OS) {
   // print out data up to 8 bytes at a time in hex and ascii
   uint8_t AsciiData[9] = {'\0'};
   uint8_t Byte;
@@ -960,11 +1056,11 @@ static void dumpELFData(uint64_t SectionAddr, uint64_t Index, uint64_t End,
 
   for (; Index < End; ++Index) {
     if (NumBytes == 0) {
-      outs() << format("%8" PRIx64 ":", SectionAddr + Index);
-      outs() << "\t";
+      OS << format("%8" PRIx64 ":", SectionAddr + Index);
+      OS << "\t";
     }
     Byte = Bytes.slice(Index)[0];
-    outs() << format(" %02x", Byte);
+    OS << format(" %02x", Byte);
     AsciiData[NumBytes] = isPrint(Byte) ? Byte : '.';
 
     uint8_t IndentOffset = 0;
@@ -979,18 +1075,57 @@ static void dumpELFData(uint64_t SectionAddr, uint64_t Index, uint64_t End,
     }
     if (NumBytes == 8) {
       AsciiData[8] = '\0';
-      outs() << std::string(IndentOffset, ' ') << "         ";
-      outs() << reinterpret_cast<char *>(AsciiData);
-      outs() << '\n';
+      OS << std::string(IndentOffset, ' ') << "         ";
+      OS << reinterpret_cast<char *>(AsciiData);
+      OS << '\n';
       NumBytes = 0;
     }
   }
 }
 
+static std::unique_ptr<MCInstPrinter>
+createInstPrinter(const Target *TheTarget, const ObjectFile *Obj,
+                  const MCAsmInfo &AsmInfo, const MCInstrInfo &MII,
+                  const MCRegisterInfo &MRI) {
+  int AsmPrinterVariant = AsmInfo.getAssemblerDialect();
+  std::unique_ptr<MCInstPrinter> IP(TheTarget->createMCInstPrinter(
+      Triple(TripleName), AsmPrinterVariant, AsmInfo, MII, MRI));
+  if (!IP)
+    report_error(Obj->getFileName(),
+                 "no instruction printer for target " + TripleName);
+  IP->setPrintImmHex(PrintImmHex);
+
+  for (StringRef Opt : DisassemblerOptions)
+    if (!IP->applyTargetSpecificCLOption(Opt))
+      error("Unrecognized disassembler option: " + Opt);
+  return IP;
+}
+
+namespace {
+/// A function disassembled on a worker thread.
+struct FunctionJob {
+  unsigned SI;
+  uint64_t Start;
+  uint64_t End;
+  std::unique_ptr<SourcePrinter> SP;
+  std::string Text;
+};
+
+/// The MC objects a worker thread disassembles with. They are not
+/// thread-safe, so each thread takes a set of its own from a shared pool and
+/// keeps reusing it.
+struct WorkerMCState {
+  std::unique_ptr<MCContext> Ctx;
+  std::unique_ptr<MCDisassembler> DisAsm;
+  std::unique_ptr<MCInstPrinter> IP;
+};
+} // namespace
+
 static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
                               MCContext &Ctx, MCDisassembler *DisAsm,
                               const MCInstrAnalysis *MIA, MCInstPrinter *IP,
-                              const MCSubtargetInfo *STI, PrettyPrinter &PIP,
+                              const MCSubtargetInfo *STI,
+                              const MCInstrInfo &MII, PrettyPrinter &PIP,
                               SourcePrinter &SP, bool InlineRelocs) {
   std::map<SectionRef, std::vector<RelocationRef>> RelocMap;
   if (InlineRelocs)
@@ -1064,6 +1199,22 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
     array_pod_sort(SecSyms.second.begin(), SecSyms.second.end());
   array_pod_sort(AbsoluteSymbols.begin(), AbsoluteSymbols.end());
 
+  // Functions can be disassembled in parallel if nothing but the source line
+  // state carries over from one to the next. Inline relocations are printed
+  // from a cursor that does, and the AMDGPU symbolizer is per section.
+  bool Parallel = NumThreads != 1 && !InlineRelocs &&
+                  !(Obj->isELF() && Obj->getArch() == Triple::amdgcn);
+  std::unique_ptr<ThreadPool> Pool;
+  size_t ParallelWindow = 0;
+  std::mutex WorkerStatesLock;
+  std::vector<std::unique_ptr<WorkerMCState>> FreeWorkerStates;
+  if (Parallel) {
+    unsigned ThreadCount =
+        NumThreads ? NumThreads : heavyweight_hardware_concurrency();
+    Pool = llvm::make_unique<ThreadPool>(ThreadCount);
+    ParallelWindow = 64 * ThreadCount;
+  }
+
   for (const SectionRef &Section : ToolSectionFilter(*Obj)) {
     if (!DisassembleAll && (!Section.isText() || Section.isVirtual()))
       continue;
@@ -1123,9 +1274,6 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
                           Section.isText() ? ELF::STT_FUNC : ELF::STT_OBJECT));
     }
 
-    SmallString<40> Comments;
-    raw_svector_ostream CommentStream(Comments);
-
     StringRef BytesStr;
     error(Section.getContents(BytesStr));
     ArrayRef<uint8_t> Bytes = arrayRefFromStringRef(BytesStr);
@@ -1134,75 +1282,38 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
     if (shouldAdjustVA(Section))
       VMAAdjustment = AdjustVMA;
 
-    uint64_t Size;
-    uint64_t Index;
     bool PrintedSection = false;
     std::vector<RelocationRef> Rels = RelocMap[Section];
-    std::vector<RelocationRef>::const_iterator RelCur = Rels.begin();
-    std::vector<RelocationRef>::const_iterator RelEnd = Rels.end();
-    // Disassemble symbol by symbol.
-    for (unsigned SI = 0, SE = Symbols.size(); SI != SE; ++SI) {
-      // Skip if --disassemble-functions is not empty and the symbol is not in
-      // the list.
-      if (!DisasmFuncsSet.empty() &&
-          !DisasmFuncsSet.count(std::get<1>(Symbols[SI])))
-        continue;
-
-      uint64_t Start = std::get<0>(Symbols[SI]);
-      if (Start < SectionAddr || StopAddress <= Start)
-        continue;
-
-      // The end is the section end, the beginning of the next symbol, or
-      // --stop-address.
-      uint64_t End = std::min<uint64_t>(SectionAddr + SectSize, StopAddress);
-      if (SI + 1 < SE)
-        End = std::min(End, std::get<0>(Symbols[SI + 1]));
-      if (Start >= End || End <= StartAddress)
-        continue;
-      Start -= SectionAddr;
-      End -= SectionAddr;
-
-      if (!PrintedSection) {
-        PrintedSection = true;
-        outs() << "\nDisassembly of section ";
-        if (!SegmentName.empty())
-          outs() << SegmentName << ",";
-        outs() << SectionName << ":\n";
-      }
-
-      if (Obj->isELF() && Obj->getArch() == Triple::amdgcn) {
-        if (std::get<2>(Symbols[SI]) == ELF::STT_AMDGPU_HSA_KERNEL) {
-          // skip amd_kernel_code_t at the begining of kernel symbol (256 bytes)
-          Start += 256;
-        }
-        if (SI == SE - 1 ||
-            std::get<2>(Symbols[SI + 1]) == ELF::STT_AMDGPU_HSA_KERNEL) {
-          // cut trailing zeroes at the end of kernel
-          // cut up to 256 bytes
-          const uint64_t EndAlign = 256;
-          const auto Limit = End - (std::min)(EndAlign, End - Start);
-          while (End > Limit &&
-            *reinterpret_cast<const support::ulittle32_t*>(&Bytes[End - 4]) == 0)
-            End -= 4;
-        }
-      }
-
-      outs() << '\n';
+    using RelocIterator = std::vector<RelocationRef>::const_iterator;
+    RelocIterator RelCur = Rels.begin();
+    RelocIterator RelEnd = Rels.end();
+
+    // Disassembles the symbol Symbols[SI], which covers [Start, End) of the
+    // section, to OS. The relocations in [RelCur, RelEnd) are printed after
+    // the instructions they apply to.
+    auto DisassembleSymbol = [&](unsigned SI, uint64_t Start, uint64_t End,
+                                 raw_ostream &OS, MCDisassembler &DisAsm,
+                                 MCInstPrinter &IP, SourcePrinter &SP,
+                                 RelocIterator &RelCur, RelocIterator RelEnd) {
+      SmallString<40> Comments;
+      raw_svector_ostream CommentStream(Comments);
+
+      OS << '\n';
       if (!NoLeadingAddr)
-        outs() << format("%016" PRIx64 " ",
+        OS << format("%016" PRIx64 " ",
                          SectionAddr + Start + VMAAdjustment);
 
       StringRef SymbolName = std::get<1>(Symbols[SI]);
       if (Demangle)
-        outs() << demangle(SymbolName) << ":\n";
+        OS << demangle(SymbolName) << ":\n";
       else
-        outs() << SymbolName << ":\n";
+        OS << SymbolName << ":\n";
 
       // Don't print raw contents of a virtual section. A virtual section
       // doesn't have any contents in the file.
       if (Section.isVirtual()) {
-        outs() << "...\n";
-        continue;
+        OS << "...\n";
+        return;
       }
 
 #ifndef NDEBUG
@@ -1213,11 +1324,12 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
 
       // Some targets (like WebAssembly) have a special prelude at the start
       // of each symbol.
-      DisAsm->onSymbolStart(SymbolName, Size, Bytes.slice(Start, End - Start),
+      uint64_t Size;
+      DisAsm.onSymbolStart(SymbolName, Size, Bytes.slice(Start, End - Start),
                             SectionAddr + Start, DebugOut, CommentStream);
       Start += Size;
 
-      Index = Start;
+      uint64_t Index = Start;
       if (SectionAddr < StartAddress)
         Index = std::max<uint64_t>(Index, StartAddress - SectionAddr);
 
@@ -1226,7 +1338,7 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
       // situation where we must print the data and not disassemble it.
       if (Obj->isELF() && std::get<2>(Symbols[SI]) == ELF::STT_OBJECT &&
           !DisassembleAll && Section.isText()) {
-        dumpELFData(SectionAddr, Index, End, Bytes);
+        dumpELFData(SectionAddr, Index, End, Bytes, OS);
         Index = End;
       }
 
@@ -1242,7 +1354,7 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
             std::binary_search(DataMappingSymsAddr.begin(),
                                DataMappingSymsAddr.end(), Index)) {
           Index = dumpARMELFData(SectionAddr, Index, End, Obj, Bytes,
-                                 TextMappingSymsAddr);
+                                 TextMappingSymsAddr, OS);
           continue;
         }
 
@@ -1257,7 +1369,7 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
 
           if (size_t N =
                   countSkippableZeroBytes(Bytes.slice(Index, MaxOffset))) {
-            outs() << "\t\t..." << '\n';
+            OS << "\t\t..." << '\n';
             Index += N;
             continue;
           }
@@ -1266,17 +1378,17 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
         // Disassemble a real instruction or a data when disassemble all is
         // provided
         MCInst Inst;
-        bool Disassembled = DisAsm->getInstruction(
+        bool Disassembled = DisAsm.getInstruction(
             Inst, Size, Bytes.slice(Index), SectionAddr + Index, DebugOut,
             CommentStream);
         if (Size == 0)
           Size = 1;
 
         PIP.printInst(
-            *IP, Disassembled ? &Inst : nullptr, Bytes.slice(Index, Size),
-            {SectionAddr + Index + VMAAdjustment, Section.getIndex()}, outs(),
+            IP, Disassembled ? &Inst : nullptr, Bytes.slice(Index, Size),
+            {SectionAddr + Index + VMAAdjustment, Section.getIndex()}, OS,
             "", *STI, &SP, &Rels);
-        outs() << CommentStream.str();
+        OS << CommentStream.str();
         Comments.clear();
 
         // Try to resolve the target of a call, tail call, etc. to a specific
@@ -1301,7 +1413,10 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
                   });
               if (It != SectionAddresses.begin()) {
                 --It;
-                TargetSectionSymbols = &AllSymbols[It->second];
+                auto SecSyms = AllSymbols.find(It->second);
+                TargetSectionSymbols = SecSyms != AllSymbols.end()
+                                           ? &SecSyms->second
+                                           : &AbsoluteSymbols;
               } else {
                 TargetSectionSymbols = &AbsoluteSymbols;
               }
@@ -1327,15 +1442,15 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
               --TargetSym;
               uint64_t TargetAddress = std::get<0>(*TargetSym);
               StringRef TargetName = std::get<1>(*TargetSym);
-              outs() << " <" << TargetName;
+              OS << " <" << TargetName;
               uint64_t Disp = Target - TargetAddress;
               if (Disp)
-                outs() << "+0x" << Twine::utohexstr(Disp);
-              outs() << '>';
+                OS << "+0x" << Twine::utohexstr(Disp);
+              OS << '>';
             }
           }
         }
-        outs() << "\n";
+        OS << "\n";
 
         // Hexagon does this in pretty printer
         if (Obj->getArch() != Triple::hexagon) {
@@ -1362,13 +1477,140 @@ static void disassembleObject(const Target *TheTarget, const ObjectFile *Obj,
             }
 
             printRelocation(*RelCur, SectionAddr + Offset,
-                            Obj->getBytesInAddress());
+                            Obj->getBytesInAddress(), OS);
             ++RelCur;
           }
         }
 
         Index += Size;
       }
+    };
+
+    auto DisassembleJob = [&](FunctionJob &Job, MCDisassembler &JobDisAsm,
+                              MCInstPrinter &JobIP) {
+      Job.Text.clear();
+      raw_string_ostream OS(Job.Text);
+      RelocIterator NoRel = Rels.end();
+      DisassembleSymbol(Job.SI, Job.Start, Job.End, OS, JobDisAsm, JobIP,
+                        *Job.SP, NoRel, NoRel);
+      OS.flush();
+    };
+
+    // Disassembles a job on a worker thread, with MC objects that no other
+    // thread uses at the same time.
+    auto DisassembleJobOnWorker = [&](FunctionJob &Job) {
+      std::unique_ptr<WorkerMCState> State;
+      {
+        std::lock_guard<std::mutex> Guard(WorkerStatesLock);
+        if (!FreeWorkerStates.empty()) {
+          State = std::move(FreeWorkerStates.back());
+          FreeWorkerStates.pop_back();
+        }
+      }
+      if (!State) {
+        State = llvm::make_unique<WorkerMCState>();
+        State->Ctx = llvm::make_unique<MCContext>(Ctx.getAsmInfo(),
+                                                  Ctx.getRegisterInfo(),
+                                                  Ctx.getObjectFileInfo());
+        State->DisAsm.reset(TheTarget->createMCDisassembler(*STI, *State->Ctx));
+        State->IP = createInstPrinter(TheTarget, Obj, *Ctx.getAsmInfo(), MII,
+                                      *Ctx.getRegisterInfo());
+      }
+      DisassembleJob(Job, *State->DisAsm, *State->IP);
+      std::lock_guard<std::mutex> Guard(WorkerStatesLock);
+      FreeWorkerStates.push_back(std::move(State));
+    };
+
+    std::vector<FunctionJob> Jobs;
+    // Disassemble symbol by symbol.
+    for (unsigned SI = 0, SE = Symbols.size(); SI != SE; ++SI) {
+      // Skip if --disassemble-functions is not empty and the symbol is not in
+      // the list.
+      if (!DisasmFuncsSet.empty() &&
+          !DisasmFuncsSet.count(std::get<1>(Symbols[SI])))
+        continue;
+
+      uint64_t Start = std::get<0>(Symbols[SI]);
+      if (Start < SectionAddr || StopAddress <= Start)
+        continue;
+
+      // The end is the section end, the beginning of the next symbol, or
+      // --stop-address.
+      uint64_t End = std::min<uint64_t>(SectionAddr + SectSize, StopAddress);
+      if (SI + 1 < SE)
+        End = std::min(End, std::get<0>(Symbols[SI + 1]));
+      if (Start >= End || End <= StartAddress)
+        continue;
+      Start -= SectionAddr;
+      End -= SectionAddr;
+
+      if (!PrintedSection) {
+        PrintedSection = true;
+        outs() << "\nDisassembly of section ";
+        if (!SegmentName.empty())
+          outs() << SegmentName << ",";
+        outs() << SectionName << ":\n";
+      }
+
+      if (Obj->isELF() && Obj->getArch() == Triple::amdgcn) {
+        if (std::get<2>(Symbols[SI]) == ELF::STT_AMDGPU_HSA_KERNEL) {
+          // skip amd_kernel_code_t at the begining of kernel symbol (256 bytes)
+          Start += 256;
+        }
+        if (SI == SE - 1 ||
+            std::get<2>(Symbols[SI + 1]) == ELF::STT_AMDGPU_HSA_KERNEL) {
+          // cut trailing zeroes at the end of kernel
+          // cut up to 256 bytes
+          const uint64_t EndAlign = 256;
+          const auto Limit = End - (std::min)(EndAlign, End - Start);
+          while (End > Limit &&
+            *reinterpret_cast<const support::ulittle32_t*>(&Bytes[End - 4]) == 0)
+            End -= 4;
+        }
+      }
+
+      if (Parallel) {
+        Jobs.push_back({SI, Start, End});
+        continue;
+      }
+      if (PrintSource || PrintLines)
+        SP.setFunctionLines(SP.lookUpLines(
+            {SectionAddr + Start + VMAAdjustment, Section.getIndex()},
+            End - Start));
+      DisassembleSymbol(SI, Start, End, outs(), *DisAsm, *IP, SP, RelCur,
+                        RelEnd);
+    }
+
+    // Disassemble the functions in windows of jobs, emitting each window in
+    // order before starting on the next one to bound the memory used.
+    for (size_t Begin = 0; Begin < Jobs.size(); Begin += ParallelWindow) {
+      size_t WindowEnd = std::min(Jobs.size(), Begin + ParallelWindow);
+      for (size_t I = Begin; I != WindowEnd; ++I) {
+        FunctionJob &Job = Jobs[I];
+        // The symbolizer is not thread-safe, look up the lines up front.
+        DILineInfoTable Lines;
+        if (PrintSource || PrintLines)
+          Lines = SP.lookUpLines(
+              {SectionAddr + Job.Start + VMAAdjustment, Section.getIndex()},
+              Job.End - Job.Start);
+        Job.SP = llvm::make_unique<SourcePrinter>(SP, std::move(Lines));
+        Pool->async([&, I] { DisassembleJobOnWorker(Jobs[I]); });
+      }
+      Pool->wait();
+
+      for (size_t I = Begin; I != WindowEnd; ++I) {
+        FunctionJob &Job = Jobs[I];
+        // Each job started without knowing the source line printed last. If
+        // that made a difference, redo it now that the line is known. The
+        // workers are idle, so the main thread's MC objects can be used.
+        if (Job.SP->dependsOnLineState(SP)) {
+          Job.SP->resetLineState(SP);
+          DisassembleJob(Job, *DisAsm, *IP);
+        }
+        SP.takeLineState(*Job.SP);
+        outs() << Job.Text;
+        Job = FunctionJob();
+      }
     }
   }
 }
@@ -1420,23 +1662,14 @@ static void disassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   std::unique_ptr<const MCInstrAnalysis> MIA(
       TheTarget->createMCInstrAnalysis(MII.get()));
 
-  int AsmPrinterVariant = AsmInfo->getAssemblerDialect();
-  std::unique_ptr<MCInstPrinter> IP(TheTarget->createMCInstPrinter(
-      Triple(TripleName), AsmPrinterVariant, *AsmInfo, *MII, *MRI));
-  if (!IP)
-    report_error(Obj->getFileName(),
-                 "no instruction printer for target " + TripleName);
-  IP->setPrintImmHex(PrintImmHex);
+  std::unique_ptr<MCInstPrinter> IP =
+      createInstPrinter(TheTarget, Obj, *AsmInfo, *MII, *MRI);
 
   PrettyPrinter &PIP = selectPrettyPrinter(Triple(TripleName));
   SourcePrinter SP(Obj, TheTarget->getName());
 
-  for (StringRef Opt : DisassemblerOptions)
-    if (!IP->applyTargetSpecificCLOption(Opt))
-      error("Unrecognized disassembler option: " + Opt);
-
   disassembleObject(TheTarget, Obj, Ctx, DisAsm.get(), MIA.get(), IP.get(),
-                    STI.get(), PIP, SP, InlineRelocs);
+                    STI.get(), *MII, PIP, SP, InlineRelocs);
 }
 
 void printRelocations(const ObjectFile *Obj) {
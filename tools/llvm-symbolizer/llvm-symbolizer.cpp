@@ -14,6 +14,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/DebugInfo/Symbolize/DIPrinter.h"
 #include "llvm/DebugInfo/Symbolize/Symbolize.h"
@@ -21,11 +23,19 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
+#include <deque>
+#include <mutex>
 #include <string>
 
 using namespace llvm;
@@ -82,6 +92,11 @@ static cl::opt<bool>
 ClNoDemangle("no-demangle", cl::init(false),
              cl::desc("Don't demangle function names"));
 
+static cl::opt<bool>
+    ClUseSymbolIndex("use-symbol-index", cl::init(true),
+                     cl::desc("Use the index written by llvm-symindex next to "
+                              "an object file when there is one"));
+
 static cl::opt<std::string> ClDefaultArch("default-arch", cl::init(""),
                                           cl::desc("Default architecture "
                                                    "(for multi-arch objects)"));
@@ -154,11 +169,27 @@ static cl::opt<DIPrinter::OutputStyle>
                              clEnumValN(DIPrinter::OutputStyle::GNU, "GNU",
                                         "GNU addr2line style")));
 
+static cl::opt<uint64_t> ClMaxCacheSize(
+    "max-cache-size", cl::init(0), cl::value_desc("bytes"),
+    cl::desc("Unload the least recently used object files once the mapped "
+             "files exceed this size, not counting parsed debug info "
+             "(0 = no limit)"));
+
+static cl::opt<bool>
+    ClServer("server", cl::init(false),
+             cl::desc("Answer requests of the form '<id> <input>' read from "
+                      "stdin until EOF, possibly out of order"));
+
+static cl::opt<unsigned> ClServerThreads(
+    "server-threads", cl::init(0),
+    cl::desc("Number of threads answering requests in -server mode "
+             "(0 = number of hardware threads)"));
+
 template<typename T>
-static bool error(Expected<T> &ResOrErr) {
+static bool error(Expected<T> &ResOrErr, raw_ostream &ErrOS) {
   if (ResOrErr)
     return false;
-  logAllUnhandledErrors(ResOrErr.takeError(), errs(),
+  logAllUnhandledErrors(ResOrErr.takeError(), ErrOS,
                         "LLVMSymbolizer: error reading file: ");
   return true;
 }
@@ -202,31 +233,32 @@ static bool parseCommand(StringRef InputString, bool &IsData,
 }
 
 static void symbolizeInput(StringRef InputString, LLVMSymbolizer &Symbolizer,
-                           DIPrinter &Printer) {
+                           DIPrinter &Printer, raw_ostream &OS,
+                           raw_ostream &ErrOS) {
   bool IsData = false;
   std::string ModuleName;
   uint64_t Offset = 0;
   if (!parseCommand(StringRef(InputString), IsData, ModuleName, Offset)) {
-    outs() << InputString;
+    OS << InputString;
     return;
   }
 
   if (ClPrintAddress) {
-    outs() << "0x";
-    outs().write_hex(Offset);
+    OS << "0x";
+    OS.write_hex(Offset);
     StringRef Delimiter = ClPrettyPrint ? ": " : "\n";
-    outs() << Delimiter;
+    OS << Delimiter;
   }
   Offset -= ClAdjustVMA;
   if (IsData) {
     auto ResOrErr = Symbolizer.symbolizeData(
         ModuleName, {Offset, object::SectionedAddress::UndefSection});
-    Printer << (error(ResOrErr) ? DIGlobal() : ResOrErr.get());
+    Printer << (error(ResOrErr, ErrOS) ? DIGlobal() : ResOrErr.get());
   } else if (ClPrintInlining) {
     auto ResOrErr = Symbolizer.symbolizeInlinedCode(
         ModuleName, {Offset, object::SectionedAddress::UndefSection},
         ClDwpName);
-    Printer << (error(ResOrErr) ? DIInliningInfo() : ResOrErr.get());
+    Printer << (error(ResOrErr, ErrOS) ? DIInliningInfo() : ResOrErr.get());
   } else if (ClOutputStyle == DIPrinter::OutputStyle::GNU) {
     // With ClPrintFunctions == FunctionNameKind::LinkageName (default)
     // and ClUseSymbolTable == true (also default), Symbolizer.symbolizeCode()
@@ -237,18 +269,208 @@ static void symbolizeInput(StringRef InputString, LLVMSymbolizer &Symbolizer,
     auto ResOrErr = Symbolizer.symbolizeInlinedCode(
         ModuleName, {Offset, object::SectionedAddress::UndefSection},
         ClDwpName);
-    Printer << (error(ResOrErr) ? DILineInfo() : ResOrErr.get().getFrame(0));
+    Printer << (error(ResOrErr, ErrOS) ? DILineInfo() : ResOrErr.get().getFrame(0));
   } else {
     auto ResOrErr = Symbolizer.symbolizeCode(
         ModuleName, {Offset, object::SectionedAddress::UndefSection},
         ClDwpName);
-    Printer << (error(ResOrErr) ? DILineInfo() : ResOrErr.get());
+    Printer << (error(ResOrErr, ErrOS) ? DILineInfo() : ResOrErr.get());
   }
   if (ClOutputStyle == DIPrinter::OutputStyle::LLVM)
-    outs() << "\n";
-  outs().flush();
+    OS << "\n";
+  OS.flush();
 }
 
+static DIPrinter createPrinter(raw_ostream &OS) {
+  return DIPrinter(OS, ClPrintFunctions != FunctionNameKind::None,
+                   ClPrettyPrint, ClPrintSourceContextLines, ClVerbose,
+                   ClBasenames, ClOutputStyle);
+}
+
+namespace {
+
+/// Request counts and a latency histogram of a symbolizer server.
+class ServerStats {
+public:
+  ServerStats() : Start(std::chrono::steady_clock::now()) {}
+
+  void addRequest(std::chrono::steady_clock::duration Latency) {
+    uint64_t Micros =
+        std::chrono::duration_cast<std::chrono::microseconds>(Latency).count();
+    std::lock_guard<std::mutex> Lock(Mutex);
+    ++NumRequests;
+    TotalMicros += Micros;
+    MaxMicros = std::max(MaxMicros, Micros);
+    ++Buckets[Log2_64_Ceil(Micros + 1)];
+  }
+
+  /// Prints the statistics as "<name>: <value>" lines and returns how many.
+  unsigned print(raw_ostream &OS) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    double Uptime = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - Start)
+                        .count();
+    OS << "requests: " << NumRequests << "\n";
+    OS << format("uptime-seconds: %.3f\n", Uptime);
+    OS << format("requests-per-second: %.1f\n",
+                 Uptime > 0 ? NumRequests / Uptime : 0.0);
+    OS << format("latency-us: mean %.1f p50 %llu p99 %llu max %llu\n",
+                 NumRequests ? double(TotalMicros) / NumRequests : 0.0,
+                 (unsigned long long)getPercentile(50),
+                 (unsigned long long)getPercentile(99),
+                 (unsigned long long)MaxMicros);
+    return 4;
+  }
+
+private:
+  /// Returns an upper bound for the latency of \p P percent of the requests.
+  uint64_t getPercentile(unsigned P) const {
+    uint64_t Seen = 0;
+    for (unsigned I = 0; I != array_lengthof(Buckets); ++I) {
+      Seen += Buckets[I];
+      if (I < 64 && Seen * 100 >= NumRequests * P)
+        return std::min(MaxMicros, (uint64_t(1) << I) - 1);
+    }
+    return MaxMicros;
+  }
+
+  std::mutex Mutex;
+  std::chrono::steady_clock::time_point Start;
+  uint64_t NumRequests = 0;
+  uint64_t TotalMicros = 0;
+  uint64_t MaxMicros = 0;
+  /// Bucket I counts the requests that took less than 2^I microseconds.
+  uint64_t Buckets[65] = {};
+};
+
+/// Answers symbolizer requests concurrently. Requests are distributed over
+/// shards by module name, and every shard symbolizes its requests in order
+/// with its own LLVMSymbolizer, so modules are loaded only once and never
+/// shared between threads.
+class SymbolizerServer {
+public:
+  SymbolizerServer(LLVMSymbolizer::Options Opts, unsigned NumThreads)
+      : Pool(NumThreads) {
+    if (Opts.MaxCacheSize)
+      Opts.MaxCacheSize = std::max<uint64_t>(1, Opts.MaxCacheSize / NumThreads);
+    for (unsigned I = 0; I != NumThreads; ++I)
+      Shards.push_back(llvm::make_unique<Shard>(Opts));
+  }
+
+  /// Answers the request \p Line, which is "<id> <input>" or "<id> STATUS".
+  void handle(StringRef Line) {
+    Line = Line.ltrim(" ");
+    size_t IdEnd = Line.find_first_of(" \r\n");
+    StringRef Id = Line.substr(0, IdEnd);
+    StringRef Input = Line.substr(IdEnd).ltrim(" ");
+    if (Id.empty())
+      return;
+    if (Input.rtrim("\r\n") == "STATUS") {
+      std::string Status;
+      raw_string_ostream OS(Status);
+      unsigned NumLines = Stats.print(OS) + printCacheStats(OS);
+      respond(Id, NumLines, OS.str(), "");
+      return;
+    }
+
+    bool IsData;
+    std::string ModuleName;
+    uint64_t Offset;
+    parseCommand(Input, IsData, ModuleName, Offset);
+    Shard &S = *Shards[hash_value(ModuleName) % Shards.size()];
+    if (Shards.size() == 1) {
+      process(S, Id, Input);
+      return;
+    }
+
+    std::lock_guard<std::mutex> Lock(S.QueueMutex);
+    S.Queue.emplace_back(Id, Input);
+    if (!S.Draining) {
+      S.Draining = true;
+      Pool.async([this, &S] { drain(S); });
+    }
+  }
+
+  void wait() { Pool.wait(); }
+
+private:
+  struct Shard {
+    explicit Shard(const LLVMSymbolizer::Options &Opts) : Symbolizer(Opts) {}
+
+    /// Guards Symbolizer.
+    std::mutex Mutex;
+    LLVMSymbolizer Symbolizer;
+    /// Guards Queue and Draining, which is set while a pool task is
+    /// answering the requests in Queue.
+    std::mutex QueueMutex;
+    std::deque<std::pair<std::string, std::string>> Queue;
+    bool Draining = false;
+  };
+
+  void drain(Shard &S) {
+    while (true) {
+      std::pair<std::string, std::string> Request;
+      {
+        std::lock_guard<std::mutex> Lock(S.QueueMutex);
+        if (S.Queue.empty()) {
+          S.Draining = false;
+          return;
+        }
+        Request = std::move(S.Queue.front());
+        S.Queue.pop_front();
+      }
+      process(S, Request.first, Request.second);
+    }
+  }
+
+  void process(Shard &S, StringRef Id, StringRef Input) {
+    std::string Result, Errors;
+    raw_string_ostream OS(Result), ErrOS(Errors);
+    auto Begin = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> Lock(S.Mutex);
+      DIPrinter Printer = createPrinter(OS);
+      symbolizeInput(Input, S.Symbolizer, Printer, OS, ErrOS);
+    }
+    Stats.addRequest(std::chrono::steady_clock::now() - Begin);
+    OS.flush();
+    if (!Result.empty() && Result.back() != '\n')
+      Result += '\n';
+    respond(Id, std::count(Result.begin(), Result.end(), '\n'), Result,
+            ErrOS.str());
+  }
+
+  unsigned printCacheStats(raw_ostream &OS) {
+    uint64_t NumModules = 0, CacheSize = 0, NumEvictions = 0;
+    for (auto &S : Shards) {
+      std::lock_guard<std::mutex> Lock(S->Mutex);
+      NumModules += S->Symbolizer.getNumLoadedModules();
+      CacheSize += S->Symbolizer.getCacheSize();
+      NumEvictions += S->Symbolizer.getNumEvictions();
+    }
+    OS << "modules: " << NumModules << "\n";
+    OS << "cache-bytes: " << CacheSize << "\n";
+    OS << "evictions: " << NumEvictions << "\n";
+    return 3;
+  }
+
+  /// Writes the \p NumLines lines of \p Result as the response to \p Id.
+  void respond(StringRef Id, size_t NumLines, StringRef Result,
+               StringRef Errors) {
+    std::lock_guard<std::mutex> Lock(OutputMutex);
+    errs() << Errors;
+    outs() << Id << ' ' << NumLines << '\n' << Result;
+    outs().flush();
+  }
+
+  ThreadPool Pool;
+  std::vector<std::unique_ptr<Shard>> Shards;
+  ServerStats Stats;
+  std::mutex OutputMutex;
+};
+
+} // end anonymous namespace
+
 int main(int argc, char **argv) {
   InitLLVM X(argc, argv);
 
@@ -272,6 +494,8 @@ int main(int argc, char **argv) {
   LLVMSymbolizer::Options Opts(ClPrintFunctions, ClUseSymbolTable, ClDemangle,
                                ClUseRelativeAddress, ClDefaultArch,
                                ClFallbackDebugPath);
+  Opts.UseSymbolIndex = ClUseSymbolIndex;
+  Opts.MaxCacheSize = ClMaxCacheSize;
 
   for (const auto &hint : ClDsymHint) {
     if (sys::path::extension(hint) == ".dSYM") {
@@ -281,21 +505,28 @@ int main(int argc, char **argv) {
                 "\" (must have the '.dSYM' extension).\n";
     }
   }
-  LLVMSymbolizer Symbolizer(Opts);
+  const int kMaxInputStringLength = 1024;
+  char InputString[kMaxInputStringLength];
 
-  DIPrinter Printer(outs(), ClPrintFunctions != FunctionNameKind::None,
-                    ClPrettyPrint, ClPrintSourceContextLines, ClVerbose,
-                    ClBasenames, ClOutputStyle);
+  if (ClServer) {
+    unsigned NumThreads =
+        ClServerThreads ? ClServerThreads : hardware_concurrency();
+    SymbolizerServer Server(Opts, NumThreads);
+    while (fgets(InputString, sizeof(InputString), stdin))
+      Server.handle(InputString);
+    Server.wait();
+    return 0;
+  }
 
-  if (ClInputAddresses.empty()) {
-    const int kMaxInputStringLength = 1024;
-    char InputString[kMaxInputStringLength];
+  LLVMSymbolizer Symbolizer(Opts);
+  DIPrinter Printer = createPrinter(outs());
 
+  if (ClInputAddresses.empty()) {
     while (fgets(InputString, sizeof(InputString), stdin))
-      symbolizeInput(InputString, Symbolizer, Printer);
+      symbolizeInput(InputString, Symbolizer, Printer, outs(), errs());
   } else {
     for (StringRef Address : ClInputAddresses)
-      symbolizeInput(Address, Symbolizer, Printer);
+      symbolizeInput(Address, Symbolizer, Printer, outs(), errs());
   }
 
   return 0;
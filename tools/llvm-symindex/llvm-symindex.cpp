@@ -0,0 +1,101 @@
+//===-- llvm-symindex.cpp - Write precomputed symbolizer indices ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This utility converts the symbol table and DWARF debug info of linked
+// binaries into compact indices that llvm-symbolizer maps and searches instead
+// of parsing the debug info again.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/Triple.h"
+#include "llvm/DebugInfo/Symbolize/SymbolIndex.h"
+#include "llvm/DebugInfo/Symbolize/Symbolize.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace symbolize;
+
+static cl::list<std::string> InputFilenames(cl::Positional, cl::OneOrMore,
+                                            cl::desc("<input files>"));
+
+static cl::opt<std::string>
+    OutputFilename("o", cl::init(""), cl::value_desc("filename"),
+                   cl::desc("Output file, only valid with one input. Defaults "
+                            "to <input>.symidx, where llvm-symbolizer looks "
+                            "for it"));
+
+static cl::opt<std::string> DefaultArch("default-arch", cl::init(""),
+                                        cl::desc("Default architecture "
+                                                 "(for multi-arch objects)"));
+
+static cl::opt<std::string>
+    DwpName("dwp", cl::init(""),
+            cl::desc("Path to DWP file to be use for any split CUs"));
+
+static cl::list<std::string>
+    DsymHints("dsym-hint", cl::ZeroOrMore,
+              cl::desc("Path to .dSYM bundles to search for debug info for "
+                       "the object files"));
+
+static cl::opt<std::string>
+    FallbackDebugPath("fallback-debug-path", cl::init(""),
+                      cl::desc("Fallback path for debug binaries"));
+
+static bool writeIndex(LLVMSymbolizer &Symbolizer, StringRef Input,
+                       StringRef Output) {
+  std::error_code EC;
+  ToolOutputFile Out(Output, EC, sys::fs::F_None);
+  if (EC) {
+    WithColor::error() << Output << ": " << EC.message() << "\n";
+    return false;
+  }
+  if (Error Err = Symbolizer.writeSymbolIndex(Input, Out.os(), DwpName)) {
+    WithColor::error() << toString(std::move(Err)) << "\n";
+    return false;
+  }
+  Out.keep();
+  return true;
+}
+
+int main(int argc, char **argv) {
+  InitLLVM X(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv, "llvm symbol index writer\n");
+
+  if (!OutputFilename.empty() && InputFilenames.size() != 1) {
+    WithColor::error() << "-o requires exactly one input file\n";
+    return 1;
+  }
+
+  LLVMSymbolizer::Options Opts;
+  Opts.DefaultArch = DefaultArch;
+  Opts.FallbackDebugPath = FallbackDebugPath;
+  for (const std::string &Hint : DsymHints)
+    Opts.DsymHints.push_back(Hint);
+
+  bool Success = true;
+  for (const std::string &Input : InputFilenames) {
+    // Each binary is only needed once, so don't keep it mapped.
+    LLVMSymbolizer Symbolizer(Opts);
+    std::string BinaryName = Input;
+    size_t ColonPos = Input.find_last_of(':');
+    if (ColonPos != std::string::npos &&
+        Triple(Input.substr(ColonPos + 1)).getArch() != Triple::UnknownArch)
+      BinaryName = Input.substr(0, ColonPos);
+    std::string Output = OutputFilename.empty()
+                             ? SymbolIndex::getDefaultPath(BinaryName)
+                             : OutputFilename;
+    Success &= writeIndex(Symbolizer, Input, Output);
+  }
+  return Success ? 0 : 1;
+}
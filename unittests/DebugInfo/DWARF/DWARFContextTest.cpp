@@ -0,0 +1,166 @@
+//===- DWARFContextTest.cpp -----------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "DwarfGenerator.h"
+#include "DwarfUtils.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFDie.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Testing/Support/Error.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace dwarf;
+using namespace utils;
+
+namespace {
+
+const unsigned NumCUs = 32;
+const uint64_t BaseAddress = 0x1000;
+const uint64_t CUSize = 0x100;
+
+/// Returns everything a symbolizer would look up for the code of compile
+/// unit \p I, so that the answers of a context queried from several threads
+/// can be compared to those of a context queried from one.
+std::string describeUnit(DWARFContext &DICtx, unsigned I) {
+  std::string Result;
+  raw_string_ostream OS(Result);
+
+  // Only extract the unit DIE, and keep it while the lookups below extract
+  // the other DIEs of the unit.
+  DWARFUnit *U = DICtx.getUnitAtIndex(I);
+  DWARFDie UnitDie = U->getUnitDIE();
+  OS << dwarf::toString(UnitDie.find(DW_AT_name), "") << '\n';
+
+  object::SectionedAddress Address = {BaseAddress + I * CUSize + 0x18,
+                                      object::SectionedAddress::UndefSection};
+  DILineInfoSpecifier Spec(
+      DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+      DILineInfoSpecifier::FunctionNameKind::ShortName);
+  DIInliningInfo Inlined = DICtx.getInliningInfoForAddress(Address, Spec);
+  for (uint32_t F = 0, E = Inlined.getNumberOfFrames(); F != E; ++F) {
+    const DILineInfo &Frame = Inlined.getFrame(F);
+    OS << Frame.FunctionName << ' ' << Frame.FileName << ':' << Frame.Line
+       << '\n';
+  }
+  DILineInfo Line = DICtx.getLineInfoForAddress(Address, Spec);
+  OS << Line.FunctionName << ' ' << Line.FileName << ':' << Line.Line << '\n';
+
+  DWARFDie Subprogram = U->getUnitDIE(false).getFirstChild();
+  for (DWARFDie Child : Subprogram.children())
+    if (DWARFDie Origin =
+            Child.getAttributeValueAsReferencedDie(DW_AT_abstract_origin))
+      OS << Origin.getName(DINameKind::ShortName) << ' '
+         << Origin.getDwarfUnit()->getOffset() << '\n';
+
+  OS << dwarf::toString(UnitDie.find(DW_AT_name), "") << '\n';
+  return OS.str();
+}
+
+TEST(DWARFContext, ConcurrentLazyParsing) {
+  Triple Triple = getHostTripleForAddrSize(8);
+  if (!isConfigurationSupported(Triple))
+    return;
+
+  auto ExpectedDG = dwarfgen::Generator::create(Triple, 4);
+  ASSERT_THAT_EXPECTED(ExpectedDG, Succeeded());
+  dwarfgen::Generator *DG = ExpectedDG.get().get();
+
+  // Every unit has a subprogram that inlines the subprogram of the next unit,
+  // so that the lookups follow references into other units.
+  std::vector<dwarfgen::DIE> Subprograms;
+  std::vector<dwarfgen::DIE> InlinedSubroutines;
+  for (unsigned I = 0; I != NumCUs; ++I) {
+    uint64_t LowPC = BaseAddress + I * CUSize;
+    dwarfgen::DIE CUDie = DG->addCompileUnit().getUnitDIE();
+    CUDie.addAttribute(DW_AT_name, DW_FORM_strp, "cu" + std::to_string(I));
+    CUDie.addAttribute(DW_AT_stmt_list, DW_FORM_sec_offset, 0);
+    CUDie.addAttribute(DW_AT_low_pc, DW_FORM_addr, LowPC);
+    CUDie.addAttribute(DW_AT_high_pc, DW_FORM_addr, LowPC + CUSize);
+
+    dwarfgen::DIE Subprogram = CUDie.addChild(DW_TAG_subprogram);
+    Subprogram.addAttribute(DW_AT_name, DW_FORM_strp,
+                            "f" + std::to_string(I));
+    Subprogram.addAttribute(DW_AT_low_pc, DW_FORM_addr, LowPC);
+    Subprogram.addAttribute(DW_AT_high_pc, DW_FORM_addr, LowPC + CUSize);
+    Subprograms.push_back(Subprogram);
+
+    dwarfgen::DIE Inlined = Subprogram.addChild(DW_TAG_inlined_subroutine);
+    Inlined.addAttribute(DW_AT_low_pc, DW_FORM_addr, LowPC + 0x10);
+    Inlined.addAttribute(DW_AT_high_pc, DW_FORM_addr, LowPC + 0x20);
+    Inlined.addAttribute(DW_AT_call_file, DW_FORM_data1, 1);
+    Inlined.addAttribute(DW_AT_call_line, DW_FORM_data1, 100 + I);
+    InlinedSubroutines.push_back(Inlined);
+  }
+  for (unsigned I = 0; I != NumCUs; ++I)
+    InlinedSubroutines[I].addAttribute(DW_AT_abstract_origin, DW_FORM_ref_addr,
+                                       Subprograms[(I + 1) % NumCUs]);
+
+  // All units share a line table with one row per unit.
+  dwarfgen::LineTable &LT = DG->addLineTable();
+  LT.addExtendedOpcode(9, DW_LNE_set_address,
+                       {{BaseAddress, dwarfgen::LineTable::Quad}});
+  for (unsigned I = 0; I != NumCUs; ++I) {
+    LT.addStandardOpcode(DW_LNS_copy, {});
+    LT.addStandardOpcode(DW_LNS_advance_pc,
+                         {{CUSize, dwarfgen::LineTable::ULEB}});
+    LT.addStandardOpcode(DW_LNS_advance_line,
+                         {{1, dwarfgen::LineTable::SLEB}});
+  }
+  LT.addExtendedOpcode(1, DW_LNE_end_sequence, {});
+
+  StringRef FileBytes = DG->generate();
+  MemoryBufferRef FileBuffer(FileBytes, "dwarf");
+  auto Obj = object::ObjectFile::createObjectFile(FileBuffer);
+  ASSERT_TRUE((bool)Obj);
+
+  std::unique_ptr<DWARFContext> SerialCtx = DWARFContext::create(**Obj);
+  ASSERT_EQ(SerialCtx->getNumCompileUnits(), NumCUs);
+  std::vector<std::string> Expected;
+  for (unsigned I = 0; I != NumCUs; ++I)
+    Expected.push_back(describeUnit(*SerialCtx, I));
+  // Check that the lookups actually go through the inlined subroutines and
+  // the line table.
+  EXPECT_EQ(Expected[1], "cu1\n"
+                         "f2 a file:2\n"
+                         "f1 a file:101\n"
+                         "f2 a file:2\n"
+                         "f2 " +
+                             std::to_string(SerialCtx->getUnitAtIndex(2)
+                                                ->getOffset()) +
+                             "\ncu1\n");
+
+  // Query a fresh context for each unit several times over, so that threads
+  // race on parsing the same sections and extracting the same units.
+  const unsigned NumRounds = 4;
+  for (unsigned Iteration = 0; Iteration != 8; ++Iteration) {
+    std::unique_ptr<DWARFContext> DICtx = DWARFContext::create(**Obj);
+    std::vector<std::string> Results(NumRounds * NumCUs);
+    {
+      ThreadPool Pool(8);
+      for (unsigned Round = 0; Round != NumRounds; ++Round)
+        for (unsigned I = 0; I != NumCUs; ++I) {
+          std::string *Result = &Results[Round * NumCUs + I];
+          DWARFContext *Ctx = DICtx.get();
+          Pool.async([=] { *Result = describeUnit(*Ctx, I); });
+        }
+      Pool.wait();
+    }
+    for (unsigned Round = 0; Round != NumRounds; ++Round)
+      for (unsigned I = 0; I != NumCUs; ++I)
+        EXPECT_EQ(Results[Round * NumCUs + I], Expected[I]);
+  }
+}
+
+} // end anonymous namespace
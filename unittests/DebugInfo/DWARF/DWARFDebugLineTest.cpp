@@ -663,4 +663,50 @@ TEST_F(DebugLineBasicFixture, ParserIgnoresNonPrologueErrorsWhenSkipping) {
   EXPECT_FALSE(Unrecoverable);
 }
 
+TEST(DWARFDebugLineTable, LookupAddressRangeOutsideSequences) {
+  // Two sequences, [0x10, 0x20) and [0x30, 0x40), with a gap between them.
+  DWARFDebugLine::LineTable LT;
+  auto AddSequence = [&](ArrayRef<std::pair<uint64_t, uint32_t>> Lines,
+                         uint64_t HighPC) {
+    DWARFDebugLine::Sequence Seq;
+    Seq.FirstRowIndex = LT.Rows.size();
+    Seq.LowPC = Lines.front().first;
+    Seq.HighPC = HighPC;
+    for (auto &Line : Lines) {
+      DWARFDebugLine::Row Row;
+      Row.Address.Address = Line.first;
+      Row.Line = Line.second;
+      LT.appendRow(Row);
+    }
+    DWARFDebugLine::Row End;
+    End.Address.Address = HighPC;
+    End.EndSequence = true;
+    LT.appendRow(End);
+    Seq.LastRowIndex = LT.Rows.size();
+    Seq.Empty = false;
+    LT.appendSequence(Seq);
+  };
+  AddSequence({{0x10, 1}, {0x18, 2}}, 0x20);
+  AddSequence({{0x30, 3}}, 0x40);
+
+  auto Lookup = [&](uint64_t Address, uint64_t Size) {
+    std::vector<uint32_t> Rows;
+    if (!LT.lookupAddressRange({Address, SectionedAddress::UndefSection},
+                               Size, Rows))
+      return std::vector<uint32_t>{~0U};
+    return Rows;
+  };
+
+  // Ranges that start inside of a sequence. The end_sequence rows are not
+  // part of the result, so the gap is not given a line.
+  EXPECT_EQ(Lookup(0x10, 0x10), (std::vector<uint32_t>{0, 1}));
+  EXPECT_EQ(Lookup(0x14, 0x20), (std::vector<uint32_t>{0, 1, 3}));
+  // Ranges that start before the first sequence or in the gap.
+  EXPECT_EQ(Lookup(0x0, 0x40), (std::vector<uint32_t>{0, 1, 3}));
+  EXPECT_EQ(Lookup(0x20, 0x18), (std::vector<uint32_t>{3}));
+  // Ranges that do not overlap any sequence.
+  EXPECT_EQ(Lookup(0x20, 0x10), (std::vector<uint32_t>{~0U}));
+  EXPECT_EQ(Lookup(0x40, 0x10), (std::vector<uint32_t>{~0U}));
+}
+
 } // end anonymous namespace
@@ -9,8 +9,12 @@
 #include "llvm/MC/StringTableBuilder.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/MathExtras.h"
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <map>
 #include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -103,4 +107,69 @@ TEST(StringTableBuilderTest, ELFInOrder) {
   EXPECT_EQ(9U, B.getOffset("foobar"));
 }
 
+// Lay out Strings the way StringTableBuilder::finalize() is specified to:
+// ordered by their reversed contents, greatest first, with each string that is
+// a suffix of the last one placed sharing its bytes if the alignment allows.
+static std::vector<size_t> expectedOffsets(std::vector<std::string> Strings,
+                                           size_t Size, unsigned Alignment,
+                                           size_t &TableSize) {
+  std::vector<std::string> Sorted = Strings;
+  std::sort(Sorted.begin(), Sorted.end(),
+            [](const std::string &A, const std::string &B) {
+              return std::lexicographical_compare(B.rbegin(), B.rend(),
+                                                  A.rbegin(), A.rend());
+            });
+  std::map<std::string, size_t> Offsets;
+  StringRef Previous;
+  for (const std::string &S : Sorted) {
+    if (Previous.endswith(S)) {
+      size_t Pos = Size - S.size() - 1;
+      if (!(Pos & (Alignment - 1))) {
+        Offsets[S] = Pos;
+        continue;
+      }
+    }
+    Size = alignTo(Size, Alignment);
+    Offsets[S] = Size;
+    Size += S.size() + 1;
+    Previous = S;
+  }
+  TableSize = Size;
+  std::vector<size_t> Result;
+  for (const std::string &S : Strings)
+    Result.push_back(Offsets[S]);
+  return Result;
+}
+
+// Large tables are sorted on multiple threads, which must not change the
+// layout. Use many strings with long shared suffixes, like mangled names.
+TEST(StringTableBuilderTest, LargeTable) {
+  std::vector<std::string> Strings;
+  const char *Suffixes[] = {"Ev", "EPKcm", "_ZN4llvm", "", "v"};
+  for (unsigned I = 0; I != 100000; ++I) {
+    std::string S = "_ZN4llvm" + std::to_string(I * 7919 % 100003);
+    S += Suffixes[I % 5];
+    Strings.push_back(S);
+    // Some strings are suffixes of others.
+    if (I % 3 == 0)
+      Strings.push_back(S.substr(S.size() / 2));
+  }
+  std::sort(Strings.begin(), Strings.end());
+  Strings.erase(std::unique(Strings.begin(), Strings.end()), Strings.end());
+
+  for (unsigned Alignment : {1u, 4u}) {
+    StringTableBuilder B(StringTableBuilder::ELF, Alignment);
+    for (const std::string &S : Strings)
+      B.add(S);
+    B.finalize();
+
+    size_t ExpectedSize;
+    std::vector<size_t> Expected =
+        expectedOffsets(Strings, 1, Alignment, ExpectedSize);
+    EXPECT_EQ(ExpectedSize, B.getSize());
+    for (size_t I = 0, E = Strings.size(); I != E; ++I)
+      ASSERT_EQ(Expected[I], B.getOffset(Strings[I])) << Strings[I];
+  }
+}
+
 }
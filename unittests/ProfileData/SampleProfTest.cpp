@@ -323,6 +323,84 @@ TEST_F(SampleProfTest, sample_overflow_saturation) {
   ASSERT_EQ(BodySamples.get(), Max);
 }
 
+TEST_F(SampleProfTest, context_sensitive_text_profile) {
+  StringRef Profile = "[main:3 @ _Z3fooi:5.1 @ _Z3bari]:300:30\n"
+                      " 1: 300\n"
+                      "[_Z3bazv:2 @ _Z3bari]:20:2\n"
+                      " 1: 20\n"
+                      "_Z3bari:100:10\n"
+                      " 1: 100\n"
+                      "main:1000:1\n"
+                      " 3: 1000\n";
+  std::unique_ptr<MemoryBuffer> Buffer =
+      MemoryBuffer::getMemBuffer(Profile, "profile", false);
+  auto ReaderOrErr = SampleProfileReader::create(Buffer, Context);
+  ASSERT_TRUE(NoError(ReaderOrErr.getError()));
+  Reader = std::move(ReaderOrErr.get());
+  ASSERT_TRUE(NoError(Reader->read()));
+  ASSERT_TRUE(Reader->profileIsCS());
+
+  FunctionSamples *ContextSamples =
+      Reader->getSamplesFor("[main:3 @ _Z3fooi:5.1 @ _Z3bari]");
+  ASSERT_TRUE(ContextSamples != nullptr);
+  ASSERT_EQ("_Z3bari", ContextSamples->getName());
+  ASSERT_EQ("main:3 @ _Z3fooi:5.1 @ _Z3bari", ContextSamples->getContext());
+
+  // Context profiles survive a text round trip but have no binary encoding.
+  std::string Text;
+  {
+    std::unique_ptr<raw_ostream> OS(new raw_string_ostream(Text));
+    auto WriterOrErr = SampleProfileWriter::create(OS, SPF_Text);
+    ASSERT_TRUE(NoError(WriterOrErr.getError()));
+    ASSERT_TRUE(NoError(WriterOrErr.get()->write(Reader->getProfiles())));
+  }
+  ASSERT_NE(std::string::npos,
+            Text.find("[main:3 @ _Z3fooi:5.1 @ _Z3bari]:300:30\n"));
+
+  std::string Binary;
+  {
+    std::unique_ptr<raw_ostream> OS(new raw_string_ostream(Binary));
+    auto WriterOrErr = SampleProfileWriter::create(OS, SPF_Binary);
+    ASSERT_TRUE(NoError(WriterOrErr.getError()));
+    ASSERT_EQ(make_error_code(sampleprof_error::unsupported_writing_format),
+              WriterOrErr.get()->write(Reader->getProfiles()));
+  }
+
+  ASSERT_TRUE(NoError(Reader->nestContextProfiles()));
+  ASSERT_FALSE(Reader->profileIsCS());
+  ASSERT_EQ(nullptr,
+            Reader->getSamplesFor("[main:3 @ _Z3fooi:5.1 @ _Z3bari]"));
+
+  // The context is inlined into its outermost caller.
+  FunctionSamples *MainSamples = Reader->getSamplesFor("main");
+  ASSERT_TRUE(MainSamples != nullptr);
+  ASSERT_EQ(1300u, MainSamples->getTotalSamples());
+  ASSERT_EQ(1u, MainSamples->getHeadSamples());
+  const FunctionSamples *FooSamples =
+      MainSamples->findFunctionSamplesAt(LineLocation(3, 0), "_Z3fooi");
+  ASSERT_TRUE(FooSamples != nullptr);
+  ASSERT_EQ(300u, FooSamples->getTotalSamples());
+  const FunctionSamples *BarSamples =
+      FooSamples->findFunctionSamplesAt(LineLocation(5, 1), "_Z3bari");
+  ASSERT_TRUE(BarSamples != nullptr);
+  ASSERT_FALSE(BarSamples->hasContext());
+  ASSERT_EQ(300u, BarSamples->getTotalSamples());
+  ASSERT_EQ(30u, BarSamples->getHeadSamples());
+
+  // _Z3bazv has no profile, so no caller profile is made up for it. Its
+  // context goes to the base profile, which does not count the nested
+  // context a second time.
+  ASSERT_EQ(nullptr, Reader->getSamplesFor("_Z3bazv"));
+  FunctionSamples *BaseSamples = Reader->getSamplesFor("_Z3bari");
+  ASSERT_TRUE(BaseSamples != nullptr);
+  ASSERT_FALSE(BaseSamples->hasContext());
+  ASSERT_EQ(120u, BaseSamples->getTotalSamples());
+  ASSERT_EQ(12u, BaseSamples->getHeadSamples());
+  ErrorOr<uint64_t> BodySamples = BaseSamples->findSamplesAt(1, 0);
+  ASSERT_FALSE(BodySamples.getError());
+  ASSERT_EQ(120u, BodySamples.get());
+}
+
 TEST_F(SampleProfTest, default_suffix_elision_text) {
   // Default suffix elision policy: strip everything after first dot.
   // This implies that all suffix variants will map to "foo", so
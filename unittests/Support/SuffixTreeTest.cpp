@@ -0,0 +1,142 @@
+//===- llvm/unittest/Support/SuffixTreeTest.cpp - SuffixTree tests --------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/SuffixTree.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <map>
+#include <random>
+
+using namespace llvm;
+
+namespace {
+
+typedef std::map<std::vector<unsigned>, std::vector<unsigned>> SubstringMap;
+
+/// Collect the repeated substrings reported by \p ST, keyed by their contents.
+SubstringMap collect(const SuffixTree &ST) {
+  SubstringMap Result;
+  for (auto It = ST.begin(), Et = ST.end(); It != Et; ++It) {
+    SuffixTree::RepeatedSubstring &RS = *It;
+    EXPECT_GE(RS.StartIndices.size(), 2u);
+    unsigned Start = RS.StartIndices.front();
+    std::vector<unsigned> Key(ST.Str.begin() + Start,
+                              ST.Str.begin() + Start + RS.Length);
+    std::vector<unsigned> Starts = RS.StartIndices;
+    std::sort(Starts.begin(), Starts.end());
+    EXPECT_TRUE(Result.emplace(Key, Starts).second);
+  }
+  return Result;
+}
+
+/// Compute what the suffix tree of \p Str should report by brute force.
+SubstringMap bruteForce(ArrayRef<unsigned> Str, bool LeafDescendants) {
+  SubstringMap Result;
+  for (unsigned Len = 2; Len < Str.size(); ++Len) {
+    std::map<std::vector<unsigned>, std::vector<unsigned>> Occurrences;
+    for (unsigned I = 0; I + Len <= Str.size(); ++I)
+      Occurrences[std::vector<unsigned>(Str.begin() + I,
+                                        Str.begin() + I + Len)]
+          .push_back(I);
+    for (auto &Entry : Occurrences) {
+      const std::vector<unsigned> &Starts = Entry.second;
+      if (Starts.size() < 2)
+        continue;
+      // Count the characters following each occurrence. A string is an
+      // internal node of the tree iff not every occurrence is followed by the
+      // same character.
+      std::map<unsigned, unsigned> Next;
+      for (unsigned I : Starts)
+        ++Next[I + Len < Str.size() ? Str[I + Len] : -1u];
+      if (Next.size() < 2)
+        continue;
+      std::vector<unsigned> Reported;
+      for (unsigned I : Starts) {
+        unsigned C = I + Len < Str.size() ? Str[I + Len] : -1u;
+        // Without leaf descendants, only occurrences whose suffix leaves the
+        // node straight into a leaf are reported.
+        if (LeafDescendants || Next[C] == 1)
+          Reported.push_back(I);
+      }
+      if (Reported.size() >= 2)
+        Result.emplace(Entry.first, Reported);
+    }
+  }
+  return Result;
+}
+
+TEST(SuffixTreeTest, TestSingleRepetition) {
+  std::vector<unsigned> SimpleRepetitionData = {1, 2, 1, 2, 3};
+  SuffixTree ST(SimpleRepetitionData);
+  SubstringMap SubStrings = collect(ST);
+  ASSERT_EQ(SubStrings.size(), 1u);
+  std::vector<unsigned> Expected = {0, 2};
+  EXPECT_EQ(SubStrings[std::vector<unsigned>({1, 2})], Expected);
+}
+
+TEST(SuffixTreeTest, TestNoRepetition) {
+  std::vector<unsigned> NoRepetitionData = {1, 2, 3, 4, 5};
+  SuffixTree ST(NoRepetitionData);
+  EXPECT_TRUE(ST.begin() == ST.end());
+  // The root and one leaf per suffix.
+  EXPECT_EQ(ST.getNumNodes(), 6u);
+}
+
+TEST(SuffixTreeTest, TestEmptyString) {
+  std::vector<unsigned> Empty;
+  SuffixTree ST(Empty);
+  EXPECT_TRUE(ST.begin() == ST.end());
+}
+
+// "1 2 3" occurs three times, but only the occurrence followed by 4 ends at a
+// leaf child of its node; the other two are prefixes of "1 2 3 1 2 3".
+TEST(SuffixTreeTest, TestLeafDescendants) {
+  std::vector<unsigned> Data = {1, 2, 3, 1, 2, 3, 1, 2, 3, 4};
+  SuffixTree Children(Data);
+  SuffixTree Descendants(Data, /*OutlinerLeafDescendants=*/true);
+  SubstringMap ChildMap = collect(Children);
+  SubstringMap DescendantMap = collect(Descendants);
+  std::vector<unsigned> Key = {1, 2, 3};
+  EXPECT_EQ(ChildMap.count(Key), 0u);
+  std::vector<unsigned> Expected = {0, 3, 6};
+  EXPECT_EQ(DescendantMap[Key], Expected);
+}
+
+TEST(SuffixTreeTest, TestAgainstBruteForce) {
+  std::mt19937 Gen(0);
+  for (unsigned Alphabet : {2u, 3u, 8u}) {
+    for (unsigned Iter = 0; Iter < 20; ++Iter) {
+      std::uniform_int_distribution<unsigned> Dist(0, Alphabet - 1);
+      std::vector<unsigned> Str(100);
+      for (unsigned &C : Str)
+        C = Dist(Gen);
+      // Like the outliner's instruction mapping, end with a unique character.
+      Str.push_back(Alphabet);
+      for (bool LeafDescendants : {false, true}) {
+        SuffixTree ST(Str, LeafDescendants);
+        EXPECT_EQ(collect(ST), bruteForce(Str, LeafDescendants));
+      }
+    }
+  }
+}
+
+// A long run of one character makes the tree as deep as the string is long.
+// Construction and traversal must not recurse on the depth of the tree.
+TEST(SuffixTreeTest, TestDeepTree) {
+  const unsigned Len = 200000;
+  std::vector<unsigned> Str(Len, 1);
+  Str.push_back(2);
+  SuffixTree ST(Str);
+  SubstringMap SubStrings = collect(ST);
+  ASSERT_EQ(SubStrings.size(), 1u);
+  EXPECT_EQ(SubStrings.begin()->first.size(), Len - 1);
+  std::vector<unsigned> Expected = {0, 1};
+  EXPECT_EQ(SubStrings.begin()->second, Expected);
+}
+
+} // namespace